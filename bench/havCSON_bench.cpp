@@ -0,0 +1,365 @@
+// Standalone throughput benchmark for havCSON. No dependencies besides the header:
+//
+//   g++ -std=c++23 -O2 -DNDEBUG -I .. havCSON_bench.cpp -o havCSON_bench
+//   ./havCSON_bench [filter]
+//
+// Each corpus is generated deterministically, then Parse (plain, with ParseOptions::trustedInput, with
+// ParseOptions::iterative and ParseInPlace into the previous result), ParseLossless, LazyDocument (index + one Get),
+// TapeDocument, ToString, ToStringLossless (reformatted and with WriteOptions::keepSourceText after touching one
+// member) and ToJsonString (compact and pretty-printed) are timed on it. Throughput is reported in MB/s of CSON / JSON
+// text (parse: input, write: output) and heap allocations are counted per document through the global operator new
+// below.
+
+#include "havCSON.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace
+{
+  std::atomic<std::size_t> gAllocations{0};
+}
+
+// Replaced global allocation functions; GCC can't see that these new / delete pairs match
+#if defined(__GNUC__) && !defined(__clang__)
+  #pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size)
+{
+  gAllocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* pointer = std::malloc(size ? size : 1))
+  {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+  std::free(pointer);
+}
+
+namespace
+{
+  // Small deterministic generator so corpora are identical between runs / machines
+  struct Random
+  {
+    std::uint64_t state = 0x9E3779B97F4A7C15ull;
+
+    std::uint32_t Next()
+    {
+      state = state * 6364136223846793005ull + 1442695040888963407ull;
+      return static_cast<std::uint32_t>(state >> 33);
+    }
+
+    std::uint32_t Below(std::uint32_t bound)
+    {
+      return Next() % bound;
+    }
+  };
+
+  std::string Indent(int level)
+  {
+    return std::string(static_cast<std::size_t>(level) * 2, ' ');
+  }
+
+  std::string Key(Random& random)
+  {
+    static const char* const names[] = {"name", "value", "id", "enabled", "path", "count", "limit", "mode", "owner", "tags"};
+    return std::string(names[random.Below(10)]) + "_" + std::to_string(random.Below(100000));
+  }
+
+  std::string Scalar(Random& random)
+  {
+    switch (random.Below(4))
+    {
+      case 0: return std::to_string(random.Below(1000000));
+      case 1: return std::to_string(random.Below(100000)) + "." + std::to_string(random.Below(1000));
+      case 2: return random.Below(2) ? "true" : "false";
+      default: return "\"text " + std::to_string(random.Below(1000)) + "\"";
+    }
+  }
+
+  // Nested indent-style objects, 24 levels deep
+  std::string DeepObjects()
+  {
+    Random random;
+    std::string out;
+    for (int block = 0; block < 400; ++block)
+    {
+      out += "block_" + std::to_string(block) + ":\n";
+      for (int level = 1; level <= 24; ++level)
+      {
+        out += Indent(level) + Key(random) + ": " + Scalar(random) + "\n";
+        out += Indent(level) + "child:\n";
+      }
+      out += Indent(25) + "leaf: " + Scalar(random) + "\n";
+    }
+    return out;
+  }
+
+  // One flat object with many members
+  std::string WideObject()
+  {
+    Random random;
+    std::string out;
+    for (int index = 0; index < 50000; ++index)
+    {
+      out += Key(random) + "_" + std::to_string(index) + ": " + Scalar(random) + "\n";
+    }
+    return out;
+  }
+
+  // Long numeric arrays, inline and one element per line
+  std::string NumericArrays()
+  {
+    Random random;
+    std::string out;
+    for (int row = 0; row < 200; ++row)
+    {
+      out += "series_" + std::to_string(row) + ": [";
+      for (int index = 0; index < 500; ++index)
+      {
+        if (index > 0)
+        {
+          out += ", ";
+        }
+        out += random.Below(3) ? std::to_string(random.Below(1000000))
+                               : "-" + std::to_string(random.Below(1000)) + "." + std::to_string(random.Below(100000)) + "e-3";
+      }
+      out += "]\n";
+    }
+    out += "samples: [\n";
+    for (int index = 0; index < 20000; ++index)
+    {
+      out += "  " + std::to_string(random.Below(1000)) + "." + std::to_string(random.Below(1000)) + "\n";
+    }
+    out += "]\n";
+    return out;
+  }
+
+  // Quoted strings with escapes plus plain strings
+  std::string EscapedStrings()
+  {
+    Random random;
+    static const char* const pieces[] = {"plain words ", "quote \\\" ", "slash \\\\ ", "tab\\t", "newline\\n", "caf\\u00e9 ", "unicode \xC3\xA9 "};
+    std::string out;
+    for (int index = 0; index < 20000; ++index)
+    {
+      out += "s_" + std::to_string(index) + ": \"";
+      for (std::uint32_t piece = 0, count = 2 + random.Below(6); piece < count; ++piece)
+      {
+        out += pieces[random.Below(7)];
+      }
+      out += "\"\n";
+      out += "q_" + std::to_string(index) + ": 'single quoted " + std::to_string(random.Below(1000)) + "'\n";
+    }
+    return out;
+  }
+
+  // Multi-line triple-quoted strings
+  std::string TripleStrings()
+  {
+    Random random;
+    std::string out;
+    for (int index = 0; index < 3000; ++index)
+    {
+      out += "doc_" + std::to_string(index) + ": \"\"\"\n";
+      for (std::uint32_t line = 0, count = 3 + random.Below(10); line < count; ++line)
+      {
+        out += "  Lorem ipsum dolor sit amet, line " + std::to_string(line) + " of block " + std::to_string(index) + "\n";
+      }
+      out += "\"\"\"\n";
+    }
+    return out;
+  }
+
+  // Comments and blank lines between most members
+  std::string CommentDense()
+  {
+    Random random;
+    std::string out;
+    for (int section = 0; section < 500; ++section)
+    {
+      out += "# ------------------------------------------------------------\n";
+      out += "# Section " + std::to_string(section) + ": generated settings\n";
+      out += "section_" + std::to_string(section) + ":\n";
+      for (int index = 0; index < 20; ++index)
+      {
+        if (random.Below(2))
+        {
+          out += "\n  # " + Key(random) + " explains the next value\n";
+        }
+        out += "  " + Key(random) + "_" + std::to_string(index) + ": " + Scalar(random) + " # trailing note\n";
+      }
+    }
+    return out;
+  }
+
+  struct Result
+  {
+    double megabytesPerSecond = 0.0;
+    double allocationsPerRun = 0.0;
+  };
+
+  // Run body repeatedly for ~0.3 s (at least 3 runs) and report throughput over bytes per run
+  Result Measure(std::size_t bytes, const std::function<void()>& body)
+  {
+    using Clock = std::chrono::steady_clock;
+    body(); // Warm-up
+
+    std::size_t runs = 0;
+    std::size_t allocations = gAllocations.load(std::memory_order_relaxed);
+    const auto start = Clock::now();
+    auto elapsed = Clock::duration::zero();
+    while (runs < 3 || elapsed < std::chrono::milliseconds(300))
+    {
+      body();
+      ++runs;
+      elapsed = Clock::now() - start;
+    }
+    allocations = gAllocations.load(std::memory_order_relaxed) - allocations;
+
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    Result result;
+    result.megabytesPerSecond = static_cast<double>(bytes) * static_cast<double>(runs) / seconds / (1024.0 * 1024.0);
+    result.allocationsPerRun = static_cast<double>(allocations) / static_cast<double>(runs);
+    return result;
+  }
+
+  void Report(const char* corpus, const char* operation, std::size_t bytes, const Result& result)
+  {
+    std::printf(
+      "%-16s %-18s %10.2f KB %10.1f MB/s %12.0f allocs/doc\n",
+      corpus,
+      operation,
+      static_cast<double>(bytes) / 1024.0,
+      result.megabytesPerSecond,
+      result.allocationsPerRun);
+  }
+
+  // Volatile sink so the optimizer keeps the measured work
+  volatile std::size_t gSink = 0;
+
+  bool Run(const char* name, const std::string& source)
+  {
+    using namespace havCSON;
+
+    Value value;
+    LosslessValue lossless;
+    Error error;
+    if (Parse(source, value, &error) != ErrorCode::OK || ParseLossless(source, lossless, &error) != ErrorCode::OK)
+    {
+      std::fprintf(stderr, "%s: corpus does not parse (line %zu col %zu: %s)\n", name, error.where.line, error.where.column, error.message.c_str());
+      return false;
+    }
+
+    Report(name, "Parse", source.size(), Measure(source.size(), [&] {
+             Value parsed;
+             Parse(source, parsed);
+             gSink = gSink + parsed.isObject();
+           }));
+    ParseOptions trusted;
+    trusted.trustedInput = true;
+    Report(name, "Parse (trusted)", source.size(), Measure(source.size(), [&] {
+             Value parsed;
+             Parse(source, parsed, trusted);
+             gSink = gSink + parsed.isObject();
+           }));
+    ParseOptions iterative;
+    iterative.iterative = true;
+    Report(name, "Parse (iterative)", source.size(), Measure(source.size(), [&] {
+             Value parsed;
+             Parse(source, parsed, iterative);
+             gSink = gSink + parsed.isObject();
+           }));
+    Value reused;
+    Report(name, "ParseInPlace", source.size(), Measure(source.size(), [&] {
+             ParseInPlace(source, reused);
+             gSink = gSink + reused.isObject();
+           }));
+    Report(name, "ParseLossless", source.size(), Measure(source.size(), [&] {
+             LosslessValue parsed;
+             ParseLossless(source, parsed);
+             gSink = gSink + parsed.objectItems.size();
+           }));
+
+    // Index the document and decode a single member, the typical read-a-few-keys use
+    const std::string lastKey = value.isObject() && !value.asObject().empty() ? std::prev(value.asObject().end())->first : "";
+    Report(name, "LazyDocument+Get", source.size(), Measure(source.size(), [&] {
+             LazyDocument document;
+             Value member;
+             document.Parse(source);
+             document.Get(lastKey, member);
+             gSink = gSink + member.index();
+           }));
+
+    Report(name, "TapeDocument", source.size(), Measure(source.size(), [&] {
+             TapeDocument document;
+             document.Parse(source);
+             gSink = gSink + document.Root().size();
+           }));
+
+    const std::size_t csonBytes = ToString(value).size();
+    Report(name, "ToString", csonBytes, Measure(csonBytes, [&] { gSink = gSink + ToString(value).size(); }));
+
+    const std::size_t losslessBytes = ToStringLossless(lossless).size();
+    Report(name, "ToStringLossless", losslessBytes, Measure(losslessBytes, [&] { gSink = gSink + ToStringLossless(lossless).size(); }));
+
+    // Touch the last member (marks it and the root dirty) and write the rest of the document from source
+    WriteOptions keep;
+    keep.keepSourceText = true;
+    LosslessValue touched = lossless;
+    touched.find(lastKey);
+    const std::size_t keptBytes = ToStringLossless(touched, keep).size();
+    Report(name, "Lossless (kept)", keptBytes, Measure(keptBytes, [&] { gSink = gSink + ToStringLossless(touched, keep).size(); }));
+
+    const std::size_t jsonBytes = ToJsonString(value).size();
+    Report(name, "ToJsonString", jsonBytes, Measure(jsonBytes, [&] { gSink = gSink + ToJsonString(value).size(); }));
+
+    WriteOptions pretty;
+    const std::size_t prettyBytes = ToJsonString(value, pretty).size();
+    Report(name, "ToJson (pretty)", prettyBytes, Measure(prettyBytes, [&] { gSink = gSink + ToJsonString(value, pretty).size(); }));
+    return true;
+  }
+} // namespace
+
+int main(int argc, char** argv)
+{
+  const std::string filter = argc > 1 ? argv[1] : "";
+
+  struct Corpus
+  {
+    const char* name;
+    std::string (*generate)();
+  };
+  const Corpus corpora[] = {
+    {"deep-objects", DeepObjects},
+    {"wide-object", WideObject},
+    {"numeric-arrays", NumericArrays},
+    {"escaped-strings", EscapedStrings},
+    {"triple-strings", TripleStrings},
+    {"comment-dense", CommentDense},
+  };
+
+  bool ok = true;
+  for (const Corpus& corpus : corpora)
+  {
+    if (filter.empty() || std::string(corpus.name).find(filter) != std::string::npos)
+    {
+      ok = Run(corpus.name, corpus.generate()) && ok;
+    }
+  }
+  return ok ? 0 : 1;
+}
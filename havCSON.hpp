@@ -64,29 +64,80 @@ SOFTWARE.
   #undef WIN32_LEAN_AND_MEAN
   #define WIN32_LEAN_AND_MEAN
   #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <poll.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+  #if defined(__linux__)
+    #include <sys/eventfd.h>
+    #include <sys/inotify.h>
+  #elif defined(HAVCSON_ENABLE_EXPERIMENTAL_WATCH) && \
+    (defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__DragonFly__))
+    #define HAVCSON_DETAIL_KQUEUE 1
+    #include <sys/event.h>
+  #endif
 #endif
 
 #include <cstdio>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <climits>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <chrono>
 #include <cmath>
+#include <compare>
+#include <concepts>
+#include <condition_variable>
+#include <deque>
 #include <exception>
 #include <fstream>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <optional>
+#include <span>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <string_view>
-#include <unordered_map>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include <variant>
 #include <vector>
 
+#if defined(__AVX2__)
+  #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+  #include <arm_neon.h>
+#endif
+
 static_assert(CHAR_BIT == 8, "havCSON requires 8-bit bytes");
 
-namespace havCSON
+// HAVCSON_ENABLE_STATS changes the code of inline functions, so it also picks the inline namespace everything lives in:
+// translation units built with and without it define distinct entities instead of two versions of the same ones
+#if defined(HAVCSON_ENABLE_STATS)
+  #define HAVCSON_DETAIL_CONFIG_NAMESPACE config_stats
+#else
+  #define HAVCSON_DETAIL_CONFIG_NAMESPACE config_default
+#endif
+
+namespace havCSON::inline HAVCSON_DETAIL_CONFIG_NAMESPACE
 {
 #ifdef _WIN32
   // Convert UTF-8 to UTF-16; keep the trailing null when forFileStream is true so _wfopen / _wifstream can use data()
@@ -127,6 +178,104 @@ namespace havCSON
     }
     return fileStream;
   }
+
+  // Read-only view of a whole file mapped into memory; IsMapped() is false if the file could not be mapped (missing,
+  // empty, not a regular file, ...) so callers can fall back to buffered reads
+  class MappedFileUTF8
+  {
+  public:
+    explicit MappedFileUTF8(const std::string& path)
+    {
+      std::wstring pathW = ConvertStringToWString(path, true);
+      mFile = CreateFileW(
+        pathW.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+      if (mFile == INVALID_HANDLE_VALUE)
+      {
+        return;
+      }
+      LARGE_INTEGER size{};
+      if (!GetFileSizeEx(mFile, &size) || size.QuadPart <= 0 || static_cast<unsigned long long>(size.QuadPart) > SIZE_MAX)
+      {
+        return;
+      }
+      mMapping = CreateFileMappingW(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (!mMapping)
+      {
+        return;
+      }
+      void* view = MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+      if (!view)
+      {
+        return;
+      }
+      mData = static_cast<const char*>(view);
+      mSize = static_cast<std::size_t>(size.QuadPart);
+    }
+
+    ~MappedFileUTF8()
+    {
+      if (mData)
+      {
+        UnmapViewOfFile(mData);
+      }
+      if (mMapping)
+      {
+        CloseHandle(mMapping);
+      }
+      if (mFile != INVALID_HANDLE_VALUE)
+      {
+        CloseHandle(mFile);
+      }
+    }
+
+    MappedFileUTF8(const MappedFileUTF8&) = delete;
+    MappedFileUTF8& operator=(const MappedFileUTF8&) = delete;
+
+    bool IsMapped() const
+    {
+      return mData != nullptr;
+    }
+
+    std::string_view View() const
+    {
+      return std::string_view(mData, mSize);
+    }
+
+  private:
+    HANDLE mFile = INVALID_HANDLE_VALUE;
+    HANDLE mMapping = nullptr;
+    const char* mData = nullptr;
+    std::size_t mSize = 0;
+  };
+
+  // Size and last write time (FILETIME ticks) of a file; false if it can't be queried
+  inline bool StatFileUTF8(const std::string& path, std::uint64_t& size, std::int64_t& modified)
+  {
+    std::wstring pathW = ConvertStringToWString(path, true);
+    WIN32_FILE_ATTRIBUTE_DATA data{};
+    if (!GetFileAttributesExW(pathW.c_str(), GetFileExInfoStandard, &data))
+    {
+      return false;
+    }
+    size = (static_cast<std::uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    modified = static_cast<std::int64_t>(
+      (static_cast<std::uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime);
+    return true;
+  }
+
+  // Move from over to, replacing to if it exists
+  inline bool ReplaceFileUTF8(const std::string& from, const std::string& to)
+  {
+    std::wstring fromW = ConvertStringToWString(from, true);
+    std::wstring toW = ConvertStringToWString(to, true);
+    return MoveFileExW(fromW.c_str(), toW.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+  }
+
+  inline bool RemoveFileUTF8(const std::string& path)
+  {
+    std::wstring pathW = ConvertStringToWString(path, true);
+    return DeleteFileW(pathW.c_str()) != 0;
+  }
 #else
   inline std::unique_ptr<std::FILE, decltype(&std::fclose)> OpenFileUTF8(const std::string& path, const std::string& mode)
   {
@@ -134,6 +283,90 @@ namespace havCSON
     fileStream.reset(std::fopen(path.c_str(), mode.c_str()));
     return fileStream;
   }
+
+  // Read-only view of a whole file mapped into memory; IsMapped() is false if the file could not be mapped (missing,
+  // empty, not a regular file, ...) so callers can fall back to buffered reads
+  class MappedFileUTF8
+  {
+  public:
+    explicit MappedFileUTF8(const std::string& path)
+    {
+      int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (fd < 0)
+      {
+        return;
+      }
+      struct stat fileStat{};
+      if (::fstat(fd, &fileStat) == 0 && S_ISREG(fileStat.st_mode) && fileStat.st_size > 0 &&
+        static_cast<unsigned long long>(fileStat.st_size) <= SIZE_MAX)
+      {
+        std::size_t size = static_cast<std::size_t>(fileStat.st_size);
+        void* view = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view != MAP_FAILED)
+        {
+          ::posix_madvise(view, size, POSIX_MADV_SEQUENTIAL);
+          mData = static_cast<const char*>(view);
+          mSize = size;
+        }
+      }
+      // The mapping stays valid after the descriptor is closed
+      ::close(fd);
+    }
+
+    ~MappedFileUTF8()
+    {
+      if (mData)
+      {
+        ::munmap(const_cast<char*>(mData), mSize);
+      }
+    }
+
+    MappedFileUTF8(const MappedFileUTF8&) = delete;
+    MappedFileUTF8& operator=(const MappedFileUTF8&) = delete;
+
+    bool IsMapped() const
+    {
+      return mData != nullptr;
+    }
+
+    std::string_view View() const
+    {
+      return std::string_view(mData, mSize);
+    }
+
+  private:
+    const char* mData = nullptr;
+    std::size_t mSize = 0;
+  };
+
+  // Size and last modification time (nanoseconds since the epoch) of a file; false if it can't be queried
+  inline bool StatFileUTF8(const std::string& path, std::uint64_t& size, std::int64_t& modified)
+  {
+    struct stat fileStat{};
+    if (::stat(path.c_str(), &fileStat) != 0)
+    {
+      return false;
+    }
+  #ifdef __APPLE__
+    const struct timespec& time = fileStat.st_mtimespec;
+  #else
+    const struct timespec& time = fileStat.st_mtim;
+  #endif
+    size = static_cast<std::uint64_t>(fileStat.st_size);
+    modified = static_cast<std::int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+    return true;
+  }
+
+  // Move from over to, replacing to if it exists (atomic on POSIX file systems)
+  inline bool ReplaceFileUTF8(const std::string& from, const std::string& to)
+  {
+    return std::rename(from.c_str(), to.c_str()) == 0;
+  }
+
+  inline bool RemoveFileUTF8(const std::string& path)
+  {
+    return std::remove(path.c_str()) == 0;
+  }
 #endif
 
   struct LocationEntry
@@ -155,6 +388,14 @@ namespace havCSON
     InvalidIndentChar,
     InconsistentIndent,
     InternalError,
+    Aborted, // An event handler returned false
+    PathNotFound, // LazyDocument path is malformed or names no value
+    InvalidSnapshot, // Binary snapshot is truncated, corrupt or from another format version
+    TypeMismatch, // Value doesn't fit the member it is bound to (struct binding)
+    DepthLimitExceeded, // ParseOptions::maxDepth
+    StringTooLong, // ParseOptions::maxStringLength, or a string a TapeDocument can't hold (4 GiB)
+    AllocationLimitExceeded, // ParseOptions::maxAllocatedBytes
+    TooManyElements, // ParseOptions::maxElements, or more tape entries than a TapeDocument can address (2^32)
   };
 
   struct Error
@@ -169,3111 +410,10096 @@ namespace havCSON
     }
   };
 
-  struct Value;
+  // Insertion-ordered hash map used as the Object type. Members are stored contiguously (iteration follows insertion
+  // order), with an open-addressing index of member positions for lookup; maps of up to kLinearLimit members skip the
+  // index and are scanned. Lookup is transparent: any key convertible to std::string_view. Keys are const through
+  // iterators, which dereference to a std::pair<const Key&, T&> of the stored member (value_type is still
+  // std::pair<const Key, T>, as in std::unordered_map), so they can't get out of step with the index; bind members
+  // as const auto& [key, value] or auto&& [key, value]. Erasing keeps the order: the later members shift down and the
+  // index is patched in place, O(n) without rehashing; erase(first, last) and erase_if drop many members in one pass.
+  template <typename Key, typename T, typename Allocator = std::allocator<std::pair<Key, T>>>
+  class OrderedMap
+  {
+    // Members are stored as std::pair<Key, T> so the vector can move them when it grows or shifts; iterators hand
+    // out references to their key (const) and value
+    using Entries = std::vector<std::pair<Key, T>, Allocator>;
 
-  using Array = std::vector<Value>;
-  using Object = std::unordered_map<std::string, Value>;
+  public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using size_type = std::size_t;
+    using allocator_type = Allocator;
+
+    template <bool Const>
+    class Iterator
+    {
+      using Base = std::conditional_t<Const, typename Entries::const_iterator, typename Entries::iterator>;
 
-  struct Value : std::variant<std::nullptr_t, bool, double, std::string, Array, Object>
-  {
-    using variant::variant;
+    public:
+      // reference is a proxy (like std::vector<bool>'s), so -> goes through one holding it
+      using iterator_category = std::random_access_iterator_tag;
+      using value_type = OrderedMap::value_type;
+      using difference_type = std::ptrdiff_t;
+      using reference = std::pair<const Key&, std::conditional_t<Const, const T&, T&>>;
 
-    bool isNull() const
+      struct pointer
+      {
+        reference member;
+
+        const reference* operator->() const
+        {
+          return &member;
+        }
+      };
+
+      Iterator() = default;
+
+      template <bool OtherConst>
+        requires(Const && !OtherConst)
+      Iterator(const Iterator<OtherConst>& other) : mBase(other.mBase)
+      {}
+
+      reference operator*() const
+      {
+        return reference(mBase->first, mBase->second);
+      }
+
+      pointer operator->() const
+      {
+        return pointer{**this};
+      }
+
+      reference operator[](difference_type offset) const
+      {
+        return *(*this + offset);
+      }
+
+      Iterator& operator++()
+      {
+        ++mBase;
+        return *this;
+      }
+
+      Iterator operator++(int)
+      {
+        return Iterator(mBase++);
+      }
+
+      Iterator& operator--()
+      {
+        --mBase;
+        return *this;
+      }
+
+      Iterator operator--(int)
+      {
+        return Iterator(mBase--);
+      }
+
+      Iterator& operator+=(difference_type offset)
+      {
+        mBase += offset;
+        return *this;
+      }
+
+      Iterator& operator-=(difference_type offset)
+      {
+        mBase -= offset;
+        return *this;
+      }
+
+      friend Iterator operator+(Iterator it, difference_type offset)
+      {
+        return it += offset;
+      }
+
+      friend Iterator operator+(difference_type offset, Iterator it)
+      {
+        return it += offset;
+      }
+
+      friend Iterator operator-(Iterator it, difference_type offset)
+      {
+        return it -= offset;
+      }
+
+      friend difference_type operator-(const Iterator& a, const Iterator& b)
+      {
+        return a.mBase - b.mBase;
+      }
+
+      friend bool operator==(const Iterator& a, const Iterator& b) = default;
+      friend auto operator<=>(const Iterator& a, const Iterator& b) = default;
+
+    private:
+      friend class OrderedMap;
+      template <bool>
+      friend class Iterator;
+
+      explicit Iterator(Base base) : mBase(base)
+      {}
+
+      Base mBase{};
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    OrderedMap() = default;
+
+    explicit OrderedMap(const allocator_type& allocator) : mEntries(allocator), mIndex(IndexAllocator(allocator))
+    {}
+
+    OrderedMap(std::initializer_list<value_type> items, const allocator_type& allocator = allocator_type()) : OrderedMap(allocator)
     {
-      return std::holds_alternative<std::nullptr_t>(*this);
+      reserve(items.size());
+      for (const auto& item : items)
+      {
+        try_emplace(item.first, item.second);
+      }
     }
 
-    bool isBool() const
+    iterator begin()
     {
-      return std::holds_alternative<bool>(*this);
+      return iterator(mEntries.begin());
     }
 
-    bool isNumber() const
+    iterator end()
     {
-      return std::holds_alternative<double>(*this);
+      return iterator(mEntries.end());
     }
 
-    bool isString() const
+    const_iterator begin() const
     {
-      return std::holds_alternative<std::string>(*this);
+      return const_iterator(mEntries.begin());
     }
 
-    bool isArray() const
+    const_iterator end() const
     {
-      return std::holds_alternative<Array>(*this);
+      return const_iterator(mEntries.end());
     }
 
-    bool isObject() const
+    const_iterator cbegin() const
     {
-      return std::holds_alternative<Object>(*this);
+      return begin();
     }
 
-    const Array& asArray() const
+    const_iterator cend() const
     {
-      return std::get<Array>(*this);
+      return end();
     }
 
-    const Object& asObject() const
+    bool empty() const
     {
-      return std::get<Object>(*this);
+      return mEntries.empty();
     }
 
-    Array& asArray()
+    size_type size() const
     {
-      return std::get<Array>(*this);
+      return mEntries.size();
     }
 
-    Object& asObject()
+    allocator_type get_allocator() const
     {
-      return std::get<Object>(*this);
+      return mEntries.get_allocator();
     }
-  };
 
-  // Optional lossless representation that can carry comments / ordering for regeneration
-  struct LosslessComment
-  {
-    int indent = 0; // Indent columns where this comment line began
-    std::string text; // Comment text without trailing newline (empty -> blank line)
-  };
+    void reserve(size_type count)
+    {
+      mEntries.reserve(count);
+      if (count > kLinearLimit && count * 2 > mIndex.size())
+      {
+        Rehash(count);
+      }
+    }
 
-  struct LosslessValue
-  {
-    Value value;
-    std::vector<LosslessComment> leadingComments; // Full lines with recorded indent
-    std::string inlineComment; // Text after '#' on the same line as the value
-    std::vector<LosslessValue> arrayItems; // In-order children if value is array
-    std::vector<std::pair<std::string, LosslessValue>> objectItems; // In-order children if value is object
-    std::vector<LosslessComment> trailingComments; // Comments / blank lines after this value (before dedent)
-  };
+    void clear()
+    {
+      mEntries.clear();
+      mIndex.clear();
+    }
 
-  class Parser
-  {
-  public:
-    Parser(std::string_view src, std::string_view filename = {}) : mSrc(src), mFilename(filename)
-    {}
+    // Clear, first handing each member to fn(Key&&, T&) in order: the one way to move a key out (e.g. to reuse its
+    // storage), since iterators only expose keys as const
+    template <typename Fn>
+    void drain(Fn&& fn)
+    {
+      for (auto& entry : mEntries)
+      {
+        fn(std::move(entry.first), entry.second);
+      }
+      clear();
+    }
 
-    ErrorCode Parse(Value& out, Error* error = nullptr)
+    iterator find(std::string_view key)
     {
-      // Reset previous error state for a fresh parse
-      mError = {};
+      std::size_t position = Find(key);
+      return position == kNotFound ? end() : begin() + static_cast<std::ptrdiff_t>(position);
+    }
 
-      // Validate UTF-8 up front (strips leading BOM)
-      std::size_t badIndex = 0;
-      std::size_t badLine = 1;
-      std::size_t badCol = 1;
-      bool hasBOM = mSrc.size() >= 3 && static_cast<unsigned char>(mSrc[0]) == 0xEF && static_cast<unsigned char>(mSrc[1]) == 0xBB &&
-        static_cast<unsigned char>(mSrc[2]) == 0xBF;
-      if (!ValidateUTF8(mSrc, true, badIndex, badLine, badCol))
+    const_iterator find(std::string_view key) const
+    {
+      std::size_t position = Find(key);
+      return position == kNotFound ? end() : begin() + static_cast<std::ptrdiff_t>(position);
+    }
+
+    bool contains(std::string_view key) const
+    {
+      return Find(key) != kNotFound;
+    }
+
+    size_type count(std::string_view key) const
+    {
+      return contains(key) ? 1 : 0;
+    }
+
+    T& at(std::string_view key)
+    {
+      auto it = find(key);
+      if (it == end())
       {
-        mPos = badIndex;
-        mLine = badLine;
-        mCol = badCol;
-        return Fail(ErrorCode::InvalidUtf8, error, "Invalid UTF-8 encoding");
+        throw std::out_of_range("OrderedMap::at: key not found");
       }
-      if (hasBOM)
+      return it->second;
+    }
+
+    const T& at(std::string_view key) const
+    {
+      auto it = find(key);
+      if (it == end())
       {
-        mPos = 3;
-        mCol = 1;
-        mLine = 1;
+        throw std::out_of_range("OrderedMap::at: key not found");
       }
+      return it->second;
+    }
 
-      Value value;
-      SkipWhitespaceAndComments();
-      if (mPos >= mSrc.size())
+    T& operator[](std::string_view key)
+    {
+      return try_emplace(key).first->second;
+    }
+
+    // Append key with a value constructed from args unless the key exists; the key is only converted to Key (with
+    // the map's allocator where applicable) when it is inserted
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args)
+    {
+      std::size_t position = Find(std::string_view(key));
+      if (position != kNotFound)
       {
-        // Empty document -> null
-        value = nullptr;
+        return {begin() + static_cast<std::ptrdiff_t>(position), false};
       }
-      else
-      {
-        ErrorCode errorCode = ParseValue(value, 0);
-        if (errorCode != ErrorCode::OK)
-        {
-          if (error)
-          {
-            if (mError.code != ErrorCode::OK)
-            {
-              *error = mError;
-            }
-            else
-            {
-              error->code = errorCode;
-              error->where = Location();
-              error->message.clear();
-            }
-          }
-          return errorCode;
-        }
-      }
-
-      // After parsing top-level value, consume any remaining whitespace / comments and ensure we're back at indent
-      // level 0
-      while (!EndOfFile())
-      {
-        char c = Peek();
-        if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
-        {
-          Get();
-          continue;
-        }
-        if (c == '#')
-        {
-          SkipToEOL();
-          continue;
-        }
-        break;
-      }
-
-      // Reset indent stack to base level
-      mIndentStack.clear();
-      mIndentStack.push_back(0);
-
-      if (mPos != mSrc.size())
-      {
-        return Fail(ErrorCode::UnexpectedChar, error, "Trailing characters after top-level value");
-      }
-      out = std::move(value);
-      if (error)
-      {
-        *error = {};
-      }
-      return ErrorCode::OK;
+      mEntries.emplace_back(
+        std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+      IndexAppended();
+      return {std::prev(end()), true};
     }
 
-    const Error& LastError() const
+    template <typename K, typename V>
+    std::pair<iterator, bool> emplace(K&& key, V&& value)
     {
-      return mError;
+      return try_emplace(std::forward<K>(key), std::forward<V>(value));
     }
 
-  protected:
-    std::string_view mSrc;
-    std::string_view mFilename;
-    std::size_t mPos = 0;
-    std::size_t mLine = 1;
-    std::size_t mCol = 1;
-
-    // CoffeeScript-like indent model
-    int mIndentUnit = 0; // Discovered on first non-zero indent
-    std::vector<int> mIndentStack{0}; // Known indent levels (columns)
+    std::pair<iterator, bool> insert(const value_type& item)
+    {
+      return try_emplace(item.first, item.second);
+    }
 
-    Error mError;
+    std::pair<iterator, bool> insert(value_type&& item)
+    {
+      return try_emplace(item.first, std::move(item.second));
+    }
 
-    char Peek() const
+    template <typename V>
+    std::pair<iterator, bool> insert_or_assign(std::string_view key, V&& value)
     {
-      return mPos < mSrc.size() ? mSrc[mPos] : '\0';
+      auto result = try_emplace(key, std::forward<V>(value));
+      if (!result.second)
+      {
+        result.first->second = std::forward<V>(value);
+      }
+      return result;
     }
 
-    bool EndOfFile() const
+    iterator erase(const_iterator position)
     {
-      return mPos >= mSrc.size();
+      const std::size_t erased = static_cast<std::size_t>(position - cbegin());
+      mEntries.erase(position.mBase);
+      IndexErased(erased);
+      return begin() + static_cast<std::ptrdiff_t>(erased);
     }
 
-    char Get()
+    iterator erase(const_iterator first, const_iterator last)
     {
-      if (mPos >= mSrc.size())
+      const std::size_t erased = static_cast<std::size_t>(first - cbegin());
+      if (first != last)
       {
-        return '\0';
+        mEntries.erase(first.mBase, last.mBase);
+        RebuildIndex();
       }
-      char c = mSrc[mPos++];
-      if (c == '\n')
+      return begin() + static_cast<std::ptrdiff_t>(erased);
+    }
+
+    size_type erase(std::string_view key)
+    {
+      auto it = find(key);
+      if (it == end())
       {
-        ++mLine;
-        mCol = 1;
+        return 0;
       }
-      else
+      erase(it);
+      return 1;
+    }
+
+    // Drop every member predicate(const_iterator::reference) is true for, keeping the order of the rest; one pass and
+    // one index rebuild however many go
+    template <typename Predicate>
+    friend size_type erase_if(OrderedMap& map, Predicate predicate)
+    {
+      const auto kept = std::remove_if(map.mEntries.begin(), map.mEntries.end(), [&](const std::pair<Key, T>& entry) {
+        return predicate(typename const_iterator::reference(entry.first, entry.second));
+      });
+      const auto erased = static_cast<size_type>(map.mEntries.end() - kept);
+      if (erased > 0)
       {
-        ++mCol;
+        map.mEntries.erase(kept, map.mEntries.end());
+        map.RebuildIndex();
       }
-      return c;
+      return erased;
     }
 
-    bool Match(char c)
+    // Same members regardless of order, like the unordered containers
+    friend bool operator==(const OrderedMap& a, const OrderedMap& b)
     {
-      if (Peek() == c)
+      if (a.size() != b.size())
       {
-        Get();
-        return true;
+        return false;
       }
-      return false;
+      for (const auto& [key, value] : a)
+      {
+        auto it = b.find(key);
+        if (it == b.end() || !(it->second == value))
+        {
+          return false;
+        }
+      }
+      return true;
     }
 
-    LocationEntry Location() const
+  private:
+    using IndexAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<std::uint32_t>;
+
+    static constexpr std::size_t kLinearLimit = 8;
+    static constexpr std::size_t kNotFound = static_cast<std::size_t>(-1);
+
+    Entries mEntries;
+    std::vector<std::uint32_t, IndexAllocator> mIndex; // Power-of-two slots holding position + 1 (0 = empty)
+
+    static std::size_t Hash(std::string_view key)
     {
-      return LocationEntry{mLine, mCol};
+      return std::hash<std::string_view>{}(key);
     }
 
-    ErrorCode Fail(ErrorCode code, Error* out, std::string_view message = {})
+    std::size_t Find(std::string_view key) const
     {
-      mError.code = code;
-      mError.where = Location();
-      mError.message.assign(message.begin(), message.end());
-      if (out)
+      if (mIndex.empty())
       {
-        *out = mError;
+        for (std::size_t position = 0; position < mEntries.size(); ++position)
+        {
+          if (std::string_view(mEntries[position].first) == key)
+          {
+            return position;
+          }
+        }
+        return kNotFound;
       }
-      return code;
-    }
 
-    void SkipInlineSpaces()
-    {
-      while (true)
+      const std::size_t mask = mIndex.size() - 1;
+      for (std::size_t slot = Hash(key) & mask;; slot = (slot + 1) & mask)
       {
-        char c = Peek();
-        if (c == ' ' || c == '	')
+        const std::uint32_t entry = mIndex[slot];
+        if (entry == 0)
         {
-          Get();
+          return kNotFound;
         }
-        else
+        if (std::string_view(mEntries[entry - 1].first) == key)
         {
-          break;
+          return entry - 1;
         }
       }
     }
 
-    void SkipToEOL()
+    void Place(std::size_t position)
     {
-      while (!EndOfFile())
+      const std::size_t mask = mIndex.size() - 1;
+      std::size_t slot = Hash(std::string_view(mEntries[position].first)) & mask;
+      while (mIndex[slot] != 0)
       {
-        char c = Get();
-        if (c == '\n')
-        {
-          break;
-        }
+        slot = (slot + 1) & mask;
       }
+      mIndex[slot] = static_cast<std::uint32_t>(position + 1);
     }
 
-    void SkipWhitespaceAndComments()
+    // Rebuild the index with room for count members at a load factor of at most 1/2
+    void Rehash(std::size_t count)
     {
-      while (!EndOfFile())
+      std::size_t slots = 16;
+      while (slots < count * 2)
       {
-        char c = Peek();
-        if (c == ' ' || c == '	')
-        {
-          Get();
-          continue;
-        }
-        if (c == '#')
-        {
-          SkipToEOL();
-          continue;
-        }
-        if (c == '\r')
-        {
-          Get();
-          if (Peek() == '\n')
-          {
-            Get();
-          }
-          continue;
-        }
-        if (c == '\n')
-        {
-          Get();
-          continue;
-        }
-        break;
+        slots *= 2;
+      }
+      mIndex.assign(slots, 0);
+      for (std::size_t position = 0; position < mEntries.size(); ++position)
+      {
+        Place(position);
       }
     }
 
-    // Reads indentation (spaces only) at the beginning of a line.
-    // Assumes we are positioned at the first character of a line.
-    // - indentCols: number of columns (spaces).
-    // - hasContent: true if the line has non-comment content.
-    // Returns ErrorCode::Ok or an indent-related error.
-    ErrorCode ReadLineIndent(int& indentCols, bool& hasContent)
+    void IndexAppended()
     {
-      indentCols = 0;
-      hasContent = false;
+      const std::size_t count = mEntries.size();
+      if (mIndex.empty() ? count > kLinearLimit : count * 2 > mIndex.size())
+      {
+        Rehash(count);
+      }
+      else if (!mIndex.empty())
+      {
+        Place(count - 1);
+      }
+    }
 
-      // Consume leading spaces / detect tabs in indent
-      while (!EndOfFile())
+    // The member at position erased is gone and the later ones moved down one: take its slot out of the index (shifting
+    // back the probe run behind it so lookups still find every member) and renumber the slots of the moved members
+    void IndexErased(std::size_t erased)
+    {
+      if (mIndex.empty())
       {
-        char c = Peek();
-        if (c == ' ')
-        {
-          Get();
-          ++indentCols;
-        }
-        else if (c == '\t')
-        {
-          // Tabs are illegal in indent
-          return Fail(ErrorCode::InvalidIndentChar, nullptr, "Tabs are not allowed in indentation");
-        }
-        else
-        {
-          break;
-        }
+        return;
+      }
+      if (mEntries.size() <= kLinearLimit)
+      {
+        mIndex.clear();
+        return;
       }
 
-      // Check if the rest of the line is blank or comment-only
-      char c = Peek();
-      if (c == '#' || c == '\r' || c == '\n' || c == '\0')
+      const auto erasedEntry = static_cast<std::uint32_t>(erased + 1);
+      std::size_t hole = 0;
+      for (std::size_t slot = 0; slot < mIndex.size(); ++slot)
       {
-        // Skip comment content
-        if (c == '#')
-        {
-          SkipToEOL();
-          c = Peek();
-        }
-        // Consume line ending (if any)
-        if (c == '\r')
+        if (mIndex[slot] == erasedEntry)
         {
-          Get();
-          if (Peek() == '\n')
-          {
-            Get();
-          }
+          hole = slot;
         }
-        else if (c == '\n')
+        else if (mIndex[slot] > erasedEntry)
         {
-          Get();
+          --mIndex[slot];
         }
-        // No content on this line
-        hasContent = false;
-        return ErrorCode::OK;
       }
 
-      // This line has content
-      hasContent = true;
-
-      // Enforce a global indent unit
-      if (indentCols > 0)
+      const std::size_t mask = mIndex.size() - 1;
+      for (std::size_t slot = (hole + 1) & mask; mIndex[slot] != 0; slot = (slot + 1) & mask)
       {
-        if (mIndentUnit == 0)
-        {
-          mIndentUnit = indentCols;
-        }
-        else if (indentCols % mIndentUnit != 0)
+        // A member may fill the hole unless its home slot lies between the hole and where it sits
+        const std::size_t home = Hash(std::string_view(mEntries[mIndex[slot] - 1].first)) & mask;
+        if (((slot - home) & mask) >= ((slot - hole) & mask))
         {
-          return Fail(ErrorCode::InconsistentIndent, nullptr, "Indentation is not a multiple of base indent width");
+          mIndex[hole] = mIndex[slot];
+          hole = slot;
         }
       }
-
-      return ErrorCode::OK;
+      mIndex[hole] = 0;
     }
 
-    // Apply CoffeeScript-style indent stack transitions:
-    // - If indent > top: push (new block).
-    // - If indent < top: pop until match or error.
-    // - If indent == top: stay in current block.
-    ErrorCode ApplyIndentLevel(int indentCols)
+    void RebuildIndex()
     {
-      int top = mIndentStack.back();
-      if (indentCols > top)
+      if (mEntries.size() > kLinearLimit)
       {
-        mIndentStack.push_back(indentCols);
+        Rehash(mEntries.size());
       }
-      else if (indentCols < top)
+      else
       {
-        while (!mIndentStack.empty() && indentCols < mIndentStack.back())
-        {
-          mIndentStack.pop_back();
-        }
-        if (mIndentStack.empty() || mIndentStack.back() != indentCols)
-        {
-          return Fail(ErrorCode::InconsistentIndent, nullptr, "Dedent does not match any previous indent level");
-        }
+        mIndex.clear();
       }
-      return ErrorCode::OK;
     }
+  };
 
-    // Skip blank / comment lines and position at the first token of the next non-empty line, applying indent stack
-    // transitions. Returns false if we reach EOF.
-    ErrorCode NextContentLine(bool& hasLine)
+  struct Value;
+
+  using Array = std::vector<Value>;
+  using Object = OrderedMap<std::string, Value>;
+
+  struct Value : std::variant<std::nullptr_t, bool, double, std::string, Array, Object>
+  {
+    using variant::variant;
+
+    bool isNull() const
     {
-      hasLine = false;
-      while (!EndOfFile())
-      {
-        // If we are mid-line, consume to the end so we start clean on the next iteration
-        if (mCol != 1)
-        {
-          SkipToEOL();
-          // If we hit EOF while skipping, surface as no more lines
-          if (EndOfFile())
-          {
-            return ErrorCode::OK;
-          }
-          continue;
-        }
+      return std::holds_alternative<std::nullptr_t>(*this);
+    }
 
-        int indentCols = 0;
-        bool hasContent = false;
-        ErrorCode errorCode = ReadLineIndent(indentCols, hasContent);
-        if (errorCode != ErrorCode::OK)
-        {
-          return errorCode;
-        }
+    bool isBool() const
+    {
+      return std::holds_alternative<bool>(*this);
+    }
 
-        if (!hasContent)
-        {
-          // Blank / comment line, continue to next line
-          continue;
-        }
+    bool isNumber() const
+    {
+      return std::holds_alternative<double>(*this);
+    }
 
-        // Apply CoffeeScript indent rules for this new line
-        errorCode = ApplyIndentLevel(indentCols);
-        if (errorCode != ErrorCode::OK)
-        {
-          return errorCode;
-        }
+    bool isString() const
+    {
+      return std::holds_alternative<std::string>(*this);
+    }
 
-        hasLine = true;
-        return ErrorCode::OK;
-      }
-      return ErrorCode::OK; // EOF, hasLine = false
+    bool isArray() const
+    {
+      return std::holds_alternative<Array>(*this);
     }
 
-    static int HexValue(char c)
+    bool isObject() const
     {
-      if (c >= '0' && c <= '9')
+      return std::holds_alternative<Object>(*this);
+    }
+
+    const Array& asArray() const
+    {
+      return std::get<Array>(*this);
+    }
+
+    const Object& asObject() const
+    {
+      return std::get<Object>(*this);
+    }
+
+    Array& asArray()
+    {
+      return std::get<Array>(*this);
+    }
+
+    Object& asObject()
+    {
+      return std::get<Object>(*this);
+    }
+
+    using StringType = std::string;
+    using ArrayType = Array;
+    using ObjectType = Object;
+  };
+
+  // Allocator-aware variant of the value tree; strings and containers allocate from the memory resource they were
+  // created with (e.g. a std::pmr::monotonic_buffer_resource arena)
+  namespace pmr
+  {
+    struct Value;
+
+    using Array = std::pmr::vector<Value>;
+    using Object = OrderedMap<std::pmr::string, Value, std::pmr::polymorphic_allocator<std::pair<std::pmr::string, Value>>>;
+
+    struct Value : std::variant<std::nullptr_t, bool, double, std::pmr::string, Array, Object>
+    {
+      using variant::variant;
+
+      bool isNull() const
       {
-        return c - '0';
+        return std::holds_alternative<std::nullptr_t>(*this);
       }
-      if (c >= 'a' && c <= 'f')
+
+      bool isBool() const
       {
-        return 10 + (c - 'a');
+        return std::holds_alternative<bool>(*this);
       }
-      if (c >= 'A' && c <= 'F')
+
+      bool isNumber() const
       {
-        return 10 + (c - 'A');
+        return std::holds_alternative<double>(*this);
       }
-      return -1;
-    }
 
-    static void AppendUTF8(std::string& out, std::uint32_t codePoint)
-    {
-      if (codePoint <= 0x7F)
+      bool isString() const
       {
-        out.push_back(static_cast<char>(codePoint));
+        return std::holds_alternative<std::pmr::string>(*this);
       }
-      else if (codePoint <= 0x7FF)
+
+      bool isArray() const
       {
-        out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
-        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        return std::holds_alternative<Array>(*this);
       }
-      else if (codePoint <= 0xFFFF)
+
+      bool isObject() const
       {
-        out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
-        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
-        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        return std::holds_alternative<Object>(*this);
       }
-      else
+
+      const Array& asArray() const
       {
-        out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
-        out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
-        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
-        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        return std::get<Array>(*this);
       }
-    }
 
-    bool ValidateUTF8(std::string_view stringView, bool allowLeadingBOM, std::size_t& badIndex, std::size_t& badLine, std::size_t& badCol)
-    {
-      std::size_t index = 0;
-      badLine = 1;
-      badCol = 1;
+      const Object& asObject() const
+      {
+        return std::get<Object>(*this);
+      }
 
-      auto bumpCol = [&](std::uint32_t codePoint) {
-        if (codePoint == '\n')
-        {
-          ++badLine;
-          badCol = 1;
-        }
-        else
-        {
-          ++badCol;
-        }
-      };
+      Array& asArray()
+      {
+        return std::get<Array>(*this);
+      }
 
-      while (index < stringView.size())
+      Object& asObject()
       {
-        unsigned char c = static_cast<unsigned char>(stringView[index]);
+        return std::get<Object>(*this);
+      }
 
-        if (
-          index == 0 && allowLeadingBOM && stringView.size() >= 3 && c == 0xEF && static_cast<unsigned char>(stringView[1]) == 0xBB &&
-          static_cast<unsigned char>(stringView[2]) == 0xBF)
-        {
-          index += 3;
-          continue;
-        }
-        else if (
-          index > 0 && c == 0xEF && index + 2 < stringView.size() && static_cast<unsigned char>(stringView[index + 1]) == 0xBB &&
-          static_cast<unsigned char>(stringView[index + 2]) == 0xBF)
-        {
-          badIndex = index;
-          return false; // BOM not at start
-        }
+      using StringType = std::pmr::string;
+      using ArrayType = Array;
+      using ObjectType = Object;
+    };
+  } // namespace pmr
 
-        if (c <= 0x7F)
-        {
-          ++index;
-          bumpCol(c);
-          continue;
-        }
+  // Read-only tree whose keys / strings are views into the parsed source (see BorrowedDocument); only literals with
+  // escapes are decoded into storage owned by the document
+  namespace borrowed
+  {
+    struct Value;
 
-        std::uint32_t codePoint = 0;
-        int length = 0;
-        if ((c & 0xE0) == 0xC0)
-        {
-          length = 2;
-          codePoint = c & 0x1F;
-        }
-        else if ((c & 0xF0) == 0xE0)
-        {
-          length = 3;
-          codePoint = c & 0x0F;
-        }
-        else if ((c & 0xF8) == 0xF0)
-        {
-          length = 4;
-          codePoint = c & 0x07;
-        }
-        else
-        {
-          badIndex = index;
-          return false;
-        }
+    using Array = std::vector<Value>;
+    using Object = OrderedMap<std::string_view, Value>;
 
-        if (index + length > stringView.size())
-        {
-          badIndex = index;
-          return false;
-        }
-        for (std::size_t k = 1; k < length; ++k)
-        {
-          unsigned char cc = static_cast<unsigned char>(stringView[index + k]);
-          if ((cc & 0xC0) != 0x80)
-          {
-            badIndex = index;
-            return false;
-          }
-          codePoint = (codePoint << 6) | (cc & 0x3F);
-        }
+    struct Value : std::variant<std::nullptr_t, bool, double, std::string_view, Array, Object>
+    {
+      using variant::variant;
 
-        if (
-          (length == 2 && codePoint < 0x80) || (length == 3 && codePoint < 0x800) ||
-          (length == 4 && (codePoint < 0x10000 || codePoint > 0x10FFFF)) || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
-        {
-          badIndex = index;
-          return false;
-        }
+      bool isNull() const
+      {
+        return std::holds_alternative<std::nullptr_t>(*this);
+      }
 
-        index += length;
-        bumpCol(codePoint);
+      bool isBool() const
+      {
+        return std::holds_alternative<bool>(*this);
       }
-      return true;
-    }
 
-    ErrorCode ParseValue(Value& out, int currentIndent)
-    {
-      SkipWhitespaceAndComments();
-      char c = Peek();
-      if (c == '{')
+      bool isNumber() const
       {
-        return ParseInlineObject(out, currentIndent);
+        return std::holds_alternative<double>(*this);
       }
-      if (c == '[')
+
+      bool isString() const
       {
-        return ParseArray(out, currentIndent);
+        return std::holds_alternative<std::string_view>(*this);
       }
-      if (c == '"')
+
+      bool isArray() const
       {
-        // Could be normal or triple string
-        return ParseStringOrTriple(out);
+        return std::holds_alternative<Array>(*this);
       }
-      if (c == '\'')
+
+      bool isObject() const
       {
-        // Single-quoted string (no multiline)
-        return ParseStringSingle(out);
+        return std::holds_alternative<Object>(*this);
       }
-      if (IsIdentifierStart(c))
+
+      const Array& asArray() const
       {
-        return parseIdentifierOrIndentedObject(out, currentIndent);
+        return std::get<Array>(*this);
       }
-      if (IsNumberStart(c))
+
+      const Object& asObject() const
       {
-        return ParseNumber(out);
+        return std::get<Object>(*this);
       }
-      if (EndOfFile())
+
+      Array& asArray()
       {
-        return Fail(ErrorCode::UnexpectedEnd, nullptr, "Unexpected end of input while parsing value");
+        return std::get<Array>(*this);
       }
-      return Fail(ErrorCode::UnexpectedChar, nullptr, "Unexpected character while parsing value");
+
+      Object& asObject()
+      {
+        return std::get<Object>(*this);
+      }
+
+      using StringType = std::string_view;
+      using ArrayType = Array;
+      using ObjectType = Object;
+    };
+  } // namespace borrowed
+
+  // Optional lossless representation that can carry comments / ordering for regeneration
+  // Comment text of a lossless tree. Parsed text views the source, which every text shares ownership of, so parsing
+  // comments doesn't allocate; assigning a string (e.g. when editing) makes the text own its contents.
+  class LosslessText
+  {
+  public:
+    LosslessText() = default;
+
+    LosslessText(std::shared_ptr<const std::string> source, std::string_view view)
+      : mText(std::in_place_type<SourceText>, SourceText{std::move(source), view})
+    {}
+
+    LosslessText(std::string text) : mText(std::move(text))
+    {}
+
+    LosslessText& operator=(std::string text)
+    {
+      mText = std::move(text);
+      return *this;
     }
 
-    static bool IsIdentifierStart(char c)
+    std::string_view view() const
     {
-      return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_';
+      if (const SourceText* source = std::get_if<SourceText>(&mText))
+      {
+        return source->view;
+      }
+      return std::get<std::string>(mText);
     }
 
-    static bool IsIdentifierChar(char c)
+    operator std::string_view() const
     {
-      return IsIdentifierStart(c) || (c >= '0' && c <= '9') || c == '-' || c == '_';
+      return view();
     }
 
-    static bool IsNumberStart(char c)
+    bool empty() const
     {
-      return (c >= '0' && c <= '9') || c == '-' || c == '+';
+      return view().empty();
     }
 
-    // Parse identifier or keywords true / false / null or an indent-style object
-    ErrorCode parseIdentifierOrIndentedObject(Value& out, int currentIndent)
+    std::size_t size() const
     {
-      std::string ident;
-      while (IsIdentifierChar(Peek()))
-      {
-        ident.push_back(Get());
-      }
-      SkipInlineSpaces();
-      if (Peek() == ':')
-      {
-        // We are at start of an object: key ':' ... possibly multiple pairs
-        // Rewind to start of identifier and parse an indented object body.
-        // We treat this as an object even at top-level.
-        // Reset position so that parseObjectBody can re-read the key.
-        mPos -= ident.size();
-        mCol -= ident.size();
-        Object object;
-        ErrorCode errorCode = ParseIndentedObjectBody(object, currentIndent);
-        if (errorCode != ErrorCode::OK)
-        {
-          return errorCode;
-        }
-        out = std::move(object);
-        return ErrorCode::OK;
-      }
+      return view().size();
+    }
 
-      // Otherwise interpret as bare identifier value
-      if (ident == "true")
-      {
-        out = true;
-        return ErrorCode::OK;
-      }
-      if (ident == "false")
-      {
-        out = false;
-        return ErrorCode::OK;
-      }
-      if (ident == "null")
-      {
-        out = nullptr;
-        return ErrorCode::OK;
-      }
-      out = ident; // Bare string
-      return ErrorCode::OK;
+    // Still the parsed text (nothing was assigned since)
+    bool viewsSource() const
+    {
+      return std::holds_alternative<SourceText>(mText);
     }
 
-    ErrorCode ParseStringOrTriple(Value& out)
+    friend bool operator==(const LosslessText& a, const LosslessText& b)
     {
-      // We know first char is '"'
-      // Look ahead for """
-      if (Peek() != '"')
-      {
-        return Fail(ErrorCode::InternalError, nullptr);
-      }
-      // Check if next two characters are also '"'
-      if (mPos + 2 < mSrc.size() && mSrc[mPos] == '"' && mSrc[mPos + 1] == '"' && mSrc[mPos + 2] == '"')
-      {
-        return ParseTripleString(out);
-      }
-      return ParseStringDouble(out);
+      return a.view() == b.view();
     }
 
-    ErrorCode ParseStringDouble(Value& out)
+  private:
+    struct SourceText
     {
-      if (!Match('"'))
-      {
-        return Fail(ErrorCode::InternalError, nullptr);
+      std::shared_ptr<const std::string> source; // Keeps the parsed source alive
+      std::string_view view;
+    };
+
+    std::variant<std::string, SourceText> mText;
+  };
+
+  struct LosslessComment
+  {
+    int indent = 0; // Indent columns where this comment line began
+    LosslessText text; // Comment text without trailing newline (empty -> blank line)
+  };
+
+  // Lossless tree. value holds scalars; for containers it is an empty Array / Object marking the kind, and the children
+  // live only in arrayItems / objectItems. The accessors read the tree like a plain Value (duplicate keys resolve to
+  // the first member); ToValue / ToLossless convert between the two.
+  //
+  // ParseLossless also records where each value came from, so WriteOptions::keepSourceText can copy the unedited parts
+  // of a document instead of reformatting them. The non-const accessors mark the value and the child they return
+  // dirty; after changing fields directly, call MarkDirty() on the changed value and on each of its ancestors.
+  struct LosslessValue
+  {
+    Value value;
+    std::vector<LosslessComment> leadingComments; // Full lines with recorded indent
+    LosslessText inlineComment; // Text after '#' on the same line as the value
+    std::vector<LosslessValue> arrayItems; // In-order children if value is array
+    std::vector<std::pair<std::string, LosslessValue>> objectItems; // In-order children if value is object
+    std::vector<LosslessComment> trailingComments; // Comments / blank lines after this value (before dedent)
+
+    LosslessText sourceText; // Parsed text of the value (the whole document for the root, keys of members excluded)
+    std::size_t sourceKeyDistance = 0; // Object members: bytes from the start of the key to sourceText
+    std::uint64_t sourceShape = 0; // Kind, children and comment lines when parsed, to notice structural edits
+    bool dirty = false; // May no longer match sourceText: its text is rebuilt around copies of untouched children
+
+    void MarkDirty()
+    {
+      dirty = true;
+    }
+
+    bool isNull() const
+    {
+      return value.isNull();
+    }
+
+    bool isBool() const
+    {
+      return value.isBool();
+    }
+
+    bool isNumber() const
+    {
+      return value.isNumber();
+    }
+
+    bool isString() const
+    {
+      return value.isString();
+    }
+
+    bool isArray() const
+    {
+      return value.isArray();
+    }
+
+    bool isObject() const
+    {
+      return value.isObject();
+    }
+
+    // Elements of an array / members of an object
+    std::size_t size() const
+    {
+      return isArray() ? arrayItems.size() : objectItems.size();
+    }
+
+    const LosslessValue* find(std::string_view key) const
+    {
+      auto it = std::find_if(objectItems.begin(), objectItems.end(), [key](const auto& item) { return item.first == key; });
+      return it != objectItems.end() ? &it->second : nullptr;
+    }
+
+    LosslessValue* find(std::string_view key)
+    {
+      LosslessValue* member = const_cast<LosslessValue*>(std::as_const(*this).find(key));
+      if (member)
+      {
+        dirty = true;
+        member->dirty = true;
       }
-      std::string result;
-      while (!EndOfFile())
+      return member;
+    }
+
+    const LosslessValue& at(std::string_view key) const
+    {
+      if (const LosslessValue* member = find(key))
       {
-        char c = Get();
-        if (c == '"')
-        {
-          out = std::move(result);
-          return ErrorCode::OK;
-        }
-        if (c == '\\')
-        {
-          if (EndOfFile())
-          {
-            return Fail(ErrorCode::UnterminatedString, nullptr);
-          }
-          char e = Get();
-          switch (e)
-          {
-            case '"': result.push_back('"'); break;
-            case '\\': result.push_back('\\'); break;
-            case 'n': result.push_back('\n'); break;
-            case 'r': result.push_back('\r'); break;
-            case 't': result.push_back('\t'); break;
-            case 'u':
-            {
-              // Unicode escape \uXXXX with optional surrogate pair
-              std::uint32_t codePoint = 0;
-              for (std::size_t index = 0; index < 4; ++index)
-              {
-                if (EndOfFile())
-                {
-                  return Fail(ErrorCode::InvalidEscape, nullptr, "Incomplete unicode escape");
-                }
-                int hv = HexValue(Get());
-                if (hv < 0)
-                {
-                  return Fail(ErrorCode::InvalidEscape, nullptr, "Invalid hex in unicode escape");
-                }
-                codePoint = (codePoint << 4) | static_cast<std::uint32_t>(hv);
-              }
-              if (codePoint >= 0xD800 && codePoint <= 0xDBFF)
-              {
-                // Expect low surrogate
-                if (!(Peek() == '\\' && mPos + 1 < mSrc.size() && mSrc[mPos + 1] == 'u'))
-                {
-                  return Fail(ErrorCode::InvalidEscape, nullptr, "Unpaired surrogate");
-                }
-                Get(); // '\'
-                Get(); // 'u'
-                std::uint32_t lowSurrogate = 0;
-                for (std::size_t index = 0; index < 4; ++index)
-                {
-                  if (EndOfFile())
-                    return Fail(ErrorCode::InvalidEscape, nullptr, "Incomplete unicode escape");
-                  int hexValue = HexValue(Get());
-                  if (hexValue < 0)
-                  {
-                    return Fail(ErrorCode::InvalidEscape, nullptr, "Invalid hex in unicode escape");
-                  }
-                  lowSurrogate = (lowSurrogate << 4) | static_cast<std::uint32_t>(hexValue);
-                }
-                if (lowSurrogate < 0xDC00 || lowSurrogate > 0xDFFF)
-                {
-                  return Fail(ErrorCode::InvalidEscape, nullptr, "Invalid low surrogate");
-                }
-                codePoint = 0x10000 + (((codePoint - 0xD800) << 10) | (lowSurrogate - 0xDC00));
-              }
-              else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF)
-              {
-                return Fail(ErrorCode::InvalidEscape, nullptr, "Unpaired surrogate");
-              }
-              AppendUTF8(result, codePoint);
-              break;
-            }
-            default: return Fail(ErrorCode::InvalidEscape, nullptr, "Invalid escape in string");
-          }
-        }
-        else if (c == '\n' || c == '\r')
+        return *member;
+      }
+      throw std::out_of_range("LosslessValue::at: key not found");
+    }
+
+    LosslessValue& at(std::string_view key)
+    {
+      LosslessValue& member = const_cast<LosslessValue&>(std::as_const(*this).at(key));
+      dirty = true;
+      member.dirty = true;
+      return member;
+    }
+
+    LosslessValue& at(std::size_t index)
+    {
+      LosslessValue& item = arrayItems.at(index);
+      dirty = true;
+      item.dirty = true;
+      return item;
+    }
+
+    const LosslessValue& at(std::size_t index) const
+    {
+      return arrayItems.at(index);
+    }
+  };
+
+  namespace detail
+  {
+    // LosslessValue::sourceShape of value: kind (scalar / array / object), number of children and comment lines
+    inline std::uint64_t LosslessShape(const LosslessValue& value)
+    {
+      const std::uint64_t kind = value.isArray() ? 1 : value.isObject() ? 2 : 0;
+      const std::uint64_t comments = value.leadingComments.size() + value.trailingComments.size();
+      return kind << 62 | static_cast<std::uint64_t>(value.size()) << 32 | comments << 1 | !value.inlineComment.empty();
+    }
+
+    // Index of the first byte at or after index with the high bit set (size if the rest is ASCII)
+    inline std::size_t SkipASCII(const char* data, std::size_t index, std::size_t size)
+    {
+#if defined(__AVX2__)
+      for (; index + 64 <= size; index += 64)
+      {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index + 32));
+        if (_mm256_movemask_epi8(_mm256_or_si256(a, b)) != 0)
         {
-          return Fail(ErrorCode::UnterminatedString, nullptr, "Newline in string literal");
+          break;
         }
-        else
+      }
+      for (; index + 32 <= size; index += 32)
+      {
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index))));
+        if (mask != 0)
         {
-          result.push_back(c);
+          return index + static_cast<std::size_t>(std::countr_zero(mask));
         }
       }
-      return Fail(ErrorCode::UnterminatedString, nullptr, "Unterminated string literal");
-    }
-
-    ErrorCode ParseStringSingle(Value& out)
-    {
-      if (!Match('\''))
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+      for (; index + 64 <= size; index += 64)
       {
-        return Fail(ErrorCode::InternalError, nullptr);
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index + 16));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index + 32));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index + 48));
+        if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d))) != 0)
+        {
+          break;
+        }
       }
-      std::string result;
-      while (!EndOfFile())
+      for (; index + 16 <= size; index += 16)
       {
-        char c = Get();
-        if (c == '\'')
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index))));
+        if (mask != 0)
         {
-          out = std::move(result);
-          return ErrorCode::OK;
+          return index + static_cast<std::size_t>(std::countr_zero(mask));
         }
-        if (c == '\\')
+      }
+#elif defined(__aarch64__) || defined(_M_ARM64)
+      for (; index + 64 <= size; index += 64)
+      {
+        const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(data + index);
+        uint8x16_t any = vorrq_u8(vorrq_u8(vld1q_u8(bytes), vld1q_u8(bytes + 16)), vorrq_u8(vld1q_u8(bytes + 32), vld1q_u8(bytes + 48)));
+        if (vmaxvq_u8(any) >= 0x80)
         {
-          if (EndOfFile())
-          {
-            return Fail(ErrorCode::UnterminatedString, nullptr);
-          }
-          char e = Get();
-          switch (e)
-          {
-            case '\'': result.push_back('\''); break;
-            case '\\': result.push_back('\\'); break;
-            case 'n': result.push_back('\n'); break;
-            case 'r': result.push_back('\r'); break;
-            case 't': result.push_back('\t'); break;
-            case 'u':
-            {
-              std::uint32_t codePoint = 0;
-              for (std::size_t index = 0; index < 4; ++index)
-              {
-                if (EndOfFile())
-                {
-                  return Fail(ErrorCode::InvalidEscape, nullptr, "Incomplete unicode escape");
-                }
-                int hexValue = HexValue(Get());
-                if (hexValue < 0)
-                {
-                  return Fail(ErrorCode::InvalidEscape, nullptr, "Invalid hex in unicode escape");
-                }
-                codePoint = (codePoint << 4) | static_cast<std::uint32_t>(hexValue);
-              }
-              if (codePoint >= 0xD800 && codePoint <= 0xDBFF)
-              {
-                if (!(Peek() == '\\' && mPos + 1 < mSrc.size() && mSrc[mPos + 1] == 'u'))
-                {
-                  return Fail(ErrorCode::InvalidEscape, nullptr, "Unpaired surrogate");
-                }
-                Get();
-                Get();
-                std::uint32_t lowSurrogate = 0;
-                for (std::size_t index = 0; index < 4; ++index)
-                {
-                  if (EndOfFile())
-                  {
-                    return Fail(ErrorCode::InvalidEscape, nullptr, "Incomplete unicode escape");
-                  }
-                  int hexValue = HexValue(Get());
-                  if (hexValue < 0)
-                  {
-                    return Fail(ErrorCode::InvalidEscape, nullptr, "Invalid hex in unicode escape");
-                  }
-                  lowSurrogate = (lowSurrogate << 4) | static_cast<std::uint32_t>(hexValue);
-                }
-                if (lowSurrogate < 0xDC00 || lowSurrogate > 0xDFFF)
-                {
-                  return Fail(ErrorCode::InvalidEscape, nullptr, "Invalid low surrogate");
-                }
-                codePoint = 0x10000 + (((codePoint - 0xD800) << 10) | (lowSurrogate - 0xDC00));
-              }
-              else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF)
-              {
-                return Fail(ErrorCode::InvalidEscape, nullptr, "Unpaired surrogate");
-              }
-              AppendUTF8(result, codePoint);
-              break;
-            }
-            default: return Fail(ErrorCode::InvalidEscape, nullptr, "Invalid escape in string");
-          }
+          break;
         }
-        else if (c == '\n' || c == '\r')
+      }
+      for (; index + 16 <= size; index += 16)
+      {
+        if (vmaxvq_u8(vld1q_u8(reinterpret_cast<const std::uint8_t*>(data + index))) >= 0x80)
         {
-          return Fail(ErrorCode::UnterminatedString, nullptr, "Newline in string literal");
+          break;
         }
-        else
+      }
+#endif
+      // Scalar tail (and fallback): 8 bytes at a time, then byte-wise
+      for (; index + 8 <= size; index += 8)
+      {
+        std::uint64_t word = 0;
+        std::memcpy(&word, data + index, 8);
+        if ((word & 0x8080808080808080ULL) != 0)
         {
-          result.push_back(c);
+          break;
         }
       }
-      return Fail(ErrorCode::UnterminatedString, nullptr, "Unterminated string literal");
+      while (index < size && static_cast<unsigned char>(data[index]) < 0x80)
+      {
+        ++index;
+      }
+      return index;
     }
 
-    ErrorCode ParseTripleString(Value& out)
+    // Index of the first quote, backslash, CR or LF at or after index (size if there is none); the bytes before it can
+    // be copied out of a quoted literal as they are
+    inline std::size_t FindStringSpecial(const char* data, std::size_t index, std::size_t size, char quote)
     {
-      // Consume initial """
-      if (!(Match('"') && Match('"') && Match('"')))
+#if defined(__AVX2__)
+      const __m256i quotes = _mm256_set1_epi8(quote);
+      const __m256i backslashes = _mm256_set1_epi8('\\');
+      const __m256i returns = _mm256_set1_epi8('\r');
+      const __m256i newlines = _mm256_set1_epi8('\n');
+      for (; index + 32 <= size; index += 32)
       {
-        return Fail(ErrorCode::InternalError, nullptr);
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index));
+        __m256i hits = _mm256_or_si256(
+          _mm256_or_si256(_mm256_cmpeq_epi8(block, quotes), _mm256_cmpeq_epi8(block, backslashes)),
+          _mm256_or_si256(_mm256_cmpeq_epi8(block, returns), _mm256_cmpeq_epi8(block, newlines)));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits));
+        if (mask != 0)
+        {
+          return index + static_cast<std::size_t>(std::countr_zero(mask));
+        }
       }
-      std::string result;
-      while (!EndOfFile())
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+      const __m128i quotes = _mm_set1_epi8(quote);
+      const __m128i backslashes = _mm_set1_epi8('\\');
+      const __m128i returns = _mm_set1_epi8('\r');
+      const __m128i newlines = _mm_set1_epi8('\n');
+      for (; index + 16 <= size; index += 16)
       {
-        if (Peek() == '"' && mPos + 2 < mSrc.size() && mSrc[mPos + 1] == '"' && mSrc[mPos + 2] == '"')
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index));
+        __m128i hits = _mm_or_si128(
+          _mm_or_si128(_mm_cmpeq_epi8(block, quotes), _mm_cmpeq_epi8(block, backslashes)),
+          _mm_or_si128(_mm_cmpeq_epi8(block, returns), _mm_cmpeq_epi8(block, newlines)));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+        if (mask != 0)
         {
-          // End
-          Get();
-          Get();
-          Get();
-          out = std::move(result);
-          return ErrorCode::OK;
+          return index + static_cast<std::size_t>(std::countr_zero(mask));
         }
-        result.push_back(Get());
       }
-      return Fail(ErrorCode::UnterminatedTripleString, nullptr, "Unterminated triple string literal");
-    }
-
-    ErrorCode ParseNumber(Value& out)
-    {
-      std::size_t start = mPos;
-      bool hasDot = false;
-      bool hasExp = false;
-
-      if (Peek() == '+' || Peek() == '-')
-      {
-        Get();
-      }
-
-      while (!EndOfFile())
+#elif defined(__aarch64__) || defined(_M_ARM64)
+      const uint8x16_t quotes = vdupq_n_u8(static_cast<std::uint8_t>(quote));
+      for (; index + 16 <= size; index += 16)
       {
-        char c = Peek();
-        if (c >= '0' && c <= '9')
-        {
-          Get();
-        }
-        else if (c == '.' && !hasDot)
-        {
-          hasDot = true;
-          Get();
-        }
-        else if ((c == 'e' || c == 'E') && !hasExp)
+        uint8x16_t block = vld1q_u8(reinterpret_cast<const std::uint8_t*>(data + index));
+        uint8x16_t hits = vorrq_u8(
+          vorrq_u8(vceqq_u8(block, quotes), vceqq_u8(block, vdupq_n_u8('\\'))),
+          vorrq_u8(vceqq_u8(block, vdupq_n_u8('\r')), vceqq_u8(block, vdupq_n_u8('\n'))));
+        if (vmaxvq_u8(hits) != 0)
         {
-          hasExp = true;
-          Get();
-          if (Peek() == '+' || Peek() == '-')
-          {
-            Get();
-          }
+          break;
         }
-        else
+      }
+#endif
+      // Scalar tail (and fallback): 8 bytes at a time with the has-zero-byte test on word ^ pattern, then byte-wise
+      auto hasByte = [](std::uint64_t word, char c) {
+        const std::uint64_t x = word ^ (0x0101010101010101ULL * static_cast<unsigned char>(c));
+        return ((x - 0x0101010101010101ULL) & ~x & 0x8080808080808080ULL) != 0;
+      };
+      for (; index + 8 <= size; index += 8)
+      {
+        std::uint64_t word = 0;
+        std::memcpy(&word, data + index, 8);
+        if (hasByte(word, quote) || hasByte(word, '\\') || hasByte(word, '\r') || hasByte(word, '\n'))
         {
           break;
         }
       }
-
-      std::string_view stringView(mSrc.data() + start, mPos - start);
-      char* endPtr = nullptr;
-      std::string tempValue(stringView.begin(), stringView.end());
-      double value = std::strtod(tempValue.c_str(), &endPtr);
-      if (!endPtr || *endPtr != '\0')
+      while (index < size && data[index] != quote && data[index] != '\\' && data[index] != '\r' && data[index] != '\n')
       {
-        return Fail(ErrorCode::InvalidNumber, nullptr, "Invalid number literal");
+        ++index;
       }
-      out = value;
-      return ErrorCode::OK;
+      return index;
     }
 
-    ErrorCode ParseInlineObject(Value& out, int currentIndent)
-    {
-      if (!Match('{'))
-      {
-        return Fail(ErrorCode::InternalError, nullptr);
-      }
-      Object object;
-      SkipWhitespaceAndComments();
-      if (Match('}'))
+    // Escape written for each byte by WriteStringQuoted: 0 copies it as is, 'u' writes \u00XX, anything else is the
+    // letter after the backslash. Covers every control character, so the output is valid JSON as well as CSON.
+    inline constexpr auto kEscapeTable = [] {
+      std::array<char, 256> table{};
+      for (std::size_t c = 0; c < 0x20; ++c)
       {
-        out = std::move(object);
-        return ErrorCode::OK;
+        table[c] = 'u';
       }
-      while (true)
+      table['"'] = '"';
+      table['\\'] = '\\';
+      table['\n'] = 'n';
+      table['\r'] = 'r';
+      table['\t'] = 't';
+      return table;
+    }();
+
+    // Index of the first byte at or after index that kEscapeTable escapes (a quote, backslash or control character),
+    // or size if there is none
+    inline std::size_t FindEscapeNeeded(const char* data, std::size_t index, std::size_t size)
+    {
+#if defined(__AVX2__)
+      const __m256i quotes = _mm256_set1_epi8('"');
+      const __m256i backslashes = _mm256_set1_epi8('\\');
+      const __m256i controls = _mm256_set1_epi8(0x1F);
+      for (; index + 32 <= size; index += 32)
       {
-        std::string key;
-        ErrorCode errorCode = ParseKey(key);
-        if (errorCode != ErrorCode::OK)
-        {
-          return errorCode;
-        }
-        SkipWhitespaceAndComments();
-        if (!Match(':'))
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index));
+        __m256i hits = _mm256_or_si256(
+          _mm256_or_si256(_mm256_cmpeq_epi8(block, quotes), _mm256_cmpeq_epi8(block, backslashes)),
+          _mm256_cmpeq_epi8(_mm256_min_epu8(block, controls), block));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits));
+        if (mask != 0)
         {
-          return Fail(ErrorCode::UnexpectedChar, nullptr, "Expected ':' in object");
+          return index + static_cast<std::size_t>(std::countr_zero(mask));
         }
-        SkipWhitespaceAndComments();
-        Value value;
-        errorCode = ParseValue(value, currentIndent);
-        if (errorCode != ErrorCode::OK)
+      }
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+      const __m128i quotes = _mm_set1_epi8('"');
+      const __m128i backslashes = _mm_set1_epi8('\\');
+      const __m128i controls = _mm_set1_epi8(0x1F);
+      for (; index + 16 <= size; index += 16)
+      {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index));
+        __m128i hits = _mm_or_si128(
+          _mm_or_si128(_mm_cmpeq_epi8(block, quotes), _mm_cmpeq_epi8(block, backslashes)),
+          _mm_cmpeq_epi8(_mm_min_epu8(block, controls), block));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+        if (mask != 0)
         {
-          return errorCode;
+          return index + static_cast<std::size_t>(std::countr_zero(mask));
         }
-        object.emplace(std::move(key), std::move(value));
-        SkipWhitespaceAndComments();
-        if (Match('}'))
+      }
+#elif defined(__aarch64__) || defined(_M_ARM64)
+      for (; index + 16 <= size; index += 16)
+      {
+        uint8x16_t block = vld1q_u8(reinterpret_cast<const std::uint8_t*>(data + index));
+        uint8x16_t hits = vorrq_u8(
+          vorrq_u8(vceqq_u8(block, vdupq_n_u8('"')), vceqq_u8(block, vdupq_n_u8('\\'))), vcltq_u8(block, vdupq_n_u8(0x20)));
+        if (vmaxvq_u8(hits) != 0)
         {
           break;
         }
-        if (Peek() == '#')
-        {
-          SkipToEOL();
-          SkipWhitespaceAndComments();
-          if (Match('}'))
-          {
-            break;
-          }
-        }
-        if (Match(','))
+      }
+#endif
+      // Scalar tail (and fallback): the has-zero-byte test for quote / backslash plus the has-byte-below-0x20 test
+      auto hasByte = [](std::uint64_t word, char c) {
+        const std::uint64_t x = word ^ (0x0101010101010101ULL * static_cast<unsigned char>(c));
+        return ((x - 0x0101010101010101ULL) & ~x & 0x8080808080808080ULL) != 0;
+      };
+      for (; index + 8 <= size; index += 8)
+      {
+        std::uint64_t word = 0;
+        std::memcpy(&word, data + index, 8);
+        if (hasByte(word, '"') || hasByte(word, '\\') || ((word - 0x2020202020202020ULL) & ~word & 0x8080808080808080ULL) != 0)
         {
-          SkipWhitespaceAndComments();
-          continue;
+          break;
         }
-        return Fail(ErrorCode::UnexpectedChar, nullptr, "Expected ',' or '}' in object");
       }
-      out = std::move(object);
-      return ErrorCode::OK;
+      while (index < size && kEscapeTable[static_cast<unsigned char>(data[index])] == 0)
+      {
+        ++index;
+      }
+      return index;
     }
+  } // namespace detail
 
-    ErrorCode ParseIndentedObjectBody(Object& object, int parentIndent)
+  // Event interface for Parser::ParseEvents / ParseEvents(). Derive from EventHandler and hide the callbacks you need
+  // (calls are resolved statically); return false from any callback to stop with ErrorCode::Aborted. String / key
+  // views are only valid for the duration of the call.
+  //
+  // A handler may also provide bool OnScalar(std::size_t offset, LocationEntry where): quoted strings and numbers are
+  // then only checked (not decoded) and reported by the offset / location of their first character instead of through
+  // OnString / OnNumber. With bool OnNumber(double value, std::string_view literal) numbers also come with their source
+  // text (exact integers beyond 2^53), and with bool OnEmptyDocument() an empty document calls that instead of OnNull.
+  struct EventHandler
+  {
+    bool OnNull()
     {
-      // We assume we're currently on the line that already has the first key at indent == mIndentStack.back() (>=
-      // parentIndent). The object spans lines at the current indent; deeper indents belong to child values.
-      int bodyIndent = -1; // Will be set after parsing first key
+      return true;
+    }
 
-      while (true)
+    bool OnBool(bool)
+    {
+      return true;
+    }
+
+    bool OnNumber(double)
+    {
+      return true;
+    }
+
+    bool OnString(std::string_view)
+    {
+      return true;
+    }
+
+    bool OnArrayStart()
+    {
+      return true;
+    }
+
+    bool OnArrayEnd()
+    {
+      return true;
+    }
+
+    bool OnObjectStart()
+    {
+      return true;
+    }
+
+    bool OnKey(std::string_view)
+    {
+      return true;
+    }
+
+    bool OnObjectEnd()
+    {
+      return true;
+    }
+  };
+
+  namespace detail
+  {
+    // Spare strings / containers taken from a tree that is about to be replaced. They are handed out again in the order
+    // they were built, so reparsing a document of similar shape gets containers back with the capacity they need.
+    class ValueRecycler
+    {
+    public:
+      void Harvest(Value& value)
       {
-        // Set bodyIndent on first iteration
-        if (bodyIndent == -1)
-        {
-          bodyIndent = mIndentStack.back();
-        }
-        SkipInlineSpaces();
-        if (EndOfFile())
+        if (auto* string = std::get_if<std::string>(&value))
         {
-          break;
+          Keep(std::move(*string));
         }
-
-        // Skip blank / comment lines inside an object body
-        if (Peek() == '#' || Peek() == '\r' || Peek() == '\n')
+        else if (auto* array = std::get_if<Array>(&value))
         {
-          bool hasLine = false;
-          ErrorCode ec = NextContentLine(hasLine);
-          if (ec != ErrorCode::OK)
-          {
-            return ec;
-          }
-          if (!hasLine)
-          {
-            break; // EOF
-          }
-          if (mIndentStack.back() < bodyIndent)
+          // Reserve the container's place before its children so the lists follow build order
+          const std::size_t position = mArrays.size();
+          mArrays.emplace_back();
+          for (Value& element : *array)
           {
-            break;
+            Harvest(element);
           }
-          continue;
+          array->clear();
+          mArrays[position] = std::move(*array);
         }
-
-        char c = Peek();
-        if (!IsIdentifierStart(c) && c != '"' && c != '\'')
+        else if (auto* object = std::get_if<Object>(&value))
         {
-          // Probably end of this block (dedent handled by caller)
-          break;
+          const std::size_t position = mObjects.size();
+          mObjects.emplace_back();
+          object->drain([&](std::string&& key, Value& member) {
+            Keep(std::move(key));
+            Harvest(member);
+          });
+          mObjects[position] = std::move(*object);
         }
+        value = nullptr;
+      }
 
-        std::string key;
-        ErrorCode errorCode = ParseKey(key);
-        if (errorCode != ErrorCode::OK)
+      template <typename T>
+      T Take()
+      {
+        if constexpr (std::is_same_v<T, Array>)
         {
-          return errorCode;
+          return mNextArray < mArrays.size() ? std::move(mArrays[mNextArray++]) : Array();
         }
-
-        SkipInlineSpaces();
-        if (!Match(':'))
+        else
         {
-          return Fail(ErrorCode::UnexpectedChar, nullptr, "Expected ':' in object pair");
+          return mNextObject < mObjects.size() ? std::move(mObjects[mNextObject++]) : Object();
         }
-        SkipInlineSpaces();
+      }
 
-        // Comment immediately after ':' -> treat as block value starting on next line
-        if (Peek() == '#')
+      // Short strings fit the SSO buffer and are neither kept nor handed out
+      std::string TakeString(std::string_view text)
+      {
+        if (text.size() <= kInlineCapacity || mNextString == mStrings.size())
         {
-          SkipToEOL();
-
-          bool hasLine = false;
-          ErrorCode errorCode2 = NextContentLine(hasLine);
-          if (errorCode2 != ErrorCode::OK)
-          {
-            return errorCode2;
-          }
+          return std::string(text);
+        }
+        std::string string = std::move(mStrings[mNextString++]);
+        string.assign(text);
+        return string;
+      }
 
-          if (!hasLine)
-          {
-            return Fail(ErrorCode::InconsistentIndent, nullptr, "Expected indented block after ':'");
-          }
+      // Drop the spares (keeping the lists' own capacity)
+      void Clear()
+      {
+        mArrays.clear();
+        mObjects.clear();
+        mStrings.clear();
+        mNextArray = 0;
+        mNextObject = 0;
+        mNextString = 0;
+      }
 
-          if (mIndentStack.back() <= bodyIndent)
-          {
-            return Fail(ErrorCode::InconsistentIndent, nullptr, "Expected deeper indentation for block value");
-          }
+    private:
+      inline static const std::size_t kInlineCapacity = std::string().capacity();
 
-          Value value;
-          errorCode2 = ParseValue(value, mIndentStack.back());
-          if (errorCode2 != ErrorCode::OK)
-          {
-            return errorCode2;
-          }
-          object.emplace(std::move(key), std::move(value));
+      std::vector<Array> mArrays;
+      std::vector<Object> mObjects;
+      std::vector<std::string> mStrings;
+      std::size_t mNextArray = 0;
+      std::size_t mNextObject = 0;
+      std::size_t mNextString = 0;
 
-          if (mIndentStack.back() < bodyIndent)
-          {
-            break;
-          }
-          continue;
+      void Keep(std::string&& string)
+      {
+        if (string.capacity() > kInlineCapacity)
+        {
+          mStrings.push_back(std::move(string));
         }
+      }
+    };
 
-        Value value;
+    // Builds a Value / pmr::Value / borrowed::Value tree from parser events, constructing each value in place in its
+    // parent. Like emplace, a duplicate key keeps its first value (the later one is skipped).
+    template <typename ValueT>
+    class ValueBuilder : public EventHandler
+    {
+    public:
+      using StringType = typename ValueT::StringType;
+      using ArrayType = typename ValueT::ArrayType;
+      using ObjectType = typename ValueT::ObjectType;
+
+      // resource binds allocator-aware (pmr) strings / containers; ownedStrings and source are used by borrowed trees;
+      // stack (if given) is used for the open containers so a reused parser keeps its capacity; recycler (Value trees
+      // only) supplies strings / containers of a previous tree
+      explicit ValueBuilder(
+        ValueT& root,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+        std::deque<std::string>* ownedStrings = nullptr,
+        std::string_view source = {},
+        std::vector<ValueT*>* stack = nullptr,
+        ValueRecycler* recycler = nullptr)
+        : mRoot(root),
+          mResource(resource),
+          mOwnedStrings(ownedStrings),
+          mSource(source),
+          mStack(stack ? *stack : mOwnStack),
+          mRecycler(recycler)
+      {
+        mStack.clear();
+      }
 
-        // If nothing else on the line -> block value (object / array) on next indented line
-        if (Peek() == '\r' || Peek() == '\n')
-        {
-          // Consume EOL
-          char c2 = Get();
-          if (c2 == '\r' && Peek() == '\n')
-          {
-            Get();
-          }
+      bool OnNull()
+      {
+        return Store(nullptr);
+      }
 
-          bool hasLine = false;
-          ErrorCode errorCode2 = NextContentLine(hasLine);
-          if (errorCode2 != ErrorCode::OK)
-          {
-            return errorCode2;
-          }
+      bool OnBool(bool value)
+      {
+        return Store(value);
+      }
 
-          if (!hasLine)
-          {
-            return Fail(ErrorCode::InconsistentIndent, nullptr, "Expected indented block after ':'");
-          }
+      bool OnNumber(double value)
+      {
+        return Store(value);
+      }
 
-          // Indent stack already updated; current indent = mIndentStack.back()
-          if (mIndentStack.back() <= bodyIndent)
-          {
-            return Fail(ErrorCode::InconsistentIndent, nullptr, "Expected deeper indentation for block value");
-          }
+      bool OnString(std::string_view value)
+      {
+        if (mSkipDepth > 0)
+        {
+          return true;
+        }
+        if (ValueT* slot = NextSlot())
+        {
+          *slot = MakeString(value);
+        }
+        return true;
+      }
 
-          // Recursively parse value at new indent level
-          errorCode2 = ParseValue(value, mIndentStack.back());
-          if (errorCode2 != ErrorCode::OK)
-          {
-            return errorCode2;
-          }
+      bool OnArrayStart()
+      {
+        return Open(Make<ArrayType>());
+      }
 
-          // After parsing block value, check if we've dedented (nextContentLine was called inside the recursive parse)
-          object.emplace(std::move(key), std::move(value));
+      bool OnArrayEnd()
+      {
+        return Close();
+      }
 
-          // Check current indent level - if we've dedented out of this object, we're done
-          if (mIndentStack.back() < bodyIndent)
-          {
-            break;
-          }
+      bool OnObjectStart()
+      {
+        return Open(Make<ObjectType>());
+      }
 
-          // Otherwise continue parsing more keys at this level
-          continue;
-        }
-        else
+      bool OnKey(std::string_view key)
+      {
+        if (mSkipDepth > 0)
         {
-          // Inline value on same line
-          errorCode = ParseValue(value, parentIndent);
-          if (errorCode != ErrorCode::OK)
-          {
-            return errorCode;
-          }
+          return true;
         }
+        auto [it, inserted] = std::get<ObjectType>(*mStack.back()).try_emplace(MakeString(key));
+        mKeySlot = inserted ? &it->second : nullptr;
+        return true;
+      }
 
-        object.emplace(std::move(key), std::move(value));
+      bool OnObjectEnd()
+      {
+        return Close();
+      }
 
-        // End of line or another entry on same line (comma separated)
-        SkipInlineSpaces();
-        if (Peek() == '#')
+    private:
+      ValueT& mRoot;
+      std::pmr::memory_resource* mResource;
+      std::deque<std::string>* mOwnedStrings;
+      std::string_view mSource;
+      std::vector<ValueT*> mOwnStack;
+      std::vector<ValueT*>& mStack; // Open containers
+      ValueRecycler* mRecycler;
+      ValueT* mKeySlot = nullptr; // Value slot of the last key (nullptr -> duplicate key)
+      std::size_t mSkipDepth = 0; // > 0 while inside the skipped value of a duplicate key
+
+      template <typename T>
+      T Make()
+      {
+        if constexpr (std::uses_allocator_v<T, std::pmr::polymorphic_allocator<char>>)
         {
-          SkipToEOL();
-          bool hasLine = false;
-          ErrorCode errorCode2 = NextContentLine(hasLine);
-          if (errorCode2 != ErrorCode::OK)
-          {
-            return errorCode2;
-          }
-          if (!hasLine)
-          {
-            break; // EOF
-          }
-          if (mIndentStack.back() < bodyIndent)
-          {
-            break;
-          }
-          continue;
+          return T(mResource);
         }
-        if (Match(','))
+        else if constexpr (std::is_same_v<ValueT, Value>)
         {
-          SkipInlineSpaces();
-          // Next key / value on same line
-          continue;
+          return mRecycler ? mRecycler->Take<T>() : T();
+        }
+        else
+        {
+          return T();
         }
+      }
 
-        // If we hit newline, move to next content line and see whether indent still belongs to this object or a parent
-        if (Peek() == '\r' || Peek() == '\n')
+      StringType MakeString(std::string_view value)
+      {
+        if constexpr (std::is_same_v<StringType, std::string_view>)
         {
-          char c2 = Get();
-          if (c2 == '\r' && Peek() == '\n')
+          // Views into the source are kept; decoded literals (parser scratch) get owned storage
+          std::less_equal<const char*> lessEqual;
+          if (lessEqual(mSource.data(), value.data()) && lessEqual(value.data() + value.size(), mSource.data() + mSource.size()))
           {
-            Get();
+            return value;
           }
-
-          bool hasLine = false;
-          ErrorCode errorCode2 = NextContentLine(hasLine);
-          if (errorCode2 != ErrorCode::OK)
-          {
-            return errorCode2;
-          }
-          if (!hasLine)
-          {
-            break; // EOF
-          }
-
-          // If we dedented to or below the body's indent, the object ends
-          if (mIndentStack.back() < bodyIndent)
-          {
-            break;
-          }
-
-          // Still inside this object; loop continues with new line
-          continue;
+          return mOwnedStrings->emplace_back(value);
+        }
+        else if constexpr (std::uses_allocator_v<StringType, std::pmr::polymorphic_allocator<char>>)
+        {
+          return StringType(value, mResource);
+        }
+        else if constexpr (std::is_same_v<ValueT, Value>)
+        {
+          return mRecycler ? mRecycler->TakeString(value) : StringType(value);
+        }
+        else
+        {
+          return StringType(value);
         }
-
-        // Otherwise (e.g., end of file or delimiters), let caller decide
-        break;
       }
 
-      return ErrorCode::OK;
-    }
-
-    ErrorCode ParseArray(Value& out, int parentIndent)
-    {
-      if (!Match('['))
+      // Slot for the next value: the root, a new array element or the last key's value
+      ValueT* NextSlot()
       {
-        return Fail(ErrorCode::InternalError, nullptr);
+        if (mStack.empty())
+        {
+          return &mRoot;
+        }
+        if (auto* array = std::get_if<ArrayType>(mStack.back()))
+        {
+          array->emplace_back();
+          return &array->back();
+        }
+        return mKeySlot;
       }
 
-      Array array;
-
-      // Check if this is a multiline array (newline after '[')
-      SkipInlineSpaces();
-      bool isMultiline = (Peek() == '\r' || Peek() == '\n');
-
-      if (isMultiline)
+      template <typename T>
+      bool Store(T&& value)
       {
-        // Consume the newline and position at first element
-        char c = Get();
-        if (c == '\r' && Peek() == '\n')
+        if (mSkipDepth > 0)
         {
-          Get();
+          return true;
+        }
+        if (ValueT* slot = NextSlot())
+        {
+          *slot = std::forward<T>(value);
         }
+        return true;
+      }
 
-        bool hasLine = false;
-        ErrorCode errorCode = NextContentLine(hasLine);
-        if (errorCode != ErrorCode::OK)
+      template <typename T>
+      bool Open(T&& container)
+      {
+        if (mSkipDepth > 0)
         {
-          return errorCode;
+          ++mSkipDepth;
+          return true;
         }
-        if (!hasLine || Peek() == ']')
+        ValueT* slot = NextSlot();
+        if (!slot)
         {
-          // Empty array or just closing bracket
-          if (Peek() == ']')
-          {
-            Get();
-          }
-          out = std::move(array);
-          return ErrorCode::OK;
+          mSkipDepth = 1;
+          return true;
         }
+        *slot = std::forward<T>(container);
+        mStack.push_back(slot);
+        return true;
+      }
 
-        // Parse multiline array elements
-        int arrayIndent = mIndentStack.back();
-        while (true)
+      bool Close()
+      {
+        if (mSkipDepth > 0)
         {
-          if (Peek() == ']')
-          {
-            Get();
-            break;
-          }
+          --mSkipDepth;
+          return true;
+        }
+        mStack.pop_back();
+        return true;
+      }
+    };
 
-          Value value;
-          errorCode = ParseValue(value, arrayIndent);
-          if (errorCode != ErrorCode::OK)
-          {
-            return errorCode;
-          }
-          array.push_back(std::move(value));
+    template <typename Handler>
+    concept SkipsScalars = requires(Handler& handler, std::size_t offset, LocationEntry where) {
+      { handler.OnScalar(offset, where) } -> std::convertible_to<bool>;
+    };
 
-          // After parsing, check if we've dedented out of the array
-          if (mIndentStack.back() < arrayIndent)
-          {
-            break;
-          }
+    template <typename Handler>
+    concept ReadsNumberLiterals = requires(Handler& handler, double value, std::string_view literal) {
+      { handler.OnNumber(value, literal) } -> std::convertible_to<bool>;
+    };
 
-          SkipInlineSpaces();
-          if (Peek() == '#')
-          {
-            SkipToEOL();
-            bool hasLine2 = false;
-            errorCode = NextContentLine(hasLine2);
-            if (errorCode != ErrorCode::OK)
-            {
-              return errorCode;
-            }
-            if (!hasLine2)
-            {
-              break;
-            }
-            if (mIndentStack.back() < arrayIndent)
-            {
-              break;
-            }
-            continue;
-          }
-          if (Match(']'))
-          {
-            break;
-          }
+    template <typename Handler>
+    concept SeesEmptyDocument = requires(Handler& handler) {
+      { handler.OnEmptyDocument() } -> std::convertible_to<bool>;
+    };
+  } // namespace detail
 
-          // Check for comma
-          if (Match(','))
-          {
-            SkipWhitespaceAndComments();
-            continue;
-          }
+  struct ParseOptions
+  {
+    // Input is known to be valid UTF-8 (e.g. written by WriteFile): skip validation and only work out line / column
+    // when an error is reported
+    bool trustedInput = false;
+
+    // Limits for untrusted input; exceeding one fails the parse with its ErrorCode. Unlimited by default.
+    std::size_t maxDepth = std::numeric_limits<std::size_t>::max(); // Value nesting (the root is 1) and indent levels
+    std::size_t maxStringLength = std::numeric_limits<std::size_t>::max(); // Decoded bytes of one string / key
+    std::size_t maxAllocatedBytes = std::numeric_limits<std::size_t>::max(); // Tree estimate: node per value + string bytes
+    std::size_t maxElements = std::numeric_limits<std::size_t>::max(); // Values in the document, containers included
+
+    // Keep open containers on a heap stack instead of the call stack, so the parse itself can't overflow the thread's
+    // stack whatever maxDepth is. Only the parse: destroying, copying, comparing, writing or diffing a Value recurses
+    // over its children, so keep maxDepth set when parsing into a tree; iterative alone suits ParseEvents handlers.
+    // Applies to the Value / event parser; ParseLossless always recurses.
+    bool iterative = false;
+  };
 
-          // Check for newline
-          if (Peek() == '\r' || Peek() == '\n')
-          {
-            c = Get();
-            if (c == '\r' && Peek() == '\n')
-            {
-              Get();
-            }
+  // Where the time of the last parse went (Parser::Stats(), ParseLossless). Only collected when havCSON is compiled
+  // with HAVCSON_ENABLE_STATS defined, otherwise it stays all zero; the per-phase timers read the clock around every
+  // literal / indent, so keep such builds for profiling and for spotting pathological inputs. The define may differ
+  // between translation units, but as it selects the library's inline namespace (HAVCSON_DETAIL_CONFIG_NAMESPACE)
+  // they then don't share havCSON types or functions: a Value parsed in one can't be handed to the other.
+  struct ParseStats
+  {
+    enum class Phase : std::uint8_t
+    {
+      Utf8Validation, // Up-front check of the whole source
+      Indentation, // Reading line indents (blank / comment lines included) and indent stack changes
+      Strings, // Scanning / decoding quoted and triple-quoted literals, keys included
+      Numbers, // Number literal conversion
+    };
 
-            // Use nextContentLine to properly handle indent stack
-            hasLine = false;
-            errorCode = NextContentLine(hasLine);
-            if (errorCode != ErrorCode::OK)
-            {
-              return errorCode;
-            }
-            if (!hasLine)
-            {
-              break;
-            }
+    struct PhaseStats
+    {
+      std::uint64_t calls = 0;
+      std::uint64_t bytes = 0; // Source bytes consumed
+      std::uint64_t nanoseconds = 0; // steady_clock time
+    };
 
-            // Check if we've dedented out of the array
-            if (mIndentStack.back() < arrayIndent)
-            {
-              break;
-            }
+    PhaseStats total; // Whole parse, phases included
+    std::array<PhaseStats, 4> phases{}; // Indexed by Phase
+    std::uint64_t values = 0; // Values parsed (containers included)
+    std::uint64_t decodedStrings = 0; // Literals that had to be decoded into the scratch buffer instead of viewed
+    std::uint64_t bufferGrowths = 0; // Times the parser's own buffers (decode scratch, indent stack) allocated
+    std::size_t maxDepth = 0; // Deepest value nesting (the root is 1)
 
-            // Continue to parse next element
-            continue;
-          }
+    const PhaseStats& phase(Phase which) const
+    {
+      return phases[static_cast<std::size_t>(which)];
+    }
+  };
 
-          return Fail(ErrorCode::UnexpectedChar, nullptr, "Expected ',' or ']' or newline in multiline array");
-        }
+  namespace detail
+  {
+    // Default of BasicParser's CollectStats
+#if defined(HAVCSON_ENABLE_STATS)
+    inline constexpr bool kCollectStats = true;
+#else
+    inline constexpr bool kCollectStats = false;
+#endif
 
-        if (Peek() == ']')
-        {
-          Get();
-        }
-      }
-      else
+    // Adds the calls, bytes (how far position moved) and time of its lifetime to a ParseStats phase
+    template <bool Enabled>
+    class BasicStatsScope
+    {
+    public:
+      BasicStatsScope(ParseStats::PhaseStats& phase, const std::size_t& position)
+        : mPhase(phase), mPosition(position), mStartPosition(position), mStart(std::chrono::steady_clock::now())
+      {}
+
+      ~BasicStatsScope()
       {
-        // Inline array
-        SkipWhitespaceAndComments();
-        if (Match(']'))
-        {
-          out = std::move(array);
-          return ErrorCode::OK;
-        }
+        const auto elapsed = std::chrono::steady_clock::now() - mStart;
+        ++mPhase.calls;
+        mPhase.bytes += mPosition >= mStartPosition ? mPosition - mStartPosition : 0;
+        mPhase.nanoseconds += static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+      }
 
-        while (true)
-        {
-          if (Peek() == ']')
-          {
-            Get();
-            break;
-          }
+      BasicStatsScope(const BasicStatsScope&) = delete;
+      BasicStatsScope& operator=(const BasicStatsScope&) = delete;
 
-          Value value;
-          ErrorCode errorCode = ParseValue(value, parentIndent);
-          if (errorCode != ErrorCode::OK)
-          {
-            return errorCode;
-          }
-          array.push_back(std::move(value));
+    private:
+      ParseStats::PhaseStats& mPhase;
+      const std::size_t& mPosition;
+      std::size_t mStartPosition;
+      std::chrono::steady_clock::time_point mStart;
+    };
 
-          SkipWhitespaceAndComments();
-          if (Match(']'))
-          {
-            break;
-          }
-          if (!Match(','))
-          {
-            return Fail(ErrorCode::UnexpectedChar, nullptr, "Expected ',' or ']' in inline array");
-          }
-          SkipWhitespaceAndComments();
-        }
-      }
+    // Statistics off: compiles to nothing
+    template <>
+    class BasicStatsScope<false>
+    {
+    public:
+      BasicStatsScope(ParseStats::PhaseStats&, const std::size_t&)
+      {}
 
-      out = std::move(array);
-      return ErrorCode::OK;
+      BasicStatsScope(const BasicStatsScope&) = delete;
+      BasicStatsScope& operator=(const BasicStatsScope&) = delete;
+    };
+  } // namespace detail
+
+  // Position tracking is a template parameter so it can be compiled out of Get() / Peek(): BasicParser<false> only
+  // advances the offset and derives line / column from it when a Location() is asked for (ParseOptions::trustedInput).
+  // So is statistics collection (see ParseStats): the stats paths only depend on CollectStats, and the layout is the
+  // same either way.
+  template <bool TrackPositions, bool CollectStats = detail::kCollectStats>
+  class BasicParser
+  {
+  public:
+    using StatsScope = detail::BasicStatsScope<CollectStats>;
+
+    BasicParser(std::string_view src, std::string_view filename = {}, const ParseOptions& options = {})
+      : mSrc(src), mFilename(filename), mOptions(options)
+    {}
+
+    ErrorCode Parse(Value& out, Error* error = nullptr)
+    {
+      return ParseTree(out, error);
     }
 
-    ErrorCode ParseKey(std::string& outKey)
+    // Parse into out, building the new tree from the strings / containers out currently holds so reparsing into an
+    // existing document reuses its capacity. out is null on failure.
+    ErrorCode ParseInPlace(Value& out, Error* error = nullptr)
     {
-      SkipInlineSpaces();
-      char c = Peek();
-      if (c == '"')
-      {
-        Value tempValue;
-        ErrorCode errorCode = ParseStringDouble(tempValue);
-        if (errorCode != ErrorCode::OK)
-        {
-          return errorCode;
-        }
-        outKey = std::get<std::string>(tempValue);
-        return ErrorCode::OK;
-      }
-      if (c == '\'')
-      {
-        Value tempValue;
-        ErrorCode errorCode = ParseStringSingle(tempValue);
-        if (errorCode != ErrorCode::OK)
-        {
-          return errorCode;
-        }
-        outKey = std::get<std::string>(tempValue);
-        return ErrorCode::OK;
-      }
-      if (!IsIdentifierStart(c))
-      {
-        return Fail(ErrorCode::UnexpectedChar, nullptr, "Expected identifier or string as key");
-      }
-      std::string ident;
-      while (IsIdentifierChar(Peek()))
+      mRecycler.Harvest(out);
+      detail::ValueBuilder<Value> builder(
+        out, std::pmr::get_default_resource(), nullptr, mSrc, &std::get<std::vector<Value*>>(mBuildStacks), &mRecycler);
+      ErrorCode errorCode = ParseEvents(builder, error);
+      if (errorCode != ErrorCode::OK)
       {
-        ident.push_back(Get());
+        out = nullptr;
       }
-      outKey = std::move(ident);
-      return ErrorCode::OK;
+      mRecycler.Clear();
+      return errorCode;
     }
-  };
 
-  inline ErrorCode Parse(std::string_view src, Value& out, Error* error = nullptr)
-  {
-    Parser p(src);
-    return p.Parse(out, error);
-  }
+    // Parse into an allocator-aware tree; every string / container of the result is allocated from resource
+    ErrorCode Parse(pmr::Value& out, std::pmr::memory_resource& resource, Error* error = nullptr)
+    {
+      return ParseTree(out, error, &resource);
+    }
 
-  namespace detail
-  {
-    // Lossless parser: preserves comment lines and ordering into LosslessValue
-    class LosslessParser : private Parser
+    // Parse into a borrowed tree: keys / strings without escapes point into the source, which must outlive out;
+    // decoded literals are appended to ownedStrings (element addresses stay stable)
+    ErrorCode Parse(borrowed::Value& out, std::deque<std::string>& ownedStrings, Error* error = nullptr)
     {
-    public:
-      explicit LosslessParser(std::string_view src) : Parser(src)
-      {}
+      return ParseTree(out, error, std::pmr::get_default_resource(), &ownedStrings);
+    }
 
-      ErrorCode Parse(LosslessValue& out, Error* error)
+    // Stream the document to handler (see EventHandler) without building a tree. Events of a value that fails later
+    // may already have been delivered.
+    template <typename Handler>
+    ErrorCode ParseEvents(Handler& handler, Error* error = nullptr)
+    {
+      // Reset previous error state for a fresh parse
+      mError = {};
+      ResetCounters();
+      [[maybe_unused]] StatsScope statsScope(mStats.total, mPos);
+
+      // Validate UTF-8 up front (strips leading BOM)
+      if (!ValidateSource())
       {
-        // Reset previous error state for a fresh parse
-        mError = {};
+        return Fail(ErrorCode::InvalidUtf8, error, "Invalid UTF-8 encoding");
+      }
 
-        // Validate UTF-8 up front (strips leading BOM)
-        std::size_t badIndex = 0;
-        std::size_t badLine = 1;
-        std::size_t badCol = 1;
-        bool hasBOM = mSrc.size() >= 3 && static_cast<unsigned char>(mSrc[0]) == 0xEF && static_cast<unsigned char>(mSrc[1]) == 0xBB &&
-          static_cast<unsigned char>(mSrc[2]) == 0xBF;
-        if (!ValidateUTF8(mSrc, true, badIndex, badLine, badCol))
-        {
-          mPos = badIndex;
-          mLine = badLine;
-          mCol = badCol;
-          return Finish(ErrorCode::InvalidUtf8, error, "Invalid UTF-8 encoding");
-        }
-        if (hasBOM)
+      SkipWhitespaceAndComments();
+      if (mPos >= mSrc.size())
+      {
+        // Empty document -> null
+        bool proceed = true;
+        if constexpr (detail::SeesEmptyDocument<Handler>)
         {
-          mPos = 3;
-          mCol = 1;
-          mLine = 1;
+          proceed = handler.OnEmptyDocument();
         }
-
-        bool hasLine = false;
-        ErrorCode errorCode = NextContentLineLossless(hasLine, mPendingComments);
-        if (errorCode != ErrorCode::OK)
+        else
         {
-          return Finish(errorCode, error);
+          proceed = handler.OnNull();
         }
-
-        if (!hasLine)
+        if (!proceed)
         {
-          return Finish(ErrorCode::UnexpectedEnd, error, "Empty document");
+          return Abort(error);
         }
-
-        errorCode = ParseValueLossless(out, 0);
+      }
+      else
+      {
+        ErrorCode errorCode = ParseValue(handler, 0);
         if (errorCode != ErrorCode::OK)
         {
-          return Finish(errorCode, error);
-        }
-
-        // After parsing top-level value, consume any remaining whitespace / comments and ensure we're back at indent
-        // level 0
-        while (!EndOfFile())
-        {
-          char c = Peek();
-          if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
-          {
-            Get();
-            continue;
-          }
-          if (c == '#')
+          if (error)
           {
-            SkipToEOL();
-            continue;
+            if (mError.code != ErrorCode::OK)
+            {
+              *error = mError;
+            }
+            else
+            {
+              error->code = errorCode;
+              error->where = Location();
+              error->message.clear();
+            }
           }
-          break;
+          return errorCode;
         }
+      }
 
-        // Any remaining pending comments belong after the root value
-        if (!mPendingComments.empty())
+      // After parsing top-level value, consume any remaining whitespace / comments and ensure we're back at indent
+      // level 0
+      while (!EndOfFile())
+      {
+        char c = Peek();
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
         {
-          out.trailingComments.insert(out.trailingComments.end(), mPendingComments.begin(), mPendingComments.end());
-          mPendingComments.clear();
+          Get();
+          continue;
         }
-
-        // Reset indent stack to base level
-        mIndentStack.clear();
-        mIndentStack.push_back(0);
-
-        if (!EndOfFile())
+        if (c == '#')
         {
-          return Finish(ErrorCode::UnexpectedChar, error, "Trailing characters after top-level value");
+          SkipToEOL();
+          continue;
         }
+        break;
+      }
 
-        if (error)
-        {
-          *error = {};
-        }
+      // Reset indent stack to base level
+      mIndentStack.clear();
+      mIndentStack.push_back(0);
 
-        return ErrorCode::OK;
+      if (mPos != mSrc.size())
+      {
+        return Fail(ErrorCode::UnexpectedChar, error, "Trailing characters after top-level value");
       }
+      if (error)
+      {
+        *error = {};
+      }
+      return ErrorCode::OK;
+    }
 
-    private:
-      std::vector<LosslessComment> mPendingComments;
+    const Error& LastError() const
+    {
+      return mError;
+    }
 
-      ErrorCode Finish(ErrorCode errorCode, Error* error, std::optional<std::string_view> message = std::nullopt)
+    // Statistics of the last parse (all zero unless compiled with HAVCSON_ENABLE_STATS)
+    const ParseStats& Stats() const
+    {
+      return mStats;
+    }
+
+    // Start over on src (e.g. the next request payload). The indent stack, decode scratch and tree-building stacks keep
+    // their capacity, so a parser reused this way only allocates for the values it produces.
+    void Reset(std::string_view src, std::string_view filename = {})
+    {
+      mSrc = src;
+      mFilename = filename;
+      SetPosition(0, 1, 1);
+      mIndentUnit = 0;
+      mIndentStack.assign(1, 0);
+      mError.code = ErrorCode::OK;
+      mError.where = {};
+      mError.message.clear();
+    }
+
+  protected:
+    std::string_view mSrc;
+    std::string_view mFilename;
+    std::size_t mPos = 0;
+    std::size_t mLine = 1; // Line / column of mPos, or of mOrigin without TrackPositions (moved up by Location())
+    std::size_t mCol = 1;
+    std::size_t mOrigin = 0;
+    ParseOptions mOptions;
+
+    // CoffeeScript-like indent model
+    int mIndentUnit = 0; // Discovered on first non-zero indent
+    std::vector<int> mIndentStack{0}; // Known indent levels (columns)
+
+    Error mError;
+    ParseStats mStats;
+
+    // Tallies of the current parse checked against the ParseOptions limits
+    std::size_t mDepth = 0; // Nesting of the value being parsed
+    std::size_t mValueCount = 0;
+    std::size_t mTreeBytes = 0; // Estimate for maxAllocatedBytes
+
+    std::size_t mStopAt = std::string_view::npos; // See ParseRootSpan
+    bool mStopped = false;
+
+    // Open container of the event parser: which Step function runs its members and where that continues once the
+    // child value it asked for is parsed. Kept in RunFrame's locals, or on mFrames with ParseOptions::iterative.
+    struct Frame
+    {
+      enum class Kind : std::uint8_t
       {
-        // Prefer existing detailed error (e.g., from base Fail) unless a new message is supplied
-        if (message.has_value())
-        {
-          mError.code = errorCode;
-          mError.where = Location();
-          mError.message.assign(message->data(), message->size());
-        }
-        else if (mError.code == ErrorCode::OK)
-        {
-          mError.code = errorCode;
-          mError.where = Location();
-          mError.message.clear();
-        }
+        InlineObject,
+        IndentedObject,
+        InlineArray,
+        MultilineArray,
+      };
+      enum class Resume : std::uint8_t
+      {
+        Start, // Loop top, no child parsed yet
+        AfterValue, // After an inline member value / an element
+        AfterBlockValue, // After a member value that started on its own indented line
+      };
 
-        if (error)
-        {
-          if (message.has_value())
-          {
-            error->code = errorCode;
-            error->where = Location();
-            error->message.assign(message->data(), message->size());
-          }
-          else if (mError.code != ErrorCode::OK)
-          {
-            *error = mError;
-          }
-          else
-          {
-            error->code = errorCode;
-            error->where = Location();
-            error->message.clear();
-          }
-        }
-        return errorCode;
-      }
+      Kind kind;
+      Resume resume;
+      int indent; // Indent the container was opened at; multiline arrays: indent of their element lines
+      int bodyIndent; // Indented objects: indent of their member lines
+    };
+    std::vector<Frame> mFrames;
 
-      // Collect comment / blank lines into out while advancing to the next content line
-      ErrorCode NextContentLineLossless(bool& hasLine, std::vector<LosslessComment>& comments)
+    // Decode buffer for literals with escapes; scanned string views may point here until the next scan
+    std::string mScratch;
+
+    void ResetCounters()
+    {
+      mStats = {};
+      mDepth = 0;
+      mValueCount = 0;
+      mTreeBytes = 0;
+      mFrames.clear();
+    }
+
+    // Count the value about to be parsed (a node of nodeBytes) against the limits; the caller decrements mDepth once
+    // the value is complete
+    ErrorCode EnterValue(std::size_t nodeBytes)
+    {
+      ++mDepth;
+      ++mValueCount;
+      mTreeBytes += nodeBytes;
+      if constexpr (CollectStats)
       {
-        hasLine = false;
-        while (!EndOfFile())
-        {
-          if (mCol != 1)
-          {
-            SkipToEOL();
-            if (EndOfFile())
-            {
-              return ErrorCode::OK;
-            }
-            continue;
-          }
+        ++mStats.values;
+        mStats.maxDepth = std::max(mStats.maxDepth, mDepth);
+      }
+      if (mDepth > mOptions.maxDepth)
+      {
+        return Fail(ErrorCode::DepthLimitExceeded, nullptr, "Values nest deeper than ParseOptions::maxDepth");
+      }
+      if (mValueCount > mOptions.maxElements)
+      {
+        return Fail(ErrorCode::TooManyElements, nullptr, "Document has more values than ParseOptions::maxElements");
+      }
+      return CheckTreeBytes();
+    }
 
-          int indentCols = 0;
-          bool hasContent = false;
-          std::size_t lineStart = mPos;
-          ErrorCode errorCode = ReadLineIndent(indentCols, hasContent);
-          if (errorCode != ErrorCode::OK)
-          {
-            return errorCode;
-          }
+    // Count a scanned string / key of length bytes against the limits
+    ErrorCode CheckString(std::size_t length)
+    {
+      if (length > mOptions.maxStringLength)
+      {
+        return Fail(ErrorCode::StringTooLong, nullptr, "String is longer than ParseOptions::maxStringLength");
+      }
+      mTreeBytes += length;
+      return CheckTreeBytes();
+    }
 
-          if (!hasContent)
-          {
-            std::string line(mSrc.data() + lineStart, mPos - lineStart);
-            while (!line.empty() && (line.back() == '\r' || line.back() == '\n'))
-            {
-              line.pop_back();
-            }
-            // Store indent and text after indent
-            LosslessComment losslessComment;
-            losslessComment.indent = indentCols;
-            if (static_cast<std::size_t>(indentCols) < line.size())
-            {
-              losslessComment.text = line.substr(static_cast<std::size_t>(indentCols));
-            }
-            else
-            {
-              losslessComment.text.clear(); // Blank line
-            }
-            comments.push_back(std::move(losslessComment));
-            continue;
-          }
+    ErrorCode CheckTreeBytes()
+    {
+      if (mTreeBytes > mOptions.maxAllocatedBytes)
+      {
+        return Fail(ErrorCode::AllocationLimitExceeded, nullptr, "Parsed values need more than ParseOptions::maxAllocatedBytes");
+      }
+      return ErrorCode::OK;
+    }
 
-          errorCode = ApplyIndentLevel(indentCols);
-          if (errorCode != ErrorCode::OK)
-          {
-            return errorCode;
-          }
+    StatsScope PhaseScope(ParseStats::Phase phase)
+    {
+      return StatsScope(mStats.phases[static_cast<std::size_t>(phase)], mPos);
+    }
 
-          hasLine = true;
-          return ErrorCode::OK;
-        }
-        return ErrorCode::OK; // EOF
+    // Count a capacity change of one of the parser's buffers (see ParseStats::bufferGrowths)
+    void NoteGrowth([[maybe_unused]] std::size_t capacityBefore, [[maybe_unused]] std::size_t capacityAfter)
+    {
+      if constexpr (CollectStats)
+      {
+        mStats.bufferGrowths += capacityAfter != capacityBefore;
       }
+    }
 
-      ErrorCode ParseValueLossless(LosslessValue& out, int currentIndent, bool consumePending = true)
+    // Open-container stacks of ParseTree, one per tree type, kept between parses
+    std::tuple<std::vector<Value*>, std::vector<pmr::Value*>, std::vector<borrowed::Value*>> mBuildStacks;
+
+    detail::ValueRecycler mRecycler; // Spares of the tree ParseInPlace replaces
+
+    template <typename ValueT>
+    ErrorCode ParseTree(
+      ValueT& out,
+      Error* error,
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+      std::deque<std::string>* ownedStrings = nullptr)
+    {
+      // Build into a local tree so out is only replaced on success
+      ValueT value;
+      detail::ValueBuilder<ValueT> builder(value, resource, ownedStrings, mSrc, &std::get<std::vector<ValueT*>>(mBuildStacks));
+      ErrorCode errorCode = ParseEvents(builder, error);
+      if (errorCode == ErrorCode::OK)
       {
-        if (consumePending && !mPendingComments.empty())
-        {
-          out.leadingComments.insert(out.leadingComments.end(), mPendingComments.begin(), mPendingComments.end());
-          mPendingComments.clear();
-        }
+        out = std::move(value);
+      }
+      return errorCode;
+    }
 
-        char c = Peek();
-        if (c == '{')
-        {
-          out.value = Object{};
-          return ParseInlineObjectLossless(out, currentIndent);
-        }
-        if (c == '[')
+    // Top-level shape of a document, as far as it can be told from its first content line
+    enum class RootShape
+    {
+      Undecided, // First content line not complete yet
+      Members, // Indent-style root object: top-level members can be parsed span by span
+      Whole, // Anything else
+    };
+
+    // Same test OpenValue makes at the document start (identifier, inline spaces, ':');
+    // contentStart is the offset of the first content byte
+    static RootShape ClassifyRoot(std::string_view text, bool atEnd, std::size_t& contentStart)
+    {
+      const std::size_t size = text.size();
+      std::size_t index = HasBOM(text) ? 3 : 0;
+      while (index < size)
+      {
+        char c = text[index];
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
         {
-          out.value = Array{};
-          return ParseArrayLossless(out, currentIndent);
+          ++index;
         }
-        if (c == '"')
+        else if (c == '#')
         {
-          Value tempValue;
-          ErrorCode errorCode = ParseStringOrTriple(tempValue);
-          if (errorCode == ErrorCode::OK)
-          {
-            out.value = std::move(tempValue);
-          }
-          return errorCode;
+          index = std::min(text.find('\n', index), size);
         }
-        if (c == '\'')
+        else
         {
-          Value tempValue;
-          ErrorCode errorCode = ParseStringSingle(tempValue);
-          if (errorCode == ErrorCode::OK)
-          {
-            out.value = std::move(tempValue);
-          }
-          return errorCode;
+          break;
         }
-        if (IsIdentifierStart(c))
+      }
+      if (!atEnd && (index == size || text.find('\n', index) == std::string_view::npos))
+      {
+        return RootShape::Undecided;
+      }
+
+      contentStart = index;
+      std::size_t end = index;
+      if (end < size && IsIdentifierStart(text[end]))
+      {
+        while (end < size && IsIdentifierChar(text[end]))
         {
-          return ParseIdentifierOrIndentedObjectLossless(out, currentIndent);
+          ++end;
         }
-        if (IsNumberStart(c))
+        while (end < size && (text[end] == ' ' || text[end] == '\t'))
         {
-          Value tempValue;
-          ErrorCode errorCode = ParseNumber(tempValue);
-          if (errorCode == ErrorCode::OK)
-          {
-            out.value = std::move(tempValue);
-          }
-          return errorCode;
+          ++end;
         }
-        if (EndOfFile())
+        if (end < size && text[end] == ':')
         {
-          return Finish(ErrorCode::UnexpectedEnd, nullptr, "Unexpected end of input while parsing value");
+          return RootShape::Members;
         }
-        return Finish(ErrorCode::UnexpectedChar, nullptr, "Unexpected character while parsing value");
       }
+      return RootShape::Whole;
+    }
 
-      ErrorCode ParseInlineObjectLossless(LosslessValue& out, int currentIndent)
+    // Prepare to parse span (a slice of the document starting at a line start) with line numbers from firstLine and
+    // the document's indent unit as known so far
+    void ResetSpan(std::string_view span, std::size_t firstLine, int indentUnit)
+    {
+      mSrc = span;
+      SetPosition(0, firstLine, 1);
+      mIndentUnit = indentUnit;
+      mIndentStack.assign(1, 0);
+      mError = {};
+    }
+
+    // UTF-8 check for a root span; only the document start (first) may carry a BOM
+    bool ValidateRootSpan(bool first)
+    {
+      if (first)
       {
-        if (!Match('{'))
+        return ValidateSource();
+      }
+      if (mOptions.trustedInput)
+      {
+        return true;
+      }
+      std::size_t validated = 0;
+      [[maybe_unused]] StatsScope statsScope(mStats.phases[static_cast<std::size_t>(ParseStats::Phase::Utf8Validation)], validated);
+      const std::size_t firstLine = mLine;
+      std::size_t badIndex = 0;
+      std::size_t badLine = 1;
+      std::size_t badCol = 1;
+      if (HasBOM(mSrc) || !ValidateUTF8(mSrc, false, badIndex, badLine, badCol))
+      {
+        SetPosition(badIndex, firstLine + badLine - 1, badCol);
+        return false;
+      }
+      validated = mSrc.size();
+      return true;
+    }
+
+    // Parse a span of an indent-style root object as an object of its own: either the document start (first) or a
+    // span starting at column 1 of a later top-level member. Merging the span objects in order gives the document.
+    // With a stopAt offset the span ends before the first root member that starts at column 1 at or after it (the
+    // values before it may read past stopAt); Stopped() then tells that mPos is that member's start.
+    template <typename Handler>
+    ErrorCode ParseRootSpan(Handler& handler, bool first, std::size_t stopAt = std::string_view::npos)
+    {
+      mStopAt = stopAt;
+      mStopped = false;
+      // The root body runs at depth 0 whatever the mode; its member values go through ParseValue
+      Frame frame{Frame::Kind::IndentedObject, Frame::Resume::Start, 0, mIndentStack.back()};
+      bool opened = true;
+      ErrorCode errorCode = ErrorCode::OK;
+      if (first)
+      {
+        errorCode = OpenValue(handler, 0, frame, opened);
+      }
+      else if (!handler.OnObjectStart())
+      {
+        return Abort();
+      }
+      if (errorCode == ErrorCode::OK && opened)
+      {
+        errorCode = RunFrame(handler, frame);
+      }
+      mStopAt = std::string_view::npos;
+      if (errorCode != ErrorCode::OK || mStopped)
+      {
+        return errorCode;
+      }
+      SkipWhitespaceAndComments();
+      if (mPos != mSrc.size())
+      {
+        return Fail(ErrorCode::UnexpectedChar, nullptr, "Trailing characters after top-level value");
+      }
+      return ErrorCode::OK;
+    }
+
+    bool Stopped() const
+    {
+      return mStopped;
+    }
+
+    char Peek() const
+    {
+      return mPos < mSrc.size() ? mSrc[mPos] : '\0';
+    }
+
+    bool EndOfFile() const
+    {
+      return mPos >= mSrc.size();
+    }
+
+    char Get()
+    {
+      if (mPos >= mSrc.size())
+      {
+        return '\0';
+      }
+      char c = mSrc[mPos++];
+      if constexpr (TrackPositions)
+      {
+        if (c == '\n')
         {
-          return Finish(ErrorCode::InternalError, nullptr);
+          ++mLine;
+          mCol = 1;
         }
-        Object object;
-        SkipWhitespaceAndComments();
-        if (Match('}'))
+        else
         {
-          out.value = object;
-          return ErrorCode::OK;
+          ++mCol;
         }
-        while (true)
-        {
-          // Comments collected before this key belong to this entry
-          std::vector<LosslessComment> preKeyComments;
-          if (!mPendingComments.empty())
-          {
-            preKeyComments.swap(mPendingComments);
-          }
+      }
+      return c;
+    }
 
-          std::string key;
-          ErrorCode errorCode = ParseKey(key);
-          if (errorCode != ErrorCode::OK)
-          {
-            return errorCode;
-          }
-          SkipWhitespaceAndComments();
-          if (!Match(':'))
-          {
-            return Finish(ErrorCode::UnexpectedChar, nullptr, "Expected ':' in inline object");
-          }
-          SkipWhitespaceAndComments();
-          LosslessValue child;
-          errorCode = ParseValueLossless(child, currentIndent);
-          if (errorCode != ErrorCode::OK)
-          {
-            return errorCode;
-          }
-          out.objectItems.emplace_back(key, child);
-          object.emplace(std::move(key), child.value);
-          SkipWhitespaceAndComments();
-          if (Match('}'))
+    // Move forward / back by count characters that contain no line break
+    void Advance(std::size_t count)
+    {
+      mPos += count;
+      if constexpr (TrackPositions)
+      {
+        mCol += count;
+      }
+    }
+
+    void Retreat(std::size_t count)
+    {
+      mPos -= count;
+      if constexpr (TrackPositions)
+      {
+        mCol -= count;
+      }
+    }
+
+    // Jump to offset pos, which is at line / column
+    void SetPosition(std::size_t pos, std::size_t line, std::size_t column)
+    {
+      mPos = pos;
+      mLine = line;
+      mCol = column;
+      mOrigin = pos;
+    }
+
+    bool AtLineStart() const
+    {
+      if constexpr (TrackPositions)
+      {
+        return mCol == 1;
+      }
+      else
+      {
+        return mPos == mOrigin ? mCol == 1 : mPos == 0 || mSrc[mPos - 1] == '\n';
+      }
+    }
+
+    bool Match(char c)
+    {
+      if (Peek() == c)
+      {
+        Get();
+        return true;
+      }
+      return false;
+    }
+
+    LocationEntry Location()
+    {
+      if constexpr (!TrackPositions)
+      {
+        // Count the lines passed since the last known position and move that position here, so the queries of one
+        // parse scan each byte once. Retreat only steps back over characters without a line break.
+        if (mPos < mOrigin)
+        {
+          mCol -= mOrigin - mPos;
+        }
+        else
+        {
+          const std::string_view passed = mSrc.substr(mOrigin, mPos - mOrigin);
+          const std::size_t lastBreak = passed.rfind('\n');
+          if (lastBreak == std::string_view::npos)
           {
-            break;
+            mCol += passed.size();
           }
-          if (!Match(','))
+          else
           {
-            return Finish(ErrorCode::UnexpectedChar, nullptr, "Expected ',' in inline object");
+            mLine += static_cast<std::size_t>(std::count(passed.begin(), passed.begin() + lastBreak + 1, '\n'));
+            mCol = passed.size() - lastBreak;
           }
-          SkipWhitespaceAndComments();
         }
-        out.value = std::move(object);
-        return ErrorCode::OK;
+        mOrigin = mPos;
       }
+      return LocationEntry{mLine, mCol};
+    }
 
-      ErrorCode ParseArrayLossless(LosslessValue& out, int parentIndent)
+    ErrorCode Fail(ErrorCode code, Error* out, std::string_view message = {})
+    {
+      mError.code = code;
+      mError.where = Location();
+      mError.message.assign(message.begin(), message.end());
+      if (out)
       {
-        if (!Match('['))
+        *out = mError;
+      }
+      return code;
+    }
+
+    ErrorCode Abort(Error* out = nullptr)
+    {
+      return Fail(ErrorCode::Aborted, out, "Parsing stopped by event handler");
+    }
+
+    void SkipInlineSpaces()
+    {
+      while (true)
+      {
+        char c = Peek();
+        if (c == ' ' || c == '	')
         {
-          return Finish(ErrorCode::InternalError, nullptr);
+          Get();
         }
+        else
+        {
+          break;
+        }
+      }
+    }
 
-        Array array;
-
-        SkipInlineSpaces();
-        bool isMultiline = (Peek() == '\r' || Peek() == '\n');
+    void SkipToEOL()
+    {
+      while (!EndOfFile())
+      {
+        char c = Get();
+        if (c == '\n')
+        {
+          break;
+        }
+      }
+    }
 
-        if (isMultiline)
+    void SkipWhitespaceAndComments()
+    {
+      while (!EndOfFile())
+      {
+        char c = Peek();
+        if (c == ' ' || c == '	')
         {
-          char c = Get();
-          if (c == '\r' && Peek() == '\n')
+          Get();
+          continue;
+        }
+        if (c == '#')
+        {
+          SkipToEOL();
+          continue;
+        }
+        if (c == '\r')
+        {
+          Get();
+          if (Peek() == '\n')
           {
             Get();
           }
+          continue;
+        }
+        if (c == '\n')
+        {
+          Get();
+          continue;
+        }
+        break;
+      }
+    }
 
-          bool hasLine = false;
-          ErrorCode errorCode = NextContentLineLossless(hasLine, mPendingComments);
-          if (errorCode != ErrorCode::OK)
-          {
-            return errorCode;
-          }
-          if (!hasLine || Peek() == ']')
-          {
-            if (Peek() == ']')
-            {
-              Get();
-            }
-            out.value = std::move(array);
-            return ErrorCode::OK;
-          }
-
-          int arrayIndent = mIndentStack.back();
-          while (true)
-          {
-            if (Peek() == ']')
-            {
-              Get();
-              break;
-            }
-
-            LosslessValue child;
-            errorCode = ParseValueLossless(child, arrayIndent, false);
-            if (errorCode != ErrorCode::OK)
-            {
-              return errorCode;
-            }
-            array.push_back(child.value);
-            out.arrayItems.push_back(std::move(child));
+    // Reads indentation (spaces only) at the beginning of a line.
+    // Assumes we are positioned at the first character of a line.
+    // - indentCols: number of columns (spaces).
+    // - hasContent: true if the line has non-comment content.
+    // Returns ErrorCode::Ok or an indent-related error.
+    ErrorCode ReadLineIndent(int& indentCols, bool& hasContent)
+    {
+      [[maybe_unused]] const StatsScope statsScope = PhaseScope(ParseStats::Phase::Indentation);
+      indentCols = 0;
+      hasContent = false;
 
-            SkipInlineSpaces();
-            if (Peek() == '#')
-            {
+      // Consume leading spaces / detect tabs in indent
+      while (!EndOfFile())
+      {
+        char c = Peek();
+        if (c == ' ')
+        {
+          Get();
+          ++indentCols;
+        }
+        else if (c == '\t')
+        {
+          // Tabs are illegal in indent
+          return Fail(ErrorCode::InvalidIndentChar, nullptr, "Tabs are not allowed in indentation");
+        }
+        else
+        {
+          break;
+        }
+      }
+
+      // Check if the rest of the line is blank or comment-only
+      char c = Peek();
+      if (c == '#' || c == '\r' || c == '\n' || c == '\0')
+      {
+        // Skip comment content
+        if (c == '#')
+        {
+          SkipToEOL();
+          c = Peek();
+        }
+        // Consume line ending (if any)
+        if (c == '\r')
+        {
+          Get();
+          if (Peek() == '\n')
+          {
+            Get();
+          }
+        }
+        else if (c == '\n')
+        {
+          Get();
+        }
+        // No content on this line
+        hasContent = false;
+        return ErrorCode::OK;
+      }
+
+      // This line has content
+      hasContent = true;
+
+      // Enforce a global indent unit
+      if (indentCols > 0)
+      {
+        if (mIndentUnit == 0)
+        {
+          mIndentUnit = indentCols;
+        }
+        else if (indentCols % mIndentUnit != 0)
+        {
+          return Fail(ErrorCode::InconsistentIndent, nullptr, "Indentation is not a multiple of base indent width");
+        }
+      }
+
+      return ErrorCode::OK;
+    }
+
+    // Apply CoffeeScript-style indent stack transitions:
+    // - If indent > top: push (new block).
+    // - If indent < top: pop until match or error.
+    // - If indent == top: stay in current block.
+    ErrorCode ApplyIndentLevel(int indentCols)
+    {
+      [[maybe_unused]] const StatsScope statsScope = PhaseScope(ParseStats::Phase::Indentation);
+      int top = mIndentStack.back();
+      if (indentCols > top)
+      {
+        if (mIndentStack.size() > mOptions.maxDepth)
+        {
+          return Fail(ErrorCode::DepthLimitExceeded, nullptr, "Indentation nests deeper than ParseOptions::maxDepth");
+        }
+        const std::size_t capacity = mIndentStack.capacity();
+        mIndentStack.push_back(indentCols);
+        NoteGrowth(capacity, mIndentStack.capacity());
+      }
+      else if (indentCols < top)
+      {
+        while (!mIndentStack.empty() && indentCols < mIndentStack.back())
+        {
+          mIndentStack.pop_back();
+        }
+        if (mIndentStack.empty() || mIndentStack.back() != indentCols)
+        {
+          return Fail(ErrorCode::InconsistentIndent, nullptr, "Dedent does not match any previous indent level");
+        }
+      }
+      return ErrorCode::OK;
+    }
+
+    // Skip blank / comment lines and position at the first token of the next non-empty line, applying indent stack
+    // transitions. Returns false if we reach EOF.
+    ErrorCode NextContentLine(bool& hasLine)
+    {
+      hasLine = false;
+      while (!EndOfFile())
+      {
+        // If we are mid-line, consume to the end so we start clean on the next iteration
+        if (!AtLineStart())
+        {
+          SkipToEOL();
+          // If we hit EOF while skipping, surface as no more lines
+          if (EndOfFile())
+          {
+            return ErrorCode::OK;
+          }
+          continue;
+        }
+
+        int indentCols = 0;
+        bool hasContent = false;
+        ErrorCode errorCode = ReadLineIndent(indentCols, hasContent);
+        if (errorCode != ErrorCode::OK)
+        {
+          return errorCode;
+        }
+
+        if (!hasContent)
+        {
+          // Blank / comment line, continue to next line
+          continue;
+        }
+
+        // Apply CoffeeScript indent rules for this new line
+        errorCode = ApplyIndentLevel(indentCols);
+        if (errorCode != ErrorCode::OK)
+        {
+          return errorCode;
+        }
+
+        hasLine = true;
+        return ErrorCode::OK;
+      }
+      return ErrorCode::OK; // EOF, hasLine = false
+    }
+
+    static int HexValue(char c)
+    {
+      if (c >= '0' && c <= '9')
+      {
+        return c - '0';
+      }
+      if (c >= 'a' && c <= 'f')
+      {
+        return 10 + (c - 'a');
+      }
+      if (c >= 'A' && c <= 'F')
+      {
+        return 10 + (c - 'A');
+      }
+      return -1;
+    }
+
+    template <typename StringT>
+    static void AppendUTF8(StringT& out, std::uint32_t codePoint)
+    {
+      if (codePoint <= 0x7F)
+      {
+        out.push_back(static_cast<char>(codePoint));
+      }
+      else if (codePoint <= 0x7FF)
+      {
+        out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+      }
+      else if (codePoint <= 0xFFFF)
+      {
+        out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+      }
+      else
+      {
+        out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+      }
+    }
+
+    static bool HasBOM(std::string_view stringView)
+    {
+      return stringView.size() >= 3 && static_cast<unsigned char>(stringView[0]) == 0xEF &&
+        static_cast<unsigned char>(stringView[1]) == 0xBB && static_cast<unsigned char>(stringView[2]) == 0xBF;
+    }
+
+    // Validate UTF-8 up front (unless trustedInput) and position after a leading BOM; on failure the position is the
+    // offending byte
+    bool ValidateSource()
+    {
+      // Bytes checked, counted once validation passed (a trusted source counts none)
+      std::size_t validated = 0;
+      [[maybe_unused]] StatsScope statsScope(mStats.phases[static_cast<std::size_t>(ParseStats::Phase::Utf8Validation)], validated);
+      std::size_t badIndex = 0;
+      std::size_t badLine = 1;
+      std::size_t badCol = 1;
+      if (!mOptions.trustedInput && !ValidateUTF8(mSrc, true, badIndex, badLine, badCol))
+      {
+        SetPosition(badIndex, badLine, badCol);
+        return false;
+      }
+      validated = mOptions.trustedInput ? 0 : mSrc.size();
+      if (HasBOM(mSrc))
+      {
+        SetPosition(3, 1, 1);
+      }
+      return true;
+    }
+
+    // ASCII runs are skipped in SIMD-width blocks; multi-byte sequences are checked one code point at a time. Line /
+    // column (in code points) are only computed once a bad sequence is found.
+    static bool
+    ValidateUTF8(std::string_view stringView, bool allowLeadingBOM, std::size_t& badIndex, std::size_t& badLine, std::size_t& badCol)
+    {
+      const std::size_t size = stringView.size();
+      const std::size_t start = (allowLeadingBOM && HasBOM(stringView)) ? 3 : 0;
+      std::size_t index = start;
+
+      auto fail = [&](std::size_t at) {
+        badIndex = at;
+        const std::string_view before = stringView.substr(0, at);
+        badLine = 1 + static_cast<std::size_t>(std::count(before.begin(), before.end(), '\n'));
+        const std::size_t newline = before.rfind('\n');
+        const std::size_t lineStart = newline == std::string_view::npos ? start : newline + 1;
+        badCol = 1;
+        for (std::size_t k = lineStart; k < at; ++k)
+        {
+          if ((static_cast<unsigned char>(stringView[k]) & 0xC0) != 0x80)
+          {
+            ++badCol;
+          }
+        }
+        return false;
+      };
+
+      while (index < size)
+      {
+        index = detail::SkipASCII(stringView.data(), index, size);
+        if (index >= size)
+        {
+          break;
+        }
+
+        unsigned char c = static_cast<unsigned char>(stringView[index]);
+        if (
+          index > 0 && c == 0xEF && index + 2 < size && static_cast<unsigned char>(stringView[index + 1]) == 0xBB &&
+          static_cast<unsigned char>(stringView[index + 2]) == 0xBF)
+        {
+          return fail(index); // BOM not at start
+        }
+
+        std::uint32_t codePoint = 0;
+        std::size_t length = 0;
+        if ((c & 0xE0) == 0xC0)
+        {
+          length = 2;
+          codePoint = c & 0x1F;
+        }
+        else if ((c & 0xF0) == 0xE0)
+        {
+          length = 3;
+          codePoint = c & 0x0F;
+        }
+        else if ((c & 0xF8) == 0xF0)
+        {
+          length = 4;
+          codePoint = c & 0x07;
+        }
+        else
+        {
+          return fail(index);
+        }
+
+        if (index + length > size)
+        {
+          return fail(index);
+        }
+        for (std::size_t k = 1; k < length; ++k)
+        {
+          unsigned char cc = static_cast<unsigned char>(stringView[index + k]);
+          if ((cc & 0xC0) != 0x80)
+          {
+            return fail(index);
+          }
+          codePoint = (codePoint << 6) | (cc & 0x3F);
+        }
+
+        if (
+          (length == 2 && codePoint < 0x80) || (length == 3 && codePoint < 0x800) ||
+          (length == 4 && (codePoint < 0x10000 || codePoint > 0x10FFFF)) || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+        {
+          return fail(index);
+        }
+
+        index += length;
+      }
+      return true;
+    }
+
+    template <typename Handler>
+    ErrorCode ParseValue(Handler& handler, int currentIndent)
+    {
+      if (mOptions.iterative)
+      {
+        return ParseValueIterative(handler, currentIndent);
+      }
+      ErrorCode errorCode = EnterValue(sizeof(Value));
+      Frame frame{};
+      bool opened = false;
+      if (errorCode == ErrorCode::OK)
+      {
+        errorCode = OpenValue(handler, currentIndent, frame, opened);
+      }
+      if (errorCode == ErrorCode::OK && opened)
+      {
+        errorCode = RunFrame(handler, frame);
+      }
+      --mDepth;
+      return errorCode;
+    }
+
+    // Step frame until it ends, parsing each child value it asks for with a nested ParseValue call
+    template <typename Handler>
+    ErrorCode RunFrame(Handler& handler, Frame& frame)
+    {
+      while (true)
+      {
+        bool needsValue = false;
+        int childIndent = frame.indent;
+        ErrorCode errorCode = StepFrame(handler, frame, needsValue, childIndent);
+        if (errorCode != ErrorCode::OK || !needsValue)
+        {
+          return errorCode;
+        }
+        errorCode = ParseValue(handler, childIndent);
+        if (errorCode != ErrorCode::OK)
+        {
+          return errorCode;
+        }
+      }
+    }
+
+    // Strings and numbers (and the errors for anything that can't start a value)
+    template <typename Handler>
+    ErrorCode ParseScalar(Handler& handler)
+    {
+      const char c = Peek();
+      if constexpr (detail::SkipsScalars<Handler>)
+      {
+        if (c == '"' || c == '\'' || IsNumberStart(c))
+        {
+          return SkipLiteral(handler);
+        }
+      }
+      if (c == '"' || c == '\'')
+      {
+        // Double quotes could be a normal or triple string; single-quoted strings never span lines
+        std::string_view text;
+        ErrorCode errorCode = c == '"' ? ScanStringOrTriple(text) : ScanQuoted('\'', text);
+        if (errorCode != ErrorCode::OK)
+        {
+          return errorCode;
+        }
+        return handler.OnString(text) ? ErrorCode::OK : Abort();
+      }
+      if (IsNumberStart(c))
+      {
+        double number = 0.0;
+        const std::size_t start = mPos;
+        ErrorCode errorCode = ScanNumber(number);
+        if (errorCode != ErrorCode::OK)
+        {
+          return errorCode;
+        }
+        if constexpr (detail::ReadsNumberLiterals<Handler>)
+        {
+          return handler.OnNumber(number, mSrc.substr(start, mPos - start)) ? ErrorCode::OK : Abort();
+        }
+        else
+        {
+          return handler.OnNumber(number) ? ErrorCode::OK : Abort();
+        }
+      }
+      if (EndOfFile())
+      {
+        return Fail(ErrorCode::UnexpectedEnd, nullptr, "Unexpected end of input while parsing value");
+      }
+      return Fail(ErrorCode::UnexpectedChar, nullptr, "Unexpected character while parsing value");
+    }
+
+    static bool IsIdentifierStart(char c)
+    {
+      return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_';
+    }
+
+    static bool IsIdentifierChar(char c)
+    {
+      return IsIdentifierStart(c) || (c >= '0' && c <= '9') || c == '-' || c == '_';
+    }
+
+    static bool IsNumberStart(char c)
+    {
+      return (c >= '0' && c <= '9') || c == '-' || c == '+';
+    }
+
+    // Keyword or bare string value
+    template <typename Handler>
+    ErrorCode ParseBareValue(Handler& handler, std::string_view ident)
+    {
+      bool accepted = true;
+      if (ident == "true")
+      {
+        accepted = handler.OnBool(true);
+      }
+      else if (ident == "false")
+      {
+        accepted = handler.OnBool(false);
+      }
+      else if (ident == "null")
+      {
+        accepted = handler.OnNull();
+      }
+      else
+      {
+        ErrorCode errorCode = CheckString(ident.size());
+        if (errorCode != ErrorCode::OK)
+        {
+          return errorCode;
+        }
+        accepted = handler.OnString(ident); // Bare string
+      }
+      return accepted ? ErrorCode::OK : Abort();
+    }
+
+    ErrorCode ScanStringOrTriple(std::string_view& out)
+    {
+      // We know first char is '"'
+      // Look ahead for """
+      if (Peek() != '"')
+      {
+        return Fail(ErrorCode::InternalError, nullptr);
+      }
+      // Check if next two characters are also '"'
+      if (mPos + 2 < mSrc.size() && mSrc[mPos] == '"' && mSrc[mPos + 1] == '"' && mSrc[mPos + 2] == '"')
+      {
+        return ScanTripleString(out);
+      }
+      return ScanQuoted('"', out);
+    }
+
+    // Step over the string / number literal at the current position, checking it like the decoding scanners do, and
+    // report where it starts
+    template <typename Handler>
+    ErrorCode SkipLiteral(Handler& handler)
+    {
+      const std::size_t offset = mPos;
+      const LocationEntry where = Location();
+      const char c = Peek();
+      ErrorCode errorCode = ErrorCode::OK;
+      if (c == '"' && mSrc.substr(mPos, 3) == "\"\"\"")
+      {
+        std::string_view text;
+        errorCode = ScanTripleString(text);
+      }
+      else if (c == '"' || c == '\'')
+      {
+        errorCode = SkipQuoted(c);
+      }
+      else
+      {
+        bool isInteger = true;
+        if (!IsNumberLiteral(ScanNumberText(isInteger)))
+        {
+          errorCode = Fail(ErrorCode::InvalidNumber, nullptr, "Invalid number literal");
+        }
+      }
+      if (errorCode != ErrorCode::OK)
+      {
+        return errorCode;
+      }
+      return handler.OnScalar(offset, where) ? ErrorCode::OK : Abort();
+    }
+
+    // Step over a quoted literal without decoding it. Simple escapes are skipped; anything the fast loop can't vouch
+    // for (\u escapes, bad escapes, newlines, missing quote) goes through the decoder for its checks / error.
+    ErrorCode SkipQuoted(char quote)
+    {
+      [[maybe_unused]] const StatsScope statsScope = PhaseScope(ParseStats::Phase::Strings);
+      std::size_t end = detail::FindStringSpecial(mSrc.data(), mPos + 1, mSrc.size(), quote);
+      while (end < mSrc.size())
+      {
+        char c = mSrc[end];
+        if (c == quote)
+        {
+          const std::size_t length = end - mPos - 1;
+          Advance(end + 1 - mPos);
+          return CheckString(length);
+        }
+        if (c != '\\')
+        {
+          break; // CR / LF
+        }
+        char e = end + 1 < mSrc.size() ? mSrc[end + 1] : '\0';
+        if (e != quote && e != '\\' && e != 'n' && e != 'r' && e != 't')
+        {
+          break;
+        }
+        end = detail::FindStringSpecial(mSrc.data(), end + 2, mSrc.size(), quote);
+      }
+
+      return DecodeQuoted(quote);
+    }
+
+    // Slow path of ScanQuoted / SkipQuoted: decode (and check) the literal at the current position into mScratch
+    ErrorCode DecodeQuoted(char quote)
+    {
+      if constexpr (CollectStats)
+      {
+        ++mStats.decodedStrings;
+      }
+      const std::size_t capacity = mScratch.capacity();
+      mScratch.clear();
+      ErrorCode errorCode = quote == '"' ? ScanEscapedString<'"'>(mScratch) : ScanEscapedString<'\''>(mScratch);
+      NoteGrowth(capacity, mScratch.capacity());
+      return errorCode == ErrorCode::OK ? CheckString(mScratch.size()) : errorCode;
+    }
+
+    // Scan a quoted literal. Without escapes / newlines before the closing quote, out views the source; otherwise the
+    // literal is decoded into mScratch and out views that.
+    ErrorCode ScanQuoted(char quote, std::string_view& out)
+    {
+      [[maybe_unused]] const StatsScope statsScope = PhaseScope(ParseStats::Phase::Strings);
+      const std::size_t end = detail::FindStringSpecial(mSrc.data(), mPos + 1, mSrc.size(), quote);
+      if (end < mSrc.size() && mSrc[end] == quote)
+      {
+        out = mSrc.substr(mPos + 1, end - mPos - 1);
+        Advance(end + 1 - mPos);
+        return CheckString(out.size());
+      }
+
+      ErrorCode errorCode = DecodeQuoted(quote);
+      if (errorCode == ErrorCode::OK)
+      {
+        out = mScratch;
+      }
+      return errorCode;
+    }
+
+    // Identifier characters starting at the current position
+    std::string_view ScanIdentifier()
+    {
+      std::size_t start = mPos;
+      while (IsIdentifierChar(Peek()))
+      {
+        Get();
+      }
+      return mSrc.substr(start, mPos - start);
+    }
+
+    // Decode a literal quoted with Quote into result. Runs up to the next quote / escape / line break are found with
+    // FindStringSpecial and appended in one piece.
+    template <char Quote>
+    ErrorCode ScanEscapedString(std::string& result)
+    {
+      if (!Match(Quote))
+      {
+        return Fail(ErrorCode::InternalError, nullptr);
+      }
+      while (!EndOfFile())
+      {
+        const std::size_t special = detail::FindStringSpecial(mSrc.data(), mPos, mSrc.size(), Quote);
+        result.append(mSrc.data() + mPos, special - mPos);
+        Advance(special - mPos);
+        if (EndOfFile())
+        {
+          break;
+        }
+
+        char c = Get();
+        if (c == Quote)
+        {
+          return ErrorCode::OK;
+        }
+        if (c == '\\')
+        {
+          if (EndOfFile())
+          {
+            return Fail(ErrorCode::UnterminatedString, nullptr);
+          }
+          char e = Get();
+          switch (e)
+          {
+            case Quote: result.push_back(Quote); break;
+            case '\\': result.push_back('\\'); break;
+            case 'n': result.push_back('\n'); break;
+            case 'r': result.push_back('\r'); break;
+            case 't': result.push_back('\t'); break;
+            case 'u':
+            {
+              // Unicode escape \uXXXX with optional surrogate pair
+              std::uint32_t codePoint = 0;
+              for (std::size_t index = 0; index < 4; ++index)
+              {
+                if (EndOfFile())
+                {
+                  return Fail(ErrorCode::InvalidEscape, nullptr, "Incomplete unicode escape");
+                }
+                int hv = HexValue(Get());
+                if (hv < 0)
+                {
+                  return Fail(ErrorCode::InvalidEscape, nullptr, "Invalid hex in unicode escape");
+                }
+                codePoint = (codePoint << 4) | static_cast<std::uint32_t>(hv);
+              }
+              if (codePoint >= 0xD800 && codePoint <= 0xDBFF)
+              {
+                // Expect low surrogate
+                if (!(Peek() == '\\' && mPos + 1 < mSrc.size() && mSrc[mPos + 1] == 'u'))
+                {
+                  return Fail(ErrorCode::InvalidEscape, nullptr, "Unpaired surrogate");
+                }
+                Get(); // '\'
+                Get(); // 'u'
+                std::uint32_t lowSurrogate = 0;
+                for (std::size_t index = 0; index < 4; ++index)
+                {
+                  if (EndOfFile())
+                  {
+                    return Fail(ErrorCode::InvalidEscape, nullptr, "Incomplete unicode escape");
+                  }
+                  int hexValue = HexValue(Get());
+                  if (hexValue < 0)
+                  {
+                    return Fail(ErrorCode::InvalidEscape, nullptr, "Invalid hex in unicode escape");
+                  }
+                  lowSurrogate = (lowSurrogate << 4) | static_cast<std::uint32_t>(hexValue);
+                }
+                if (lowSurrogate < 0xDC00 || lowSurrogate > 0xDFFF)
+                {
+                  return Fail(ErrorCode::InvalidEscape, nullptr, "Invalid low surrogate");
+                }
+                codePoint = 0x10000 + (((codePoint - 0xD800) << 10) | (lowSurrogate - 0xDC00));
+              }
+              else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF)
+              {
+                return Fail(ErrorCode::InvalidEscape, nullptr, "Unpaired surrogate");
+              }
+              AppendUTF8(result, codePoint);
+              break;
+            }
+            default: return Fail(ErrorCode::InvalidEscape, nullptr, "Invalid escape in string");
+          }
+        }
+        else
+        {
+          // CR / LF
+          return Fail(ErrorCode::UnterminatedString, nullptr, "Newline in string literal");
+        }
+      }
+      return Fail(ErrorCode::UnterminatedString, nullptr, "Unterminated string literal");
+    }
+
+    ErrorCode ScanTripleString(std::string_view& out)
+    {
+      [[maybe_unused]] const StatsScope statsScope = PhaseScope(ParseStats::Phase::Strings);
+      // Consume initial """
+      if (!(Match('"') && Match('"') && Match('"')))
+      {
+        return Fail(ErrorCode::InternalError, nullptr);
+      }
+      std::size_t start = mPos;
+      while (!EndOfFile())
+      {
+        if (Peek() == '"' && mPos + 2 < mSrc.size() && mSrc[mPos + 1] == '"' && mSrc[mPos + 2] == '"')
+        {
+          // End; triple strings have no escapes, so the content is the raw source span
+          out = mSrc.substr(start, mPos - start);
+          Get();
+          Get();
+          Get();
+          return CheckString(out.size());
+        }
+        Get();
+      }
+      return Fail(ErrorCode::UnterminatedTripleString, nullptr, "Unterminated triple string literal");
+    }
+
+    // Locale-independent conversion of a scanned number literal (optional sign, digits, '.', exponent)
+    static bool ConvertNumber(std::string_view text, bool isInteger, double& out)
+    {
+      const bool negative = !text.empty() && text[0] == '-';
+      if (!text.empty() && (text[0] == '+' || text[0] == '-'))
+      {
+        text.remove_prefix(1);
+      }
+      if (text.empty())
+      {
+        return false;
+      }
+
+      // Pure digit literals up to 19 digits fit in 64 bits; the integer -> double conversion rounds like strtod
+      if (isInteger && text.size() <= 19)
+      {
+        std::uint64_t integer = 0;
+        for (char c : text)
+        {
+          integer = integer * 10 + static_cast<std::uint64_t>(c - '0');
+        }
+        out = negative ? -static_cast<double>(integer) : static_cast<double>(integer);
+        return true;
+      }
+
+      double value = 0.0;
+      auto [ptr, errorCode] = std::from_chars(text.data(), text.data() + text.size(), value);
+      if (ptr != text.data() + text.size())
+      {
+        return false;
+      }
+      if (errorCode == std::errc::result_out_of_range)
+      {
+        // Saturate like strtod: decide overflow / underflow from the decimal magnitude of the leading digit
+        long long exponent = 0;
+        long long magnitude = 0;
+        bool seenDigit = false;
+        bool inFraction = false;
+        std::size_t index = 0;
+        for (; index < text.size() && text[index] != 'e' && text[index] != 'E'; ++index)
+        {
+          char c = text[index];
+          if (c == '.')
+          {
+            inFraction = true;
+          }
+          else if (!seenDigit && c == '0')
+          {
+            magnitude -= inFraction ? 1 : 0;
+          }
+          else
+          {
+            seenDigit = true;
+            magnitude += inFraction ? 0 : 1;
+          }
+        }
+        if (index < text.size())
+        {
+          bool negativeExponent = ++index < text.size() && text[index] == '-';
+          if (index < text.size() && (text[index] == '+' || text[index] == '-'))
+          {
+            ++index;
+          }
+          for (; index < text.size() && exponent < 1000000000; ++index)
+          {
+            exponent = exponent * 10 + (text[index] - '0');
+          }
+          exponent = negativeExponent ? -exponent : exponent;
+        }
+        value = (magnitude + exponent > 0) ? HUGE_VAL : 0.0;
+      }
+      else if (errorCode != std::errc())
+      {
+        return false;
+      }
+      out = negative ? -value : value;
+      return true;
+    }
+
+    // Whether ConvertNumber accepts a scanned literal: a mantissa digit, and only digits (at least one) after any
+    // exponent marker / sign
+    static bool IsNumberLiteral(std::string_view text)
+    {
+      bool mantissaDigit = false;
+      std::size_t index = text.empty() || (text[0] != '+' && text[0] != '-') ? 0 : 1;
+      for (; index < text.size() && text[index] != 'e' && text[index] != 'E'; ++index)
+      {
+        mantissaDigit = mantissaDigit || text[index] != '.';
+      }
+      if (index == text.size())
+      {
+        return mantissaDigit;
+      }
+      ++index;
+      if (index < text.size() && (text[index] == '+' || text[index] == '-'))
+      {
+        ++index;
+      }
+      return mantissaDigit && index < text.size() && text.find('.', index) == std::string_view::npos;
+    }
+
+    ErrorCode ScanNumber(double& out)
+    {
+      [[maybe_unused]] const StatsScope statsScope = PhaseScope(ParseStats::Phase::Numbers);
+      bool isInteger = true;
+      std::string_view stringView = ScanNumberText(isInteger);
+      if (!ConvertNumber(stringView, isInteger, out))
+      {
+        return Fail(ErrorCode::InvalidNumber, nullptr, "Invalid number literal");
+      }
+      return ErrorCode::OK;
+    }
+
+    // Scan the extent of a number literal (sign, digits, one '.', one exponent)
+    std::string_view ScanNumberText(bool& isInteger)
+    {
+      // Numbers never span lines, so scan straight over the source and advance the column once
+      std::size_t index = mPos;
+      const std::size_t size = mSrc.size();
+      bool hasDot = false;
+      bool hasExp = false;
+
+      if (index < size && (mSrc[index] == '+' || mSrc[index] == '-'))
+      {
+        ++index;
+      }
+
+      while (index < size)
+      {
+        char c = mSrc[index];
+        if (c >= '0' && c <= '9')
+        {
+          ++index;
+        }
+        else if (c == '.' && !hasDot)
+        {
+          hasDot = true;
+          ++index;
+        }
+        else if ((c == 'e' || c == 'E') && !hasExp)
+        {
+          hasExp = true;
+          ++index;
+          if (index < size && (mSrc[index] == '+' || mSrc[index] == '-'))
+          {
+            ++index;
+          }
+        }
+        else
+        {
+          break;
+        }
+      }
+
+      std::string_view stringView = mSrc.substr(mPos, index - mPos);
+      Advance(index - mPos);
+      isInteger = !hasDot && !hasExp;
+      return stringView;
+    }
+
+    // ParseValue with ParseOptions::iterative: the open containers are kept on mFrames instead of nested RunFrame
+    // calls, so the call depth stays constant. Both drive the same Step functions, so events, errors and accepted
+    // input are the same in both modes.
+    template <typename Handler>
+    ErrorCode ParseValueIterative(Handler& handler, int currentIndent)
+    {
+      const std::size_t base = mFrames.size(); // Root span bodies come in here once per member value
+      int indent = currentIndent;
+      while (true)
+      {
+        ErrorCode errorCode = EnterValue(sizeof(Value));
+        Frame frame{};
+        bool opened = false;
+        if (errorCode == ErrorCode::OK)
+        {
+          errorCode = OpenValue(handler, indent, frame, opened);
+        }
+        if (opened)
+        {
+          const std::size_t capacity = mFrames.capacity();
+          mFrames.push_back(frame);
+          NoteGrowth(capacity, mFrames.capacity());
+        }
+        else
+        {
+          --mDepth;
+        }
+
+        // Step the innermost containers until one asks for a child value, closing those that end
+        bool needsValue = false;
+        while (errorCode == ErrorCode::OK && mFrames.size() > base)
+        {
+          errorCode = StepFrame(handler, mFrames.back(), needsValue, indent);
+          if (needsValue)
+          {
+            break;
+          }
+          mFrames.pop_back();
+          --mDepth;
+        }
+        if (errorCode != ErrorCode::OK)
+        {
+          mFrames.resize(base);
+          return errorCode;
+        }
+        if (!needsValue)
+        {
+          return ErrorCode::OK;
+        }
+      }
+    }
+
+    // Parse the value at the current position: scalars and empty containers complete, other containers emit their
+    // start event and fill frame for the Step functions (opened)
+    template <typename Handler>
+    ErrorCode OpenValue(Handler& handler, int currentIndent, Frame& frame, bool& opened)
+    {
+      SkipWhitespaceAndComments();
+      const char c = Peek();
+      if (c == '{')
+      {
+        Get();
+        if (!handler.OnObjectStart())
+        {
+          return Abort();
+        }
+        SkipWhitespaceAndComments();
+        if (Match('}'))
+        {
+          return handler.OnObjectEnd() ? ErrorCode::OK : Abort();
+        }
+        return OpenFrame(Frame::Kind::InlineObject, currentIndent, frame, opened);
+      }
+      if (c == '[')
+      {
+        Get();
+        if (!handler.OnArrayStart())
+        {
+          return Abort();
+        }
+        SkipInlineSpaces();
+        if (Peek() != '\r' && Peek() != '\n')
+        {
+          SkipWhitespaceAndComments();
+          if (Match(']'))
+          {
+            return handler.OnArrayEnd() ? ErrorCode::OK : Abort();
+          }
+          return OpenFrame(Frame::Kind::InlineArray, currentIndent, frame, opened);
+        }
+
+        if (Get() == '\r' && Peek() == '\n')
+        {
+          Get();
+        }
+        bool hasLine = false;
+        ErrorCode errorCode = NextContentLine(hasLine);
+        if (errorCode != ErrorCode::OK)
+        {
+          return errorCode;
+        }
+        if (!hasLine || Peek() == ']')
+        {
+          Match(']');
+          return handler.OnArrayEnd() ? ErrorCode::OK : Abort();
+        }
+        return OpenFrame(Frame::Kind::MultilineArray, mIndentStack.back(), frame, opened);
+      }
+      if (IsIdentifierStart(c))
+      {
+        std::string_view ident = ScanIdentifier();
+        SkipInlineSpaces();
+        if (Peek() != ':')
+        {
+          return ParseBareValue(handler, ident);
+        }
+        Retreat(ident.size());
+        if (!handler.OnObjectStart())
+        {
+          return Abort();
+        }
+        return OpenFrame(Frame::Kind::IndentedObject, currentIndent, frame, opened);
+      }
+      return ParseScalar(handler);
+    }
+
+    ErrorCode OpenFrame(Frame::Kind kind, int indent, Frame& frame, bool& opened)
+    {
+      frame = Frame{kind, Frame::Resume::Start, indent, mIndentStack.back()};
+      opened = true;
+      return ErrorCode::OK;
+    }
+
+    // Run frame's loop from its resume point until it needs a child value (needsValue, parsed at childIndent) or ends
+    // (end event emitted)
+    template <typename Handler>
+    ErrorCode StepFrame(Handler& handler, Frame& frame, bool& needsValue, int& childIndent)
+    {
+      bool ended = false;
+      ErrorCode errorCode = ErrorCode::OK;
+      switch (frame.kind)
+      {
+        case Frame::Kind::InlineObject: errorCode = StepInlineObject(handler, frame, ended); break;
+        case Frame::Kind::IndentedObject: errorCode = StepIndentedObject(handler, frame, ended, childIndent); break;
+        case Frame::Kind::InlineArray: errorCode = StepInlineArray(frame, ended); break;
+        case Frame::Kind::MultilineArray: errorCode = StepMultilineArray(frame, ended); break;
+      }
+      if (errorCode != ErrorCode::OK)
+      {
+        return errorCode;
+      }
+      if (!ended)
+      {
+        needsValue = true;
+        if (frame.kind != Frame::Kind::IndentedObject)
+        {
+          childIndent = frame.indent;
+        }
+        return ErrorCode::OK;
+      }
+      needsValue = false;
+      const bool isObject = frame.kind == Frame::Kind::InlineObject || frame.kind == Frame::Kind::IndentedObject;
+      return (isObject ? handler.OnObjectEnd() : handler.OnArrayEnd()) ? ErrorCode::OK : Abort();
+    }
+
+    // Inline object members: key ':' value, separated by ',' up to '}'
+    template <typename Handler>
+    ErrorCode StepInlineObject(Handler& handler, Frame& frame, bool& ended)
+    {
+      if (frame.resume == Frame::Resume::AfterValue)
+      {
+        SkipWhitespaceAndComments();
+        if (Match('}'))
+        {
+          ended = true;
+          return ErrorCode::OK;
+        }
+        if (Peek() == '#')
+        {
+          SkipToEOL();
+          SkipWhitespaceAndComments();
+          if (Match('}'))
+          {
+            ended = true;
+            return ErrorCode::OK;
+          }
+        }
+        if (!Match(','))
+        {
+          return Fail(ErrorCode::UnexpectedChar, nullptr, "Expected ',' or '}' in object");
+        }
+        SkipWhitespaceAndComments();
+      }
+
+      std::string_view key;
+      ErrorCode errorCode = ParseKey(key);
+      if (errorCode != ErrorCode::OK)
+      {
+        return errorCode;
+      }
+      SkipWhitespaceAndComments();
+      if (!Match(':'))
+      {
+        return Fail(ErrorCode::UnexpectedChar, nullptr, "Expected ':' in object");
+      }
+      if (!handler.OnKey(key))
+      {
+        return Abort();
+      }
+      SkipWhitespaceAndComments();
+      frame.resume = Frame::Resume::AfterValue;
+      return ErrorCode::OK;
+    }
+
+    // Indent-style object members, one or more per line at bodyIndent (comma separated); deeper lines belong to block
+    // values, a shallower line or anything that can't start a key ends the object
+    template <typename Handler>
+    ErrorCode StepIndentedObject(Handler& handler, Frame& frame, bool& ended, int& childIndent)
+    {
+      const int bodyIndent = frame.bodyIndent;
+      bool hasLine = false;
+      ErrorCode errorCode = ErrorCode::OK;
+      if (frame.resume == Frame::Resume::AfterBlockValue && mIndentStack.back() < bodyIndent)
+      {
+        ended = true;
+        return ErrorCode::OK;
+      }
+      if (frame.resume == Frame::Resume::AfterValue)
+      {
+        // End of line or another entry on same line (comma separated)
+        SkipInlineSpaces();
+        if (Peek() == '#')
+        {
+          SkipToEOL();
+          errorCode = NextContentLine(hasLine);
+          ended = errorCode == ErrorCode::OK && (!hasLine || mIndentStack.back() < bodyIndent);
+        }
+        else if (Match(','))
+        {
+          SkipInlineSpaces();
+        }
+        else if (Peek() == '\r' || Peek() == '\n')
+        {
+          if (Get() == '\r' && Peek() == '\n')
+          {
+            Get();
+          }
+          errorCode = NextContentLine(hasLine);
+          ended = errorCode == ErrorCode::OK && (!hasLine || mIndentStack.back() < bodyIndent);
+        }
+        else
+        {
+          ended = true;
+        }
+        if (errorCode != ErrorCode::OK || ended)
+        {
+          return errorCode;
+        }
+      }
+
+      while (true)
+      {
+        SkipInlineSpaces();
+        if (EndOfFile())
+        {
+          ended = true;
+          return ErrorCode::OK;
+        }
+
+        // Skip blank / comment lines inside an object body
+        if (Peek() == '#' || Peek() == '\r' || Peek() == '\n')
+        {
+          errorCode = NextContentLine(hasLine);
+          if (errorCode != ErrorCode::OK)
+          {
+            return errorCode;
+          }
+          if (!hasLine || mIndentStack.back() < bodyIndent)
+          {
+            ended = true;
+            return ErrorCode::OK;
+          }
+          continue;
+        }
+
+        char c = Peek();
+        if (!IsIdentifierStart(c) && c != '"' && c != '\'')
+        {
+          ended = true;
+          return ErrorCode::OK;
+        }
+        if (mPos >= mStopAt && mDepth == 0 && mSrc[mPos - 1] == '\n')
+        {
+          // Root member at column 1 past the span (ParseRootSpan with a stop offset)
+          mStopped = true;
+          ended = true;
+          return ErrorCode::OK;
+        }
+
+        std::string_view key;
+        errorCode = ParseKey(key);
+        if (errorCode != ErrorCode::OK)
+        {
+          return errorCode;
+        }
+        SkipInlineSpaces();
+        if (!Match(':'))
+        {
+          return Fail(ErrorCode::UnexpectedChar, nullptr, "Expected ':' in object pair");
+        }
+        if (!handler.OnKey(key))
+        {
+          return Abort();
+        }
+        SkipInlineSpaces();
+
+        // Value on the same line
+        c = Peek();
+        if (c != '#' && c != '\r' && c != '\n')
+        {
+          frame.resume = Frame::Resume::AfterValue;
+          childIndent = frame.indent;
+          return ErrorCode::OK;
+        }
+
+        // Block value on the next indented line (after a comment or the end of line)
+        if (c == '#')
+        {
+          SkipToEOL();
+        }
+        else if (Get() == '\r' && Peek() == '\n')
+        {
+          Get();
+        }
+        errorCode = NextContentLine(hasLine);
+        if (errorCode != ErrorCode::OK)
+        {
+          return errorCode;
+        }
+        if (!hasLine)
+        {
+          return Fail(ErrorCode::InconsistentIndent, nullptr, "Expected indented block after ':'");
+        }
+        if (mIndentStack.back() <= bodyIndent)
+        {
+          return Fail(ErrorCode::InconsistentIndent, nullptr, "Expected deeper indentation for block value");
+        }
+        frame.resume = Frame::Resume::AfterBlockValue;
+        childIndent = mIndentStack.back();
+        return ErrorCode::OK;
+      }
+    }
+
+    // Inline array elements, separated by ',' up to ']'
+    ErrorCode StepInlineArray(Frame& frame, bool& ended)
+    {
+      if (frame.resume == Frame::Resume::AfterValue)
+      {
+        SkipWhitespaceAndComments();
+        if (Match(']'))
+        {
+          ended = true;
+          return ErrorCode::OK;
+        }
+        if (!Match(','))
+        {
+          return Fail(ErrorCode::UnexpectedChar, nullptr, "Expected ',' or ']' in inline array");
+        }
+        SkipWhitespaceAndComments();
+      }
+      ended = Match(']');
+      frame.resume = Frame::Resume::AfterValue;
+      return ErrorCode::OK;
+    }
+
+    // Multiline array elements, separated by ',' or newlines at arrayIndent until ']' or a dedent; a ']' right after
+    // the one that ended the array is consumed too
+    ErrorCode StepMultilineArray(Frame& frame, bool& ended)
+    {
+      const int arrayIndent = frame.indent;
+      if (frame.resume == Frame::Resume::AfterValue)
+      {
+        bool hasLine = false;
+        ErrorCode errorCode = ErrorCode::OK;
+        if (mIndentStack.back() >= arrayIndent)
+        {
+          SkipInlineSpaces();
+        }
+        if (mIndentStack.back() < arrayIndent || Match(']'))
+        {
+          ended = true;
+        }
+        else if (Peek() == '#')
+        {
+          SkipToEOL();
+          errorCode = NextContentLine(hasLine);
+          ended = !hasLine || mIndentStack.back() < arrayIndent;
+        }
+        else if (Match(','))
+        {
+          SkipWhitespaceAndComments();
+        }
+        else if (Peek() == '\r' || Peek() == '\n')
+        {
+          if (Get() == '\r' && Peek() == '\n')
+          {
+            Get();
+          }
+          errorCode = NextContentLine(hasLine);
+          ended = !hasLine || mIndentStack.back() < arrayIndent;
+        }
+        else
+        {
+          return Fail(ErrorCode::UnexpectedChar, nullptr, "Expected ',' or ']' or newline in multiline array");
+        }
+        if (errorCode != ErrorCode::OK)
+        {
+          return errorCode;
+        }
+      }
+      ended = ended || Match(']');
+      if (ended)
+      {
+        Match(']');
+      }
+      frame.resume = Frame::Resume::AfterValue;
+      return ErrorCode::OK;
+    }
+
+    ErrorCode ParseKey(std::string_view& outKey)
+    {
+      SkipInlineSpaces();
+      char c = Peek();
+      if (c == '"' || c == '\'')
+      {
+        return ScanQuoted(c, outKey);
+      }
+      if (!IsIdentifierStart(c))
+      {
+        return Fail(ErrorCode::UnexpectedChar, nullptr, "Expected identifier or string as key");
+      }
+      outKey = ScanIdentifier();
+      return CheckString(outKey.size());
+    }
+  };
+
+  using Parser = BasicParser<true>;
+
+  inline ErrorCode Parse(std::string_view src, Value& out, Error* error = nullptr)
+  {
+    Parser p(src);
+    return p.Parse(out, error);
+  }
+
+  // Parse into out reusing the capacity of its current strings / containers (out is null on failure). This builds a
+  // new Parser per call, whose indent / build stacks and spare lists allocate every time; for an allocation-free
+  // steady state keep one Parser and call Reset + Parser::ParseInPlace.
+  inline ErrorCode ParseInPlace(std::string_view src, Value& out, Error* error = nullptr)
+  {
+    Parser p(src);
+    return p.ParseInPlace(out, error);
+  }
+
+  inline ErrorCode Parse(std::string_view src, Value& out, const ParseOptions& options, Error* error = nullptr)
+  {
+    if (options.trustedInput)
+    {
+      BasicParser<false> p(src, {}, options);
+      return p.Parse(out, error);
+    }
+    Parser p(src, {}, options);
+    return p.Parse(out, error);
+  }
+
+  // Stream src to an EventHandler-style handler without building a tree
+  template <typename Handler>
+  ErrorCode ParseEvents(std::string_view src, Handler& handler, Error* error = nullptr)
+  {
+    Parser p(src);
+    return p.ParseEvents(handler, error);
+  }
+
+  namespace detail
+  {
+    // Finds the top-level member boundaries of an indent-style root object: line starts with content (not blank /
+    // comment) at column 1, outside brackets, strings and triple strings. Resumable, so input may arrive in chunks.
+    class RootBoundaryScanner
+    {
+    public:
+      // Advance position through text. Returns true with position at the start of the next member, or false with
+      // position where scanning resumes: the end of text, or (unless atEnd) a byte whose meaning depends on input that
+      // has not arrived yet.
+      bool Next(std::string_view text, std::size_t& position, bool atEnd)
+      {
+        const std::size_t size = text.size();
+        while (position < size)
+        {
+          char c = text[position];
+          switch (mState)
+          {
+            case State::Code:
+              if (mLineStart)
+              {
+                mLineStart = false;
+                if (mDepth == 0 && c != ' ' && c != '\t' && c != '\r' && c != '\n' && c != '#')
+                {
+                  return true;
+                }
+              }
+              if (c == '"')
+              {
+                if (position + 2 >= size && !atEnd)
+                {
+                  return false;
+                }
+                if (position + 2 < size && text[position + 1] == '"' && text[position + 2] == '"')
+                {
+                  mState = State::Triple;
+                  position += 3;
+                  continue;
+                }
+                mState = State::Double;
+              }
+              else if (c == '\'')
+              {
+                mState = State::Single;
+              }
+              else if (c == '#')
+              {
+                mState = State::Comment;
+              }
+              else if (c == '[' || c == '{')
+              {
+                ++mDepth;
+              }
+              else if ((c == ']' || c == '}') && mDepth > 0)
+              {
+                --mDepth;
+              }
+              else if (c == '\n')
+              {
+                mLineStart = true;
+              }
+              break;
+            case State::Comment:
+              if (c == '\n')
+              {
+                mState = State::Code;
+                mLineStart = true;
+              }
+              break;
+            case State::Double:
+            case State::Single:
+              if (c == '\\')
+              {
+                if (position + 1 >= size && !atEnd)
+                {
+                  return false;
+                }
+                ++position; // Escaped character
+              }
+              else if (c == (mState == State::Double ? '"' : '\''))
+              {
+                mState = State::Code;
+              }
+              else if (c == '\n')
+              {
+                // Unterminated; the member's parse reports it
+                mState = State::Code;
+                mLineStart = true;
+              }
+              break;
+            case State::Triple:
+              if (c == '"')
+              {
+                if (position + 2 >= size && !atEnd)
+                {
+                  return false;
+                }
+                if (position + 2 < size && text[position + 1] == '"' && text[position + 2] == '"')
+                {
+                  mState = State::Code;
+                  position += 3;
+                  continue;
+                }
+              }
+              break;
+          }
+          ++position;
+        }
+        return false;
+      }
+
+      // True when the scanned input ends outside brackets, strings and triple strings
+      bool Balanced() const
+      {
+        return mDepth == 0 && (mState == State::Code || mState == State::Comment);
+      }
+
+    private:
+      enum class State
+      {
+        Code,
+        Comment,
+        Double,
+        Single,
+        Triple,
+      };
+
+      State mState = State::Code;
+      std::size_t mDepth = 0; // Open '[' / '{'
+      bool mLineStart = false;
+    };
+  } // namespace detail
+
+  // Push parser for input that arrives in chunks (sockets, pipes). For an indent-style root object, each top-level
+  // member is parsed and delivered to handler as soon as it is complete, i.e. once the next line starts at column 1
+  // outside brackets and strings; any other root shape is parsed as a whole by Finish(). Chunks may split lines,
+  // indentation, triple strings and UTF-8 sequences anywhere. Invalid UTF-8 is detected per member, so a syntax error
+  // in an earlier member is reported before it. One document per StreamParser; options apply to each member (limits,
+  // iterative, trustedInput skipping the UTF-8 check).
+  template <typename Handler>
+  class StreamParser : private Parser
+  {
+  public:
+    explicit StreamParser(Handler& handler, std::string_view filename = {}, const ParseOptions& options = {})
+      : Parser({}, filename, options), mHandler(handler)
+    {}
+
+    // Append the next chunk and deliver the events of every member it completes
+    ErrorCode Feed(std::string_view chunk, Error* error = nullptr)
+    {
+      if (mResult != ErrorCode::OK || mFinished)
+      {
+        return Sticky(error);
+      }
+      mBuffer.append(chunk);
+      if (mMode == RootShape::Undecided)
+      {
+        Classify(false);
+      }
+      if (mMode == RootShape::Members)
+      {
+        ErrorCode errorCode = ScanMembers(error);
+
+        // Drop consumed input
+        mBuffer.erase(0, mSegmentStart);
+        mScan -= mSegmentStart;
+        mSegmentStart = 0;
+        if (errorCode != ErrorCode::OK)
+        {
+          return errorCode;
+        }
+      }
+      if (error)
+      {
+        *error = {};
+      }
+      return ErrorCode::OK;
+    }
+
+    // End of input: parse the remainder and close the document
+    ErrorCode Finish(Error* error = nullptr)
+    {
+      if (mResult != ErrorCode::OK || mFinished)
+      {
+        return Sticky(error);
+      }
+      mFinished = true;
+      if (mMode == RootShape::Undecided)
+      {
+        Classify(true);
+      }
+      if (mMode == RootShape::Whole)
+      {
+        mSrc = mBuffer;
+        mResult = ParseEvents(mHandler, error);
+        return mResult;
+      }
+
+      ErrorCode errorCode = ParseSegment(mBuffer.size(), error);
+      if (errorCode != ErrorCode::OK)
+      {
+        return errorCode;
+      }
+      if (!mHandler.OnObjectEnd())
+      {
+        return Report(Abort(), error);
+      }
+      if (error)
+      {
+        *error = {};
+      }
+      return ErrorCode::OK;
+    }
+
+    using Parser::LastError;
+
+  private:
+    // Forwards events except the per-segment root object events: only the first segment's OnObjectStart passes, the
+    // root's end is emitted by Finish()
+    struct RootFilter
+    {
+      Handler& handler;
+      bool forwardRootStart = false;
+      std::size_t depth = 0;
+
+      bool OnNull()
+      {
+        return handler.OnNull();
+      }
+
+      bool OnBool(bool value)
+      {
+        return handler.OnBool(value);
+      }
+
+      bool OnNumber(double value)
+      {
+        return handler.OnNumber(value);
+      }
+
+      bool OnString(std::string_view value)
+      {
+        return handler.OnString(value);
+      }
+
+      bool OnArrayStart()
+      {
+        return handler.OnArrayStart();
+      }
+
+      bool OnArrayEnd()
+      {
+        return handler.OnArrayEnd();
+      }
+
+      bool OnObjectStart()
+      {
+        if (depth++ == 0 && !forwardRootStart)
+        {
+          return true;
+        }
+        return handler.OnObjectStart();
+      }
+
+      bool OnKey(std::string_view key)
+      {
+        return handler.OnKey(key);
+      }
+
+      bool OnObjectEnd()
+      {
+        return --depth == 0 || handler.OnObjectEnd();
+      }
+    };
+
+    Handler& mHandler;
+    std::string mBuffer; // Unconsumed input; the current member starts at mSegmentStart
+    RootShape mMode = RootShape::Undecided;
+    detail::RootBoundaryScanner mScanner;
+    std::size_t mScan = 0; // Next byte for the boundary scanner
+    std::size_t mSegmentStart = 0;
+    std::size_t mSegmentLine = 1; // Document line of mSegmentStart
+    bool mStarted = false; // First member (with the root's OnObjectStart) delivered
+    bool mFinished = false;
+    ErrorCode mResult = ErrorCode::OK;
+
+    ErrorCode Sticky(Error* error) const
+    {
+      if (error)
+      {
+        *error = mError;
+      }
+      return mResult != ErrorCode::OK ? mResult : ErrorCode::InternalError;
+    }
+
+    ErrorCode Report(ErrorCode code, Error* error)
+    {
+      if (mError.code == ErrorCode::OK)
+      {
+        mError.code = code;
+        mError.where = Location();
+        mError.message.clear();
+      }
+      mResult = code;
+      if (error)
+      {
+        *error = mError;
+      }
+      return code;
+    }
+
+    // Decide the root shape once its first content line is complete; members are scanned from the first content
+    void Classify(bool atEnd)
+    {
+      std::size_t contentStart = 0;
+      mMode = ClassifyRoot(mBuffer, atEnd, contentStart);
+      if (mMode == RootShape::Undecided && atEnd)
+      {
+        mMode = RootShape::Whole;
+      }
+      if (mMode == RootShape::Members)
+      {
+        mScan = contentStart;
+      }
+    }
+
+    // Advance the boundary scanner over buffered input, parsing every member it completes
+    ErrorCode ScanMembers(Error* error)
+    {
+      while (mScanner.Next(mBuffer, mScan, false))
+      {
+        ErrorCode errorCode = ParseSegment(mScan, error);
+        if (errorCode != ErrorCode::OK)
+        {
+          return errorCode;
+        }
+      }
+      return ErrorCode::OK;
+    }
+
+    // Parse the member in [mSegmentStart, end) and deliver its events. Members start at column 1, so only the line
+    // needs offsetting; the indent unit carries over from earlier members.
+    ErrorCode ParseSegment(std::size_t end, Error* error)
+    {
+      const bool first = !mStarted;
+      mStarted = true;
+      ResetSpan(std::string_view(mBuffer).substr(mSegmentStart, end - mSegmentStart), mSegmentLine, mIndentUnit);
+      if (!ValidateRootSpan(first))
+      {
+        return Report(Fail(ErrorCode::InvalidUtf8, nullptr, "Invalid UTF-8 encoding"), error);
+      }
+
+      RootFilter filter{mHandler, first};
+      ErrorCode errorCode = ParseRootSpan(filter, first);
+      if (errorCode == ErrorCode::InconsistentIndent && mPos == mSrc.size() && end < mBuffer.size())
+      {
+        // A block value missing at the end of the member; the next member's line (indent 0) follows, which is what a
+        // whole-document parse would report
+        mError.message = "Expected deeper indentation for block value";
+      }
+      if (errorCode != ErrorCode::OK)
+      {
+        return Report(errorCode, error);
+      }
+
+      mSegmentLine += static_cast<std::size_t>(std::count(mSrc.begin(), mSrc.end(), '\n'));
+      mSegmentStart = end;
+      return ErrorCode::OK;
+    }
+  };
+
+  // Parse into an allocator-aware tree whose strings / containers all live in arena (typically a
+  // std::pmr::monotonic_buffer_resource), so parsing only does a few large allocations
+  inline ErrorCode Parse(std::string_view src, pmr::Value& out, std::pmr::memory_resource& arena, Error* error = nullptr)
+  {
+    Parser p(src);
+    return p.Parse(out, arena, error);
+  }
+
+  inline ErrorCode
+  Parse(std::string_view src, pmr::Value& out, std::pmr::memory_resource& arena, const ParseOptions& options, Error* error = nullptr)
+  {
+    if (options.trustedInput)
+    {
+      BasicParser<false> p(src, {}, options);
+      return p.Parse(out, arena, error);
+    }
+    Parser p(src, {}, options);
+    return p.Parse(out, arena, error);
+  }
+
+  // Parsed document that owns its monotonic arena. The root lives inside the arena and is never destroyed
+  // node-by-node: dropping (or re-parsing) the document just releases the arena. Anything stored into Root() must
+  // therefore be allocated from Resource().
+  class ArenaDocument
+  {
+  public:
+    explicit ArenaDocument(std::size_t initialSize = 64 * 1024) : mArena(initialSize)
+    {
+      mRoot = NewRoot();
+    }
+
+    ArenaDocument(const ArenaDocument&) = delete;
+    ArenaDocument& operator=(const ArenaDocument&) = delete;
+
+    // Replace the document with the parse result of src (null root on failure)
+    ErrorCode Parse(std::string_view src, Error* error = nullptr)
+    {
+      return Parse(src, ParseOptions{}, error);
+    }
+
+    ErrorCode Parse(std::string_view src, const ParseOptions& options, Error* error = nullptr)
+    {
+      mArena.release();
+      mRoot = NewRoot();
+      ErrorCode errorCode = havCSON::Parse(src, *mRoot, mArena, options, error);
+      if (errorCode != ErrorCode::OK)
+      {
+        mArena.release();
+        mRoot = NewRoot();
+      }
+      return errorCode;
+    }
+
+    pmr::Value& Root()
+    {
+      return *mRoot;
+    }
+
+    const pmr::Value& Root() const
+    {
+      return *mRoot;
+    }
+
+    std::pmr::memory_resource* Resource()
+    {
+      return &mArena;
+    }
+
+  private:
+    std::pmr::monotonic_buffer_resource mArena;
+    pmr::Value* mRoot = nullptr;
+
+    pmr::Value* NewRoot()
+    {
+      return new (mArena.allocate(sizeof(pmr::Value), alignof(pmr::Value))) pmr::Value();
+    }
+  };
+
+  // Zero-copy parse result: keys / strings view the source buffer, which must outlive the document. Only literals
+  // containing escapes are materialized (owned by the document).
+  class BorrowedDocument
+  {
+  public:
+    BorrowedDocument() = default;
+    BorrowedDocument(BorrowedDocument&&) = default;
+    BorrowedDocument& operator=(BorrowedDocument&&) = default;
+    BorrowedDocument(const BorrowedDocument&) = delete;
+    BorrowedDocument& operator=(const BorrowedDocument&) = delete;
+
+    // Replace the document with the parse result of src (null root on failure)
+    ErrorCode Parse(std::string_view src, Error* error = nullptr)
+    {
+      mRoot = nullptr;
+      mOwnedStrings.clear();
+      mSource = src;
+      Parser p(src);
+      ErrorCode errorCode = p.Parse(mRoot, mOwnedStrings, error);
+      if (errorCode != ErrorCode::OK)
+      {
+        mRoot = nullptr;
+        mOwnedStrings.clear();
+      }
+      return errorCode;
+    }
+
+    const borrowed::Value& Root() const
+    {
+      return mRoot;
+    }
+
+    std::string_view Source() const
+    {
+      return mSource;
+    }
+
+  private:
+    std::string_view mSource;
+    std::deque<std::string> mOwnedStrings; // Decoded literals; deque keeps their addresses stable
+    borrowed::Value mRoot;
+  };
+
+  inline ErrorCode Parse(std::string_view src, BorrowedDocument& out, Error* error = nullptr)
+  {
+    return out.Parse(src, error);
+  }
+
+  namespace detail
+  {
+    // Lossless parser: preserves comment lines and ordering into LosslessValue
+    class LosslessParser : private Parser
+    {
+    public:
+      // Comment texts view source, which the tree keeps alive
+      explicit LosslessParser(std::shared_ptr<const std::string> source, const ParseOptions& options = {})
+        : Parser(*source, {}, options), mSource(std::move(source))
+      {}
+
+      using Parser::Stats;
+
+      ErrorCode Parse(LosslessValue& out, Error* error)
+      {
+        // Reset previous error state for a fresh parse
+        mError = {};
+        ResetCounters();
+        [[maybe_unused]] StatsScope statsScope(mStats.total, mPos);
+
+        // Validate UTF-8 up front (strips leading BOM)
+        if (!ValidateSource())
+        {
+          return Finish(ErrorCode::InvalidUtf8, error, "Invalid UTF-8 encoding");
+        }
+        const std::size_t documentStart = 0; // A leading BOM too, so keepSourceText writes it back
+
+        bool hasLine = false;
+        ErrorCode errorCode = NextContentLineLossless(hasLine, mPendingComments);
+        if (errorCode != ErrorCode::OK)
+        {
+          return Finish(errorCode, error);
+        }
+
+        if (!hasLine)
+        {
+          return Finish(ErrorCode::UnexpectedEnd, error, "Empty document");
+        }
+
+        errorCode = ParseValueLossless(out, 0);
+        if (errorCode != ErrorCode::OK)
+        {
+          return Finish(errorCode, error);
+        }
+
+        // After parsing top-level value, consume any remaining whitespace / comments and ensure we're back at indent
+        // level 0
+        while (!EndOfFile())
+        {
+          char c = Peek();
+          if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+          {
+            Get();
+            continue;
+          }
+          if (c == '#')
+          {
+            SkipToEOL();
+            continue;
+          }
+          break;
+        }
+
+        // Any remaining pending comments belong after the root value
+        if (!mPendingComments.empty())
+        {
+          out.trailingComments.insert(
+            out.trailingComments.end(), std::make_move_iterator(mPendingComments.begin()), std::make_move_iterator(mPendingComments.end()));
+          mPendingComments.clear();
+        }
+
+        // Reset indent stack to base level
+        mIndentStack.clear();
+        mIndentStack.push_back(0);
+
+        if (!EndOfFile())
+        {
+          return Finish(ErrorCode::UnexpectedChar, error, "Trailing characters after top-level value");
+        }
+
+        // The root spans the whole document, so writing it from source keeps the comments around it
+        out.sourceText = Text(mSrc.substr(documentStart));
+        RecordShapes(out);
+
+        if (error)
+        {
+          *error = {};
+        }
+
+        return ErrorCode::OK;
+      }
+
+    private:
+      std::shared_ptr<const std::string> mSource;
+      std::vector<LosslessComment> mPendingComments;
+      std::size_t mValueEnd = 0; // End of the last value parsed, before any spaces / comments after it
+
+      // Comments are attached after their value was parsed, so shapes are taken once the tree is complete
+      static void RecordShapes(LosslessValue& value)
+      {
+        value.sourceShape = LosslessShape(value);
+        for (LosslessValue& item : value.arrayItems)
+        {
+          RecordShapes(item);
+        }
+        for (auto& item : value.objectItems)
+        {
+          RecordShapes(item.second);
+        }
+      }
+
+      // Distance from the key at keyStart to the text of the member parsed after it
+      std::size_t KeyDistance(std::size_t keyStart, const LosslessValue& member) const
+      {
+        return static_cast<std::size_t>(member.sourceText.view().data() - (mSrc.data() + keyStart));
+      }
+
+      LosslessText Text(std::string_view view) const
+      {
+        return LosslessText(mSource, view);
+      }
+
+      // Advance to the end of the current line (before CR / LF) and return the text passed over
+      std::string_view TakeRestOfLine()
+      {
+        std::size_t end = std::min(mSrc.find_first_of("\r\n", mPos), mSrc.size());
+        std::string_view text = mSrc.substr(mPos, end - mPos);
+        Advance(end - mPos);
+        return text;
+      }
+
+      ErrorCode Finish(ErrorCode errorCode, Error* error, std::optional<std::string_view> message = std::nullopt)
+      {
+        // Prefer existing detailed error (e.g., from base Fail) unless a new message is supplied
+        if (message.has_value())
+        {
+          mError.code = errorCode;
+          mError.where = Location();
+          mError.message.assign(message->data(), message->size());
+        }
+        else if (mError.code == ErrorCode::OK)
+        {
+          mError.code = errorCode;
+          mError.where = Location();
+          mError.message.clear();
+        }
+
+        if (error)
+        {
+          if (message.has_value())
+          {
+            error->code = errorCode;
+            error->where = Location();
+            error->message.assign(message->data(), message->size());
+          }
+          else if (mError.code != ErrorCode::OK)
+          {
+            *error = mError;
+          }
+          else
+          {
+            error->code = errorCode;
+            error->where = Location();
+            error->message.clear();
+          }
+        }
+        return errorCode;
+      }
+
+      // Collect comment / blank lines into out while advancing to the next content line
+      ErrorCode NextContentLineLossless(bool& hasLine, std::vector<LosslessComment>& comments)
+      {
+        hasLine = false;
+        while (!EndOfFile())
+        {
+          if (!AtLineStart())
+          {
+            SkipToEOL();
+            if (EndOfFile())
+            {
+              return ErrorCode::OK;
+            }
+            continue;
+          }
+
+          int indentCols = 0;
+          bool hasContent = false;
+          std::size_t lineStart = mPos;
+          ErrorCode errorCode = ReadLineIndent(indentCols, hasContent);
+          if (errorCode != ErrorCode::OK)
+          {
+            return errorCode;
+          }
+
+          if (!hasContent)
+          {
+            std::string_view line = mSrc.substr(lineStart, mPos - lineStart);
+            while (!line.empty() && (line.back() == '\r' || line.back() == '\n'))
+            {
+              line.remove_suffix(1);
+            }
+            // Store indent and text after indent (none -> blank line)
+            LosslessComment& losslessComment = comments.emplace_back();
+            losslessComment.indent = indentCols;
+            if (static_cast<std::size_t>(indentCols) < line.size())
+            {
+              losslessComment.text = Text(line.substr(static_cast<std::size_t>(indentCols)));
+            }
+            continue;
+          }
+
+          errorCode = ApplyIndentLevel(indentCols);
+          if (errorCode != ErrorCode::OK)
+          {
+            return errorCode;
+          }
+
+          hasLine = true;
+          return ErrorCode::OK;
+        }
+        return ErrorCode::OK; // EOF
+      }
+
+      ErrorCode ParseValueLossless(LosslessValue& out, int currentIndent, bool consumePending = true)
+      {
+        if (consumePending && !mPendingComments.empty())
+        {
+          out.leadingComments.insert(
+            out.leadingComments.end(), std::make_move_iterator(mPendingComments.begin()), std::make_move_iterator(mPendingComments.end()));
+          mPendingComments.clear();
+        }
+
+        const std::size_t start = mPos;
+        ErrorCode errorCode = EnterValue(sizeof(LosslessValue));
+        if (errorCode == ErrorCode::OK)
+        {
+          errorCode = ParseValueKindLossless(out, currentIndent);
+        }
+        --mDepth;
+        if (errorCode == ErrorCode::OK)
+        {
+          out.sourceText = Text(mSrc.substr(start, mValueEnd - start));
+        }
+        return errorCode;
+      }
+
+      // ParseValueLossless without the pending comments; sets mValueEnd
+      ErrorCode ParseValueKindLossless(LosslessValue& out, int currentIndent)
+      {
+        char c = Peek();
+        if (c == '{')
+        {
+          out.value = Object{};
+          ErrorCode errorCode = ParseInlineObjectLossless(out, currentIndent);
+          mValueEnd = mPos;
+          return errorCode;
+        }
+        if (c == '[')
+        {
+          out.value = Array{};
+          ErrorCode errorCode = ParseArrayLossless(out, currentIndent);
+          // A multiline array may end by dedent instead of ']'; it then ends with its last element
+          if (mPos > 0 && mSrc[mPos - 1] == ']')
+          {
+            mValueEnd = mPos;
+          }
+          else if (out.arrayItems.empty())
+          {
+            mValueEnd = mPos;
+          }
+          return errorCode;
+        }
+        if (c == '"' || c == '\'')
+        {
+          std::string_view text;
+          ErrorCode errorCode = c == '"' ? ScanStringOrTriple(text) : ScanQuoted('\'', text);
+          if (errorCode == ErrorCode::OK)
+          {
+            out.value = std::string(text);
+          }
+          mValueEnd = mPos;
+          return errorCode;
+        }
+        if (IsIdentifierStart(c))
+        {
+          return ParseIdentifierOrIndentedObjectLossless(out, currentIndent);
+        }
+        if (IsNumberStart(c))
+        {
+          double number = 0.0;
+          ErrorCode errorCode = ScanNumber(number);
+          if (errorCode == ErrorCode::OK)
+          {
+            out.value = number;
+          }
+          mValueEnd = mPos;
+          return errorCode;
+        }
+        if (EndOfFile())
+        {
+          return Finish(ErrorCode::UnexpectedEnd, nullptr, "Unexpected end of input while parsing value");
+        }
+        return Finish(ErrorCode::UnexpectedChar, nullptr, "Unexpected character while parsing value");
+      }
+
+      ErrorCode ParseInlineObjectLossless(LosslessValue& out, int currentIndent)
+      {
+        if (!Match('{'))
+        {
+          return Finish(ErrorCode::InternalError, nullptr);
+        }
+        out.value = Object{};
+        SkipWhitespaceAndComments();
+        if (Match('}'))
+        {
+          return ErrorCode::OK;
+        }
+        while (true)
+        {
+          // Comments collected before this key belong to this entry
+          std::vector<LosslessComment> preKeyComments;
+          if (!mPendingComments.empty())
+          {
+            preKeyComments.swap(mPendingComments);
+          }
+
+          const std::size_t keyStart = mPos;
+          std::string_view keyView;
+          ErrorCode errorCode = ParseKey(keyView);
+          if (errorCode != ErrorCode::OK)
+          {
+            return errorCode;
+          }
+          std::string key(keyView);
+          SkipWhitespaceAndComments();
+          if (!Match(':'))
+          {
+            return Finish(ErrorCode::UnexpectedChar, nullptr, "Expected ':' in inline object");
+          }
+          SkipWhitespaceAndComments();
+          LosslessValue child;
+          errorCode = ParseValueLossless(child, currentIndent);
+          if (errorCode != ErrorCode::OK)
+          {
+            return errorCode;
+          }
+          child.sourceKeyDistance = KeyDistance(keyStart, child);
+          out.objectItems.emplace_back(std::move(key), std::move(child));
+          SkipWhitespaceAndComments();
+          if (Match('}'))
+          {
+            break;
+          }
+          if (!Match(','))
+          {
+            return Finish(ErrorCode::UnexpectedChar, nullptr, "Expected ',' in inline object");
+          }
+          SkipWhitespaceAndComments();
+        }
+        return ErrorCode::OK;
+      }
+
+      ErrorCode ParseArrayLossless(LosslessValue& out, int parentIndent)
+      {
+        if (!Match('['))
+        {
+          return Finish(ErrorCode::InternalError, nullptr);
+        }
+
+        out.value = Array{};
+
+        SkipInlineSpaces();
+        bool isMultiline = (Peek() == '\r' || Peek() == '\n');
+
+        if (isMultiline)
+        {
+          char c = Get();
+          if (c == '\r' && Peek() == '\n')
+          {
+            Get();
+          }
+
+          bool hasLine = false;
+          ErrorCode errorCode = NextContentLineLossless(hasLine, mPendingComments);
+          if (errorCode != ErrorCode::OK)
+          {
+            return errorCode;
+          }
+          if (!hasLine || Peek() == ']')
+          {
+            if (Peek() == ']')
+            {
+              Get();
+            }
+            return ErrorCode::OK;
+          }
+
+          int arrayIndent = mIndentStack.back();
+          while (true)
+          {
+            if (Peek() == ']')
+            {
+              Get();
+              break;
+            }
+
+            LosslessValue child;
+            errorCode = ParseValueLossless(child, arrayIndent, false);
+            if (errorCode != ErrorCode::OK)
+            {
+              return errorCode;
+            }
+            out.arrayItems.push_back(std::move(child));
+
+            SkipInlineSpaces();
+            if (Peek() == '#')
+            {
               // If comment starts at current indent, treat as leading comment for next element
               if (mCol <= arrayIndent + 1)
               {
-                std::string line;
-                Get(); // consume '#'
-                line.push_back('#');
-                while (!EndOfFile())
-                {
-                  char ch = Peek();
-                  if (ch == '\r' || ch == '\n')
-                  {
-                    break;
-                  }
-                  line.push_back(Get());
-                }
-                LosslessComment losslessComment;
-                losslessComment.indent = static_cast<int>(mCol) - 1;
-                if (losslessComment.indent < 0)
-                {
-                  losslessComment.indent = 0;
-                }
-                losslessComment.text = std::move(line);
-                mPendingComments.push_back(std::move(losslessComment));
-                SkipToEOL();
-                bool hasLine2 = false;
-                errorCode = NextContentLineLossless(hasLine2, mPendingComments);
-                if (errorCode != ErrorCode::OK)
-                {
-                  return errorCode;
-                }
-                if (!hasLine2)
-                {
-                  break;
-                }
-                continue;
+                std::string_view line = TakeRestOfLine(); // Including the '#'
+                LosslessComment& losslessComment = mPendingComments.emplace_back();
+                losslessComment.indent = std::max(static_cast<int>(mCol) - 1, 0);
+                losslessComment.text = Text(line);
+                SkipToEOL();
+                bool hasLine2 = false;
+                errorCode = NextContentLineLossless(hasLine2, mPendingComments);
+                if (errorCode != ErrorCode::OK)
+                {
+                  return errorCode;
+                }
+                if (!hasLine2)
+                {
+                  break;
+                }
+                continue;
+              }
+              else
+              {
+                Get(); // '#'
+                std::string_view comment = TakeRestOfLine();
+                if (!out.arrayItems.empty())
+                {
+                  out.arrayItems.back().inlineComment = Text(comment);
+                }
+                SkipToEOL();
+                bool hasLine2 = false;
+                errorCode = NextContentLineLossless(hasLine2, mPendingComments);
+                if (errorCode != ErrorCode::OK)
+                {
+                  return errorCode;
+                }
+                if (!hasLine2)
+                {
+                  break;
+                }
+                continue;
+              }
+            }
+            if (Match(']'))
+            {
+              break;
+            }
+            if (Match(','))
+            {
+              SkipWhitespaceAndComments();
+              continue;
+            }
+            if (Peek() == '\r' || Peek() == '\n')
+            {
+              c = Get();
+              if (c == '\r' && Peek() == '\n')
+              {
+                Get();
+              }
+              bool hasLine2 = false;
+              errorCode = NextContentLineLossless(hasLine2, mPendingComments);
+              if (errorCode != ErrorCode::OK)
+              {
+                return errorCode;
+              }
+              if (!hasLine2 || mIndentStack.back() < arrayIndent)
+              {
+                break;
+              }
+              continue;
+            }
+            return Finish(ErrorCode::UnexpectedChar, nullptr, "Expected ',' or ']' or newline in multiline array");
+          }
+
+          // After loop, consume closing ] if present
+          if (Peek() == ']')
+          {
+            Get();
+          }
+        }
+        else
+        {
+          SkipWhitespaceAndComments();
+          if (Match(']'))
+          {
+            return ErrorCode::OK;
+          }
+
+          while (true)
+          {
+            if (Peek() == ']')
+            {
+              Get();
+              break;
+            }
+
+            LosslessValue child;
+            ErrorCode errorCode = ParseValueLossless(child, parentIndent);
+            if (errorCode != ErrorCode::OK)
+            {
+              return errorCode;
+            }
+            out.arrayItems.push_back(std::move(child));
+
+            SkipWhitespaceAndComments();
+            if (Match(']'))
+            {
+              break;
+            }
+            if (!Match(','))
+            {
+              return Finish(ErrorCode::UnexpectedChar, nullptr, "Expected ',' or ']' in inline array");
+            }
+            SkipWhitespaceAndComments();
+          }
+        }
+
+        return ErrorCode::OK;
+      }
+
+      ErrorCode ParseIdentifierOrIndentedObjectLossless(LosslessValue& out, int currentIndent)
+      {
+        std::string_view identifier = ScanIdentifier();
+        mValueEnd = mPos;
+        SkipInlineSpaces();
+        if (Peek() == ':')
+        {
+          Retreat(identifier.size());
+          out.value = Object{};
+          return ParseIndentedObjectBodyLossless(out, currentIndent);
+        }
+
+        if (identifier == "true")
+        {
+          out.value = true;
+          return ErrorCode::OK;
+        }
+        if (identifier == "false")
+        {
+          out.value = false;
+          return ErrorCode::OK;
+        }
+        if (identifier == "null")
+        {
+          out.value = nullptr;
+          return ErrorCode::OK;
+        }
+        out.value = std::string(identifier);
+        return CheckString(identifier.size());
+      }
+
+      ErrorCode ParseIndentedObjectBodyLossless(LosslessValue& outWrapper, int parentIndent)
+      {
+        int bodyIndent = -1;
+
+        while (true)
+        {
+          if (bodyIndent == -1)
+          {
+            bodyIndent = mIndentStack.back();
+          }
+
+          SkipInlineSpaces();
+          if (EndOfFile())
+          {
+            break;
+          }
+
+          if (Peek() == '#' || Peek() == '\r' || Peek() == '\n')
+          {
+            bool hasLine = false;
+            ErrorCode errorCode = NextContentLineLossless(hasLine, mPendingComments);
+            if (errorCode != ErrorCode::OK)
+            {
+              return errorCode;
+            }
+            if (!hasLine)
+            {
+              break;
+            }
+            if (mIndentStack.back() < bodyIndent)
+            {
+              break;
+            }
+            continue;
+          }
+
+          char c = Peek();
+          if (!IsIdentifierStart(c) && c != '"' && c != '\'')
+          {
+            break;
+          }
+
+          // Comments collected before this key belong to this entry
+          std::vector<LosslessComment> preKeyComments;
+          if (!mPendingComments.empty())
+          {
+            preKeyComments.swap(mPendingComments);
+          }
+
+          const std::size_t keyStart = mPos;
+          std::string_view keyView;
+          ErrorCode errorCode = ParseKey(keyView);
+          if (errorCode != ErrorCode::OK)
+          {
+            return errorCode;
+          }
+          std::string key(keyView);
+
+          SkipInlineSpaces();
+          if (!Match(':'))
+          {
+            return Finish(ErrorCode::UnexpectedChar, nullptr, "Expected ':' in object pair");
+          }
+          SkipInlineSpaces();
+
+          bool blockValue = false;
+          if (Peek() == '#')
+          {
+            blockValue = true;
+          }
+          else if (Peek() == '\r' || Peek() == '\n')
+          {
+            blockValue = true;
+          }
+
+          if (blockValue)
+          {
+            if (Peek() == '#')
+            {
+              SkipToEOL();
+            }
+            else
+            {
+              char c2 = Get();
+              if (c2 == '\r' && Peek() == '\n')
+              {
+                Get();
               }
-              else
+            }
+
+            bool hasLine = false;
+            ErrorCode errorCode2 = NextContentLineLossless(hasLine, mPendingComments);
+            if (errorCode2 != ErrorCode::OK)
+            {
+              return errorCode2;
+            }
+            if (!hasLine)
+            {
+              return Finish(ErrorCode::InconsistentIndent, nullptr, "Expected indented block after ':'");
+            }
+
+            if (mIndentStack.back() <= bodyIndent)
+            {
+              return Finish(ErrorCode::InconsistentIndent, nullptr, "Expected deeper indentation for block value");
+            }
+
+            LosslessValue child;
+            if (!preKeyComments.empty())
+            {
+              child.leadingComments = std::move(preKeyComments);
+              preKeyComments.clear();
+            }
+            errorCode2 = ParseValueLossless(child, mIndentStack.back(), false);
+            if (errorCode2 != ErrorCode::OK)
+            {
+              return errorCode2;
+            }
+
+            child.sourceKeyDistance = KeyDistance(keyStart, child);
+            outWrapper.objectItems.emplace_back(std::move(key), std::move(child));
+
+            // After parsing block value, check if we need to advance to next line
+            SkipInlineSpaces();
+            if (Peek() == '#')
+            {
+              SkipToEOL();
+            }
+            if (Peek() == '\r' || Peek() == '\n')
+            {
+              char c2 = Get();
+              if (c2 == '\r' && Peek() == '\n')
               {
-                std::string comment;
                 Get();
-                while (!EndOfFile())
-                {
-                  char ch = Peek();
-                  if (ch == '\r' || ch == '\n')
-                  {
-                    break;
-                  }
-                  comment.push_back(Get());
-                }
-                if (!out.arrayItems.empty())
-                {
-                  out.arrayItems.back().inlineComment = comment;
-                }
-                SkipToEOL();
-                bool hasLine2 = false;
-                errorCode = NextContentLineLossless(hasLine2, mPendingComments);
-                if (errorCode != ErrorCode::OK)
-                {
-                  return errorCode;
-                }
-                if (!hasLine2)
-                {
-                  break;
-                }
-                continue;
               }
+
+              bool hasLine = false;
+              ErrorCode ec3 = NextContentLineLossless(hasLine, mPendingComments);
+              if (ec3 != ErrorCode::OK)
+              {
+                return ec3;
+              }
+              if (!hasLine)
+              {
+                break;
+              }
+            }
+
+            if (mIndentStack.back() < bodyIndent)
+            {
+              break;
+            }
+            continue;
+          }
+
+          LosslessValue child;
+          if (!preKeyComments.empty())
+          {
+            child.leadingComments = std::move(preKeyComments);
+            preKeyComments.clear();
+          }
+          errorCode = ParseValueLossless(child, parentIndent);
+          if (errorCode != ErrorCode::OK)
+          {
+            return errorCode;
+          }
+          child.sourceKeyDistance = KeyDistance(keyStart, child);
+          outWrapper.objectItems.emplace_back(std::move(key), std::move(child));
+
+          SkipInlineSpaces();
+          if (Peek() == '#')
+          {
+            // If comment starts at current indent, treat as leading comment for next key
+            if (mCol <= bodyIndent + 1)
+            {
+              std::string_view line = TakeRestOfLine(); // Including the '#'
+              LosslessComment& losslessComment = mPendingComments.emplace_back();
+              losslessComment.indent = std::max(static_cast<int>(mCol) - 1, 0);
+              losslessComment.text = Text(line);
+              SkipToEOL();
+              bool hasLine = false;
+              ErrorCode errorCode2 = NextContentLineLossless(hasLine, mPendingComments);
+              if (errorCode2 != ErrorCode::OK)
+              {
+                return errorCode2;
+              }
+              if (!hasLine)
+              {
+                break;
+              }
+              if (mIndentStack.back() < bodyIndent)
+              {
+                break;
+              }
+              continue;
+            }
+            else
+            {
+              Get(); // '#'
+              std::string_view comment = TakeRestOfLine();
+              if (!outWrapper.objectItems.empty())
+              {
+                outWrapper.objectItems.back().second.inlineComment = Text(comment);
+              }
+              SkipToEOL();
+              bool hasLine = false;
+              ErrorCode errorCode2 = NextContentLineLossless(hasLine, mPendingComments);
+              if (errorCode2 != ErrorCode::OK)
+              {
+                return errorCode2;
+              }
+              if (!hasLine)
+              {
+                break;
+              }
+              if (mIndentStack.back() < bodyIndent)
+              {
+                break;
+              }
+              continue;
+            }
+          }
+          if (Match(','))
+          {
+            SkipInlineSpaces();
+            continue;
+          }
+          if (Peek() == '\r' || Peek() == '\n')
+          {
+            char c2 = Get();
+            if (c2 == '\r' && Peek() == '\n')
+            {
+              Get();
+            }
+
+            bool hasLine = false;
+            ErrorCode errorCode2 = NextContentLineLossless(hasLine, mPendingComments);
+            if (errorCode2 != ErrorCode::OK)
+            {
+              return errorCode2;
+            }
+            if (!hasLine)
+            {
+              break;
+            }
+            if (mIndentStack.back() < bodyIndent)
+            {
+              break;
+            }
+            continue;
+          }
+          break;
+        }
+
+        return ErrorCode::OK;
+      }
+    };
+  } // namespace detail
+
+  // Comment texts of out view a copy of src that they share ownership of
+  inline ErrorCode ParseLossless(std::string_view src, LosslessValue& out, Error* error = nullptr)
+  {
+    detail::LosslessParser losslessParser(std::make_shared<const std::string>(src));
+    return losslessParser.Parse(out, error);
+  }
+
+  // With limits for untrusted input (ParseOptions::iterative doesn't apply, the lossless parser recurses up to maxDepth)
+  inline ErrorCode ParseLossless(std::string_view src, LosslessValue& out, const ParseOptions& options, Error* error = nullptr)
+  {
+    detail::LosslessParser losslessParser(std::make_shared<const std::string>(src), options);
+    return losslessParser.Parse(out, error);
+  }
+
+  // Same, also reporting where the parse spent its time (see ParseStats; zero without HAVCSON_ENABLE_STATS)
+  inline ErrorCode ParseLossless(std::string_view src, LosslessValue& out, ParseStats& stats, Error* error = nullptr)
+  {
+    detail::LosslessParser losslessParser(std::make_shared<const std::string>(src));
+    const ErrorCode errorCode = losslessParser.Parse(out, error);
+    stats = losslessParser.Stats();
+    return errorCode;
+  }
+
+  // Plain Value for a lossless tree (comments dropped; a duplicate key keeps its first value, as in Parse)
+  inline Value ToValue(const LosslessValue& value)
+  {
+    if (value.value.isArray())
+    {
+      Array array;
+      array.reserve(value.arrayItems.size());
+      for (const LosslessValue& item : value.arrayItems)
+      {
+        array.push_back(ToValue(item));
+      }
+      return array;
+    }
+    if (value.value.isObject())
+    {
+      Object object;
+      object.reserve(value.objectItems.size());
+      for (const auto& [key, item] : value.objectItems)
+      {
+        if (!object.contains(key))
+        {
+          object.try_emplace(key, ToValue(item));
+        }
+      }
+      return object;
+    }
+    return value.value;
+  }
+
+  // Lossless tree (without comments) for a plain Value, e.g. to add new data to a parsed document
+  inline LosslessValue ToLossless(const Value& value)
+  {
+    LosslessValue result;
+    if (value.isArray())
+    {
+      result.value = Array{};
+      result.arrayItems.reserve(value.asArray().size());
+      for (const Value& item : value.asArray())
+      {
+        result.arrayItems.push_back(ToLossless(item));
+      }
+    }
+    else if (value.isObject())
+    {
+      result.value = Object{};
+      result.objectItems.reserve(value.asObject().size());
+      for (const auto& [key, item] : value.asObject())
+      {
+        result.objectItems.emplace_back(key, ToLossless(item));
+      }
+    }
+    else
+    {
+      result.value = value;
+    }
+    return result;
+  }
+
+  namespace detail
+  {
+    // Read the whole file at path into buffer
+    inline ErrorCode ReadFileUTF8(const std::string& path, std::string& buffer, Error* error)
+    {
+      auto fail = [error](std::string_view message) {
+        if (error)
+        {
+          error->code = ErrorCode::InternalError;
+          error->where = {};
+          error->message.assign(message.begin(), message.end());
+        }
+        return ErrorCode::InternalError;
+      };
+
+      auto fileStream = OpenFileUTF8(path, "rb");
+      if (!fileStream)
+      {
+        return fail("Failed to open file");
+      }
+      if (std::fseek(fileStream.get(), 0, SEEK_END) != 0)
+      {
+        return fail("Failed to read file");
+      }
+      long size = std::ftell(fileStream.get());
+      if (size < 0 || std::fseek(fileStream.get(), 0, SEEK_SET) != 0)
+      {
+        return fail("Failed to read file");
+      }
+      buffer.resize(static_cast<std::size_t>(size));
+      if (!buffer.empty())
+      {
+        if (std::fread(&buffer[0], 1, static_cast<std::size_t>(size), fileStream.get()) != static_cast<std::size_t>(size))
+        {
+          return fail("Failed to read file");
+        }
+      }
+      return ErrorCode::OK;
+    }
+
+    // Make the contents of path available as contents: a read-only mapping when possible (no copy; the file must not
+    // be truncated by another process while it is used), otherwise a buffered read into buffer
+    inline ErrorCode LoadFileUTF8(
+      const std::string& path,
+      std::optional<MappedFileUTF8>& mapping,
+      std::string& buffer,
+      std::string_view& contents,
+      Error* error)
+    {
+      mapping.emplace(path);
+      if (mapping->IsMapped())
+      {
+        contents = mapping->View();
+        return ErrorCode::OK;
+      }
+      mapping.reset();
+
+      // Fallback: buffered read into memory
+      ErrorCode errorCode = ReadFileUTF8(path, buffer, error);
+      contents = buffer;
+      return errorCode;
+    }
+  } // namespace detail
+
+  inline ErrorCode ParseFile(const std::string& path, Value& out, const ParseOptions& options, Error* error = nullptr)
+  {
+    std::optional<MappedFileUTF8> mapping;
+    std::string buffer;
+    std::string_view contents;
+    ErrorCode errorCode = detail::LoadFileUTF8(path, mapping, buffer, contents, error);
+    if (errorCode != ErrorCode::OK)
+    {
+      return errorCode;
+    }
+    return Parse(contents, out, options, error);
+  }
+
+  inline ErrorCode ParseFile(const std::string& path, Value& out, Error* error = nullptr)
+  {
+    return ParseFile(path, out, ParseOptions{}, error);
+  }
+
+  struct ParseFilesOptions
+  {
+    unsigned threads = 0; // Worker count including the calling thread; 0 -> std::thread::hardware_concurrency()
+    bool useArena = false; // Parse each file into its own ArenaDocument (FileParseResult::document) instead of value
+    ParseOptions parse; // Used for every file
+  };
+
+  namespace detail
+  {
+    // Worker threads joined when the group goes away, also while an exception unwinds, so a failed start never
+    // leaves a joinable std::thread behind (std::terminate)
+    class JoiningThreads
+    {
+    public:
+      explicit JoiningThreads(std::size_t capacity)
+      {
+        mThreads.reserve(capacity);
+      }
+
+      JoiningThreads(const JoiningThreads&) = delete;
+      JoiningThreads& operator=(const JoiningThreads&) = delete;
+
+      ~JoiningThreads()
+      {
+        Join();
+      }
+
+      // Run fn(args...) on a new thread; false if the system refused to start one (the caller does that work itself)
+      template <typename Fn, typename... Args>
+      bool Start(Fn&& fn, Args&&... args)
+      {
+        try
+        {
+          mThreads.emplace_back(std::forward<Fn>(fn), std::forward<Args>(args)...);
+          return true;
+        }
+        catch (const std::system_error&)
+        {
+          return false;
+        }
+      }
+
+      void Join()
+      {
+        for (std::thread& thread : mThreads)
+        {
+          thread.join();
+        }
+        mThreads.clear();
+      }
+
+    private:
+      std::vector<std::thread> mThreads;
+    };
+  } // namespace detail
+
+  struct FileParseResult
+  {
+    ErrorCode code = ErrorCode::OK;
+    Error error;
+    Value value; // Parsed tree unless ParseFilesOptions::useArena
+    std::unique_ptr<ArenaDocument> document; // Parsed tree with ParseFilesOptions::useArena
+  };
+
+  // Read and parse many files concurrently. Every worker owns its parser state and read buffer; files are split into
+  // one contiguous range per worker and idle workers steal from the back of the fullest range, so a few large files
+  // don't serialize the batch. results[i] belongs to paths[i].
+  inline std::vector<FileParseResult> ParseFiles(std::span<const std::string> paths, const ParseFilesOptions& options = {})
+  {
+    std::vector<FileParseResult> results(paths.size());
+
+    std::size_t workerCount = options.threads != 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    workerCount = std::max<std::size_t>(1, std::min(workerCount, paths.size()));
+
+    struct WorkRange
+    {
+      std::mutex mutex;
+      std::size_t next = 0;
+      std::size_t end = 0;
+    };
+    std::vector<WorkRange> ranges(workerCount);
+    for (std::size_t worker = 0; worker < workerCount; ++worker)
+    {
+      ranges[worker].next = paths.size() * worker / workerCount;
+      ranges[worker].end = paths.size() * (worker + 1) / workerCount;
+    }
+
+    // Own range from the front, otherwise steal from the back of the range with the most work left
+    auto take = [&ranges](std::size_t worker, std::size_t& index) {
+      {
+        std::lock_guard<std::mutex> lock(ranges[worker].mutex);
+        if (ranges[worker].next < ranges[worker].end)
+        {
+          index = ranges[worker].next++;
+          return true;
+        }
+      }
+      while (true)
+      {
+        std::size_t victim = ranges.size();
+        std::size_t mostLeft = 0;
+        for (std::size_t candidate = 0; candidate < ranges.size(); ++candidate)
+        {
+          std::lock_guard<std::mutex> lock(ranges[candidate].mutex);
+          std::size_t left = ranges[candidate].end - ranges[candidate].next;
+          if (left > mostLeft)
+          {
+            mostLeft = left;
+            victim = candidate;
+          }
+        }
+        if (victim == ranges.size())
+        {
+          return false;
+        }
+        std::lock_guard<std::mutex> lock(ranges[victim].mutex);
+        if (ranges[victim].next < ranges[victim].end)
+        {
+          index = --ranges[victim].end;
+          return true;
+        }
+      }
+    };
+
+    auto work = [&](std::size_t worker) {
+      std::optional<MappedFileUTF8> mapping;
+      std::string buffer;
+      std::size_t index = 0;
+      while (take(worker, index))
+      {
+        FileParseResult& result = results[index];
+        try
+        {
+          std::string_view contents;
+          result.code = detail::LoadFileUTF8(paths[index], mapping, buffer, contents, &result.error);
+          if (result.code == ErrorCode::OK)
+          {
+            if (options.useArena)
+            {
+              result.document = std::make_unique<ArenaDocument>();
+              result.code = result.document->Parse(contents, options.parse, &result.error);
+            }
+            else
+            {
+              result.code = Parse(contents, result.value, options.parse, &result.error);
+            }
+          }
+        }
+        catch (const std::exception& exception)
+        {
+          result.code = ErrorCode::InternalError;
+          result.error.code = ErrorCode::InternalError;
+          result.error.where = {};
+          result.error.message = exception.what();
+        }
+        mapping.reset();
+      }
+    };
+
+    // Ranges of workers that couldn't be started are stolen by the others (the calling thread at least)
+    detail::JoiningThreads threads(workerCount - 1);
+    for (std::size_t worker = 1; worker < workerCount && threads.Start(work, worker); ++worker)
+    {}
+    work(0);
+    threads.Join();
+    return results;
+  }
+
+  struct ParallelParseOptions
+  {
+    unsigned threads = 0; // Spans parsed concurrently, including the calling thread; 0 -> hardware concurrency
+    std::size_t minSpanBytes = 256 * 1024; // Never split into spans smaller than this
+    ParseOptions parse; // maxElements / maxAllocatedBytes budget the whole document, so setting either parses sequentially
+  };
+
+  namespace detail
+  {
+    // Parses one span of an indent-style root object for ParseParallel
+    class RootSpanParser : private Parser
+    {
+    public:
+      struct Result
+      {
+        ErrorCode code = ErrorCode::OK;
+        Error error; // Lines relative to the span start
+        Value value; // Object with the span's members
+        int indentUnit = 0; // Indent unit after the span (discovered by the span when it started without one)
+        std::size_t end = 0; // Where the span's members really ended: the next root member start, or src.size()
+      };
+
+      explicit RootSpanParser(const ParseOptions& options = {}) : Parser({}, {}, options)
+      {}
+
+      using Parser::ClassifyRoot;
+      using Parser::IsIdentifierStart;
+      using Parser::RootShape;
+
+      // Parse the root members of src from start (0, or the start of a line with a root member) until the first one
+      // that starts at column 1 at or after limit. The bytes before limit are the span's share of the UTF-8 check;
+      // the last member's value is read past limit as far as it goes.
+      Result Parse(std::string_view src, std::size_t start, std::size_t limit, int indentUnit)
+      {
+        Result result;
+        const bool first = start == 0;
+        ResetSpan(src.substr(start, limit - start), 1, indentUnit);
+        if (!ValidateRootSpan(first))
+        {
+          result.code = Fail(ErrorCode::InvalidUtf8, &result.error, "Invalid UTF-8 encoding");
+          return result;
+        }
+        const std::size_t contentStart = mPos; // After a BOM
+        ResetSpan(src.substr(start), 1, indentUnit);
+        SetPosition(contentStart, 1, 1);
+
+        ValueBuilder<Value> builder(result.value);
+        result.code = ParseRootSpan(builder, first, limit - start);
+        if (result.code != ErrorCode::OK)
+        {
+          result.error = mError;
+        }
+        result.indentUnit = mIndentUnit;
+        result.end = Stopped() ? start + mPos : src.size();
+        return result;
+      }
+    };
+  } // namespace detail
+
+  // Parse a large document whose root is an indent-style object on several threads; anything else (or a document
+  // too small to split) is parsed by Parse. The input is cut speculatively at lines that start a top-level key near
+  // even shares of the input, and each span is parsed into its own object, its last value read past the cut as far
+  // as it goes. The spans are then merged in order, and a cut only counts where the span before it really ended: a
+  // span whose start turned out not to be a member boundary (the cut fell inside a multi-line value), that failed or
+  // that saw a different indent unit than the document's is parsed again on the calling thread from where the
+  // document really continues. Result and errors (with document line / column) are the same as Parse; duplicate keys
+  // keep the first value.
+  inline ErrorCode ParseParallel(std::string_view src, Value& out, const ParallelParseOptions& options = {}, Error* error = nullptr)
+  {
+    using detail::RootSpanParser;
+
+    std::size_t spanCount = options.threads != 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    spanCount = std::min(spanCount, src.size() / std::max<std::size_t>(options.minSpanBytes, 1));
+    constexpr std::size_t kUnlimited = std::numeric_limits<std::size_t>::max();
+    const bool documentBudgets = options.parse.maxElements != kUnlimited || options.parse.maxAllocatedBytes != kUnlimited;
+    std::size_t contentStart = 0;
+    if (spanCount < 2 || documentBudgets || RootSpanParser::ClassifyRoot(src, true, contentStart) != RootSpanParser::RootShape::Members)
+    {
+      return Parse(src, out, options.parse, error);
+    }
+
+    // Cut at the first line after each share that starts at column 1 with a key (but not a closing """)
+    std::vector<std::size_t> starts{0};
+    for (std::size_t share = 1; share < spanCount; ++share)
+    {
+      std::size_t from = std::max({src.size() * share / spanCount, contentStart + 1, starts.back() + 1}) - 1;
+      std::size_t start = std::string_view::npos;
+      for (std::size_t newline = src.find('\n', from); newline != std::string_view::npos && newline + 1 < src.size();
+           newline = src.find('\n', newline + 1))
+      {
+        std::string_view line = src.substr(newline + 1, 3);
+        if ((RootSpanParser::IsIdentifierStart(line[0]) || line[0] == '"' || line[0] == '\'') && line != "\"\"\"")
+        {
+          start = newline + 1;
+          break;
+        }
+      }
+      if (start == std::string_view::npos)
+      {
+        break;
+      }
+      starts.push_back(start);
+    }
+    const std::size_t count = starts.size();
+    starts.push_back(src.size());
+
+    std::vector<RootSpanParser::Result> results(count);
+    auto work = [&](std::size_t index) {
+      try
+      {
+        RootSpanParser parser(options.parse);
+        results[index] = parser.Parse(src, starts[index], starts[index + 1], 0);
+      }
+      catch (const std::exception& exception)
+      {
+        results[index].code = ErrorCode::InternalError;
+        results[index].error = Error{ErrorCode::InternalError, {}, exception.what()};
+      }
+    };
+    {
+      detail::JoiningThreads threads(count - 1);
+      std::size_t started = 1;
+      while (started < count && threads.Start(work, started))
+      {
+        ++started;
+      }
+      work(0);
+      for (std::size_t index = started; index < count; ++index)
+      {
+        work(index); // No thread for it
+      }
+    }
+
+    auto fail = [&](Error failure, std::size_t start) {
+      failure.where.line += static_cast<std::size_t>(std::count(src.begin(), src.begin() + static_cast<std::ptrdiff_t>(start), '\n'));
+      if (error)
+      {
+        *error = failure;
+      }
+      return failure.code;
+    };
+
+    // Parse validates UTF-8 before anything else, so the first bad byte wins over syntax errors
+    for (std::size_t index = 0; index < count; ++index)
+    {
+      if (results[index].code == ErrorCode::InvalidUtf8)
+      {
+        return fail(results[index].error, starts[index]);
+      }
+    }
+
+    Object root;
+    int indentUnit = 0;
+    RootSpanParser parser(options.parse);
+    std::size_t next = 0; // First cut at or after position
+    for (std::size_t position = 0; position < src.size();)
+    {
+      while (starts[next] < position)
+      {
+        ++next;
+      }
+      RootSpanParser::Result result;
+      const std::size_t limit = starts[next] == position ? starts[next + 1] : starts[next];
+      if (starts[next] == position)
+      {
+        result = std::move(results[next]);
+
+        // Parsed before the document's indent unit was known: an error or a unit of its own may come from that
+        if (indentUnit != 0 && (result.code != ErrorCode::OK || (result.indentUnit != 0 && result.indentUnit != indentUnit)))
+        {
+          result = parser.Parse(src, position, limit, indentUnit);
+        }
+      }
+      else
+      {
+        result = parser.Parse(src, position, limit, indentUnit);
+      }
+      if (result.code != ErrorCode::OK)
+      {
+        return fail(result.error, position);
+      }
+      indentUnit = indentUnit != 0 ? indentUnit : result.indentUnit;
+
+      Object& members = result.value.asObject();
+      if (position == 0)
+      {
+        // Assume the rest of the document holds about as many members per byte as the first span
+        root = std::move(members);
+        root.reserve(root.size() * src.size() / std::max<std::size_t>(result.end, 1));
+      }
+      else
+      {
+        members.drain([&root](std::string&& key, Value& value) { root.try_emplace(std::move(key), std::move(value)); });
+      }
+      position = result.end;
+    }
+
+    out = std::move(root);
+    if (error)
+    {
+      *error = {};
+    }
+    return ErrorCode::OK;
+  }
+
+  // Exception type and throwing wrappers
+  struct ParseException : std::exception
+  {
+    Error error;
+    explicit ParseException(Error e) : error(std::move(e))
+    {}
+    const char* what() const noexcept override
+    {
+      return error.message.c_str();
+    }
+  };
+
+  inline Value ParseOrThrow(std::string_view src)
+  {
+    Value value;
+    Error error;
+    ErrorCode errorCode = Parse(src, value, &error);
+    if (errorCode != ErrorCode::OK)
+    {
+      throw ParseException(error);
+    }
+    return value;
+  }
+
+  inline Value ParseFileOrThrow(const std::string& path)
+  {
+    Value value;
+    Error error;
+    ErrorCode errorCode = ParseFile(path, value, &error);
+    if (errorCode != ErrorCode::OK)
+    {
+      throw ParseException(error);
+    }
+    return value;
+  }
+
+  // Append key as the next member of a LazyDocument path: .key, or ["key"] (with \" and \\ escaped) for keys that
+  // are empty or contain '.' or '['
+  inline void AppendPathKey(std::string& path, std::string_view key)
+  {
+    if (!key.empty() && key.find_first_of(".[") == std::string_view::npos)
+    {
+      if (!path.empty())
+      {
+        path.push_back('.');
+      }
+      path.append(key);
+      return;
+    }
+    path.append("[\"");
+    for (char c : key)
+    {
+      if (c == '"' || c == '\\')
+      {
+        path.push_back('\\');
+      }
+      path.push_back(c);
+    }
+    path.append("\"]");
+  }
+
+  // One difference between two values. path names the value in LazyDocument syntax ("server.listeners[3].port", empty
+  // for the root; keys are appended with AppendPathKey, so any key can be named).
+  struct ValueChange
+  {
+    enum class Kind : std::uint8_t
+    {
+      Added, // Only in the new value
+      Removed, // Only in the old value
+      Changed // Different scalar, or a different kind of value
+    };
+
+    Kind kind = Kind::Changed;
+    std::string path;
+  };
+
+  namespace detail
+  {
+    inline void DiffValues(const Value& before, const Value& after, std::string& path, std::vector<ValueChange>& changes)
+    {
+      const std::size_t length = path.size();
+      auto report = [&](ValueChange::Kind kind) {
+        changes.push_back({kind, path});
+      };
+      auto enterKey = [&](std::string_view key) {
+        AppendPathKey(path, key);
+      };
+      auto enterIndex = [&](std::size_t index) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), index);
+        path.push_back('[');
+        path.append(digits, result.ptr);
+        path.push_back(']');
+      };
+
+      if (before.index() != after.index())
+      {
+        report(ValueChange::Kind::Changed);
+        return;
+      }
+      if (before.isObject())
+      {
+        const Object& oldMembers = before.asObject();
+        const Object& newMembers = after.asObject();
+        for (const auto& [key, member] : oldMembers)
+        {
+          enterKey(key);
+          auto it = newMembers.find(key);
+          if (it == newMembers.end())
+          {
+            report(ValueChange::Kind::Removed);
+          }
+          else
+          {
+            DiffValues(member, it->second, path, changes);
+          }
+          path.resize(length);
+        }
+        for (const auto& [key, member] : newMembers)
+        {
+          if (!oldMembers.contains(key))
+          {
+            enterKey(key);
+            report(ValueChange::Kind::Added);
+            path.resize(length);
+          }
+        }
+        return;
+      }
+      if (before.isArray())
+      {
+        const Array& oldElements = before.asArray();
+        const Array& newElements = after.asArray();
+        const std::size_t count = std::max(oldElements.size(), newElements.size());
+        for (std::size_t index = 0; index < count; ++index)
+        {
+          enterIndex(index);
+          if (index >= newElements.size())
+          {
+            report(ValueChange::Kind::Removed);
+          }
+          else if (index >= oldElements.size())
+          {
+            report(ValueChange::Kind::Added);
+          }
+          else
+          {
+            DiffValues(oldElements[index], newElements[index], path, changes);
+          }
+          path.resize(length);
+        }
+        return;
+      }
+
+      const bool same = before.isNull() || (before.isBool() && std::get<bool>(before) == std::get<bool>(after)) ||
+                        (before.isNumber() && std::get<double>(before) == std::get<double>(after)) ||
+                        (before.isString() && std::get<std::string>(before) == std::get<std::string>(after));
+      if (!same)
+      {
+        report(ValueChange::Kind::Changed);
+      }
+    }
+  } // namespace detail
+
+  // Structural difference from before to after: members of before in order (Changed / Removed, nested changes listed
+  // individually), then members only after has (Added). Arrays are compared by index, so inserting an element shows
+  // up as changes from there on plus an Added element at the end. Empty when the values are equal.
+  inline std::vector<ValueChange> Diff(const Value& before, const Value& after)
+  {
+    std::vector<ValueChange> changes;
+    std::string path;
+    detail::DiffValues(before, after, path, changes);
+    return changes;
+  }
+
+  namespace detail
+  {
+    // What polling compares: a changed file has a different size or modification time, a replaced one a new identity
+    struct FileStamp
+    {
+      bool exists = false;
+      std::uint64_t size = 0;
+      std::int64_t modified = 0; // Platform units
+      std::uint64_t identity = 0;
+
+      friend bool operator==(const FileStamp&, const FileStamp&) = default;
+    };
+
+    inline FileStamp StampFile(const std::string& path)
+    {
+      FileStamp stamp;
+#ifdef _WIN32
+      std::wstring pathW = ConvertStringToWString(path, true);
+      WIN32_FILE_ATTRIBUTE_DATA data{};
+      if (GetFileAttributesExW(pathW.c_str(), GetFileExInfoStandard, &data))
+      {
+        stamp.exists = true;
+        stamp.size = static_cast<std::uint64_t>(data.nFileSizeHigh) << 32 | data.nFileSizeLow;
+        stamp.modified = static_cast<std::int64_t>(static_cast<std::uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32 |
+                                                   data.ftLastWriteTime.dwLowDateTime);
+      }
+#else
+      struct stat info{};
+      if (stat(path.c_str(), &info) == 0)
+      {
+        stamp.exists = true;
+        stamp.size = static_cast<std::uint64_t>(info.st_size);
+  #if defined(__APPLE__)
+        stamp.modified = static_cast<std::int64_t>(info.st_mtimespec.tv_sec) * 1000000000 + info.st_mtimespec.tv_nsec;
+  #else
+        stamp.modified = static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+  #endif
+        stamp.identity = static_cast<std::uint64_t>(info.st_ino);
+      }
+#endif
+      return stamp;
+    }
+
+    // Directory and file name of path (the directory is "." for a bare file name)
+    inline std::pair<std::string, std::string> SplitWatchPath(const std::string& path)
+    {
+#ifdef _WIN32
+      const std::size_t slash = path.find_last_of("/\\");
+      const bool keepSlash = slash != std::string::npos && (slash == 0 || path[slash - 1] == ':');
+#else
+      const std::size_t slash = path.rfind('/');
+      const bool keepSlash = slash == 0;
+#endif
+      if (slash == std::string::npos)
+      {
+        return {".", path};
+      }
+      return {path.substr(0, keepSlash ? slash + 1 : slash), path.substr(slash + 1)};
+    }
+
+    // Native change notification for FileWatcher. Open watches the file (through its directory where the platform
+    // allows, so saving by renaming a new file over it is seen too); Wait returns true once an event concerned the
+    // file and false on timeout or after Wake(), which other threads may call. Wait must be called from one thread.
+    // Only inotify is built by default: the ReadDirectoryChangesW and kqueue backends haven't been through a build and
+    // test on their platforms yet and need -DHAVCSON_ENABLE_EXPERIMENTAL_WATCH; without it those platforms poll.
+#if defined(_WIN32) && defined(HAVCSON_ENABLE_EXPERIMENTAL_WATCH)
+    class FileChangeNotifier
+    {
+    public:
+      FileChangeNotifier() = default;
+
+      ~FileChangeNotifier()
+      {
+        Close();
+      }
+
+      FileChangeNotifier(const FileChangeNotifier&) = delete;
+      FileChangeNotifier& operator=(const FileChangeNotifier&) = delete;
+
+      bool Open(const std::string& path)
+      {
+        Close();
+        auto [directory, name] = SplitWatchPath(path);
+        mName = ConvertStringToWString(name);
+        std::wstring directoryW = ConvertStringToWString(directory, true);
+        mDirectory = CreateFileW(
+          directoryW.c_str(),
+          FILE_LIST_DIRECTORY,
+          FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+          nullptr,
+          OPEN_EXISTING,
+          FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+          nullptr);
+        mChanged = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        mWake = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        if (mDirectory == INVALID_HANDLE_VALUE || !mChanged || !mWake)
+        {
+          Close();
+          return false;
+        }
+        mBuffer.resize(16 * 1024);
+        return true;
+      }
+
+      bool Wait(std::chrono::milliseconds timeout)
+      {
+        // Requests are issued here so that they belong to the waiting thread, which cancels them when it exits
+        if (!mPending && !Request())
+        {
+          WaitForSingleObject(mWake, static_cast<DWORD>(timeout.count()));
+          return false;
+        }
+        HANDLE handles[2] = {mChanged, mWake};
+        if (WaitForMultipleObjects(2, handles, FALSE, static_cast<DWORD>(timeout.count())) != WAIT_OBJECT_0)
+        {
+          return false;
+        }
+
+        DWORD bytes = 0;
+        const bool completed = GetOverlappedResult(mDirectory, &mOverlapped, &bytes, FALSE) != FALSE;
+        mPending = false;
+        bool named = !completed || bytes == 0; // No entries: the buffer overflowed and changes were lost
+        for (std::size_t offset = 0; completed && bytes != 0;)
+        {
+          const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(reinterpret_cast<const char*>(mBuffer.data()) + offset);
+          std::wstring changed(info->FileName, info->FileNameLength / sizeof(WCHAR));
+          if (lstrcmpiW(changed.c_str(), mName.c_str()) == 0)
+          {
+            named = true;
+          }
+          if (info->NextEntryOffset == 0)
+          {
+            break;
+          }
+          offset += info->NextEntryOffset;
+        }
+        return named;
+      }
+
+      void Wake()
+      {
+        SetEvent(mWake);
+      }
+
+      // After the waiting thread exited
+      void Close()
+      {
+        if (mPending)
+        {
+          DWORD bytes = 0;
+          CancelIo(mDirectory);
+          GetOverlappedResult(mDirectory, &mOverlapped, &bytes, TRUE);
+          mPending = false;
+        }
+        for (HANDLE* handle : {&mChanged, &mWake})
+        {
+          if (*handle)
+          {
+            CloseHandle(*handle);
+            *handle = nullptr;
+          }
+        }
+        if (mDirectory != INVALID_HANDLE_VALUE)
+        {
+          CloseHandle(mDirectory);
+          mDirectory = INVALID_HANDLE_VALUE;
+        }
+      }
+
+    private:
+      HANDLE mDirectory = INVALID_HANDLE_VALUE;
+      HANDLE mChanged = nullptr;
+      HANDLE mWake = nullptr;
+      OVERLAPPED mOverlapped{};
+      bool mPending = false;
+      std::vector<DWORD> mBuffer; // FILE_NOTIFY_INFORMATION records are DWORD aligned
+      std::wstring mName;
+
+      bool Request()
+      {
+        mOverlapped = {};
+        mOverlapped.hEvent = mChanged;
+        mPending = ReadDirectoryChangesW(
+                     mDirectory,
+                     mBuffer.data(),
+                     static_cast<DWORD>(mBuffer.size() * sizeof(DWORD)),
+                     FALSE,
+                     FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE,
+                     nullptr,
+                     &mOverlapped,
+                     nullptr) != FALSE;
+        return mPending;
+      }
+    };
+#elif defined(__linux__)
+    class FileChangeNotifier
+    {
+    public:
+      FileChangeNotifier() = default;
+
+      ~FileChangeNotifier()
+      {
+        Close();
+      }
+
+      FileChangeNotifier(const FileChangeNotifier&) = delete;
+      FileChangeNotifier& operator=(const FileChangeNotifier&) = delete;
+
+      bool Open(const std::string& path)
+      {
+        Close();
+        auto [directory, name] = SplitWatchPath(path);
+        mName = std::move(name);
+        mNotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        mWake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        const std::uint32_t events = IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+        if (mNotify < 0 || mWake < 0 || inotify_add_watch(mNotify, directory.c_str(), events) < 0)
+        {
+          Close();
+          return false;
+        }
+        return true;
+      }
+
+      bool Wait(std::chrono::milliseconds timeout)
+      {
+        pollfd descriptors[2] = {{mNotify, POLLIN, 0}, {mWake, POLLIN, 0}};
+        if (poll(descriptors, 2, static_cast<int>(timeout.count())) <= 0 || (descriptors[1].revents & POLLIN) != 0)
+        {
+          return false;
+        }
+
+        bool named = false;
+        alignas(inotify_event) char buffer[4096];
+        for (ssize_t length = 0; (length = read(mNotify, buffer, sizeof(buffer))) > 0;)
+        {
+          for (const char* position = buffer; position < buffer + length;)
+          {
+            const auto* event = reinterpret_cast<const inotify_event*>(position);
+            if ((event->mask & IN_Q_OVERFLOW) != 0 || (event->len != 0 && mName == event->name))
+            {
+              named = true;
+            }
+            position += sizeof(inotify_event) + event->len;
+          }
+        }
+        return named;
+      }
+
+      void Wake()
+      {
+        const std::uint64_t one = 1;
+        [[maybe_unused]] ssize_t written = write(mWake, &one, sizeof(one));
+      }
+
+      void Close()
+      {
+        for (int* descriptor : {&mNotify, &mWake})
+        {
+          if (*descriptor >= 0)
+          {
+            close(*descriptor);
+            *descriptor = -1;
+          }
+        }
+      }
+
+    private:
+      int mNotify = -1;
+      int mWake = -1;
+      std::string mName;
+    };
+#elif defined(HAVCSON_DETAIL_KQUEUE)
+    class FileChangeNotifier
+    {
+    public:
+      FileChangeNotifier() = default;
+
+      ~FileChangeNotifier()
+      {
+        Close();
+      }
+
+      FileChangeNotifier(const FileChangeNotifier&) = delete;
+      FileChangeNotifier& operator=(const FileChangeNotifier&) = delete;
+
+      bool Open(const std::string& path)
+      {
+        Close();
+        mPath = path;
+        mQueue = kqueue();
+        if (mQueue < 0 || pipe(mWake) != 0)
+        {
+          Close();
+          return false;
+        }
+        struct kevent change;
+        EV_SET(&change, mWake[0], EVFILT_READ, EV_ADD, 0, 0, 0);
+        if (kevent(mQueue, &change, 1, nullptr, 0, nullptr) < 0)
+        {
+          Close();
+          return false;
+        }
+        WatchFile(); // A missing file is picked up by a later Wait
+        return true;
+      }
+
+      bool Wait(std::chrono::milliseconds timeout)
+      {
+        // kqueue watches the file itself: after it was deleted / renamed over, watch whatever is at the path now
+        if (mFile < 0 && WatchFile())
+        {
+          return true;
+        }
+        const timespec wait{static_cast<time_t>(timeout.count() / 1000), static_cast<long>(timeout.count() % 1000) * 1000000};
+        struct kevent events[4];
+        const int count = kevent(mQueue, nullptr, 0, events, 4, &wait);
+        bool changed = false;
+        for (int index = 0; index < count; ++index)
+        {
+          if (events[index].filter == EVFILT_READ)
+          {
+            return false; // Wake()
+          }
+          changed = true;
+          if ((events[index].fflags & (NOTE_DELETE | NOTE_RENAME)) != 0 && mFile >= 0)
+          {
+            close(mFile); // Also removes its event
+            mFile = -1;
+          }
+        }
+        return changed;
+      }
+
+      void Wake()
+      {
+        const char byte = 0;
+        [[maybe_unused]] ssize_t written = write(mWake[1], &byte, 1);
+      }
+
+      void Close()
+      {
+        for (int* descriptor : {&mFile, &mQueue, &mWake[0], &mWake[1]})
+        {
+          if (*descriptor >= 0)
+          {
+            close(*descriptor);
+            *descriptor = -1;
+          }
+        }
+      }
+
+    private:
+      int mQueue = -1;
+      int mFile = -1;
+      int mWake[2] = {-1, -1};
+      std::string mPath;
+
+      bool WatchFile()
+      {
+  #ifdef O_EVTONLY
+        mFile = open(mPath.c_str(), O_EVTONLY | O_CLOEXEC);
+  #else
+        mFile = open(mPath.c_str(), O_RDONLY | O_CLOEXEC);
+  #endif
+        if (mFile < 0)
+        {
+          return false;
+        }
+        struct kevent change;
+        EV_SET(&change, mFile, EVFILT_VNODE, EV_ADD | EV_CLEAR, NOTE_WRITE | NOTE_EXTEND | NOTE_ATTRIB | NOTE_DELETE | NOTE_RENAME, 0, 0);
+        if (kevent(mQueue, &change, 1, nullptr, 0, nullptr) < 0)
+        {
+          close(mFile);
+          mFile = -1;
+          return false;
+        }
+        return true;
+      }
+    };
+#else
+    // No native notification here: FileWatcher polls
+    class FileChangeNotifier
+    {
+    public:
+      bool Open(const std::string&)
+      {
+        return false;
+      }
+
+      bool Wait(std::chrono::milliseconds)
+      {
+        return false;
+      }
+
+      void Wake()
+      {}
+
+      void Close()
+      {}
+    };
+#endif
+  } // namespace detail
+
+  struct WatchOptions
+  {
+    ParseOptions parse; // How the file is parsed
+    // Quiet time after a change before the file is re-parsed, so a save that takes several writes is read once
+    std::chrono::milliseconds debounce{50};
+    // How often the file's size / modification time are checked: the only change detection when polling, otherwise a
+    // backstop for notifications that can't be seen (e.g. the watched directory itself was replaced)
+    std::chrono::milliseconds pollInterval{1000};
+    bool forcePolling = false; // Don't use native notifications (e.g. on network filesystems)
+  };
+
+  // Keeps the parsed contents of a file current for hot reloading. Start() parses the file, then a background thread
+  // waits for it to change (inotify on its directory on Linux, stat polling elsewhere unless
+  // HAVCSON_ENABLE_EXPERIMENTAL_WATCH is defined, see FileChangeNotifier), parses it again and publishes the result as
+  // a new immutable snapshot. Current() is an atomic shared_ptr load, so readers never wait for a re-parse, and a
+  // snapshot stays valid for as long as it is held. A version that fails to parse (e.g. half-written) leaves the
+  // previous snapshot in place; see LastError().
+  class FileWatcher
+  {
+  public:
+    using Snapshot = std::shared_ptr<const Value>;
+    // Called after a new snapshot was published, with what changed since the previous one, on the thread that parsed
+    // it (the watcher thread, or the caller of Reload). It must not call Reload or Start, nor destroy the watcher; Stop
+    // only asks the watcher thread to finish (see Stop)
+    using ChangeCallback = std::function<void(const Snapshot& snapshot, const std::vector<ValueChange>& changes)>;
+
+    explicit FileWatcher(std::string path, WatchOptions options = {}) : mPath(std::move(path)), mOptions(std::move(options))
+    {}
+
+    ~FileWatcher()
+    {
+      Stop();
+    }
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Set before Start
+    void OnChange(ChangeCallback callback)
+    {
+      mCallback = std::move(callback);
+    }
+
+    // Parse the file and start watching it; when that first parse fails, nothing is started
+    ErrorCode Start(Error* error = nullptr)
+    {
+      if (!Stop())
+      {
+        if (error)
+        {
+          error->code = ErrorCode::InternalError;
+          error->where = {};
+          error->message = "FileWatcher::Start called from its own change callback";
+        }
+        return ErrorCode::InternalError;
+      }
+      ErrorCode errorCode = Reload(error);
+      if (errorCode != ErrorCode::OK)
+      {
+        return errorCode;
+      }
+      mStopping = false;
+      mNotified = !mOptions.forcePolling && mNotifier.Open(mPath);
+      mThread = std::thread([this] { Run(); });
+      return ErrorCode::OK;
+    }
+
+    // Stop watching and join the watcher thread. Called from the change callback (on that thread), it can't join
+    // itself: the thread is only told to finish after the callback returns, and false says it still needs a Stop from
+    // another thread (the destructor does that too).
+    bool Stop()
+    {
+      if (!mThread.joinable())
+      {
+        return true;
+      }
+      {
+        std::lock_guard<std::mutex> lock(mWaitMutex);
+        mStopping = true;
+      }
+      mWakeCondition.notify_all();
+      mNotifier.Wake();
+      if (mThread.get_id() == std::this_thread::get_id())
+      {
+        return false;
+      }
+      mThread.join();
+      mNotifier.Close();
+      return true;
+    }
+
+    // Latest successfully parsed contents (null before Start)
+    Snapshot Current() const
+    {
+#if defined(__cpp_lib_atomic_shared_ptr)
+      return mSnapshot.load(std::memory_order_acquire);
+#else
+      std::lock_guard<std::mutex> lock(mSnapshotMutex);
+      return mSnapshot;
+#endif
+    }
+
+    // Whether changes are noticed through notifications rather than polling
+    bool IsNotified() const
+    {
+      return mNotified;
+    }
+
+    // Parse the file now (e.g. on SIGHUP) and publish it if anything changed
+    ErrorCode Reload(Error* error = nullptr)
+    {
+      std::lock_guard<std::mutex> reloadLock(mReloadMutex);
+      std::string buffer;
+      Error failure;
+      auto parsed = std::make_shared<Value>();
+      ErrorCode errorCode = detail::ReadFileUTF8(mPath, buffer, &failure);
+      if (errorCode == ErrorCode::OK)
+      {
+        errorCode = Parse(buffer, *parsed, mOptions.parse, &failure);
+      }
+      {
+        std::lock_guard<std::mutex> lock(mErrorMutex);
+        mLastError = failure;
+      }
+      if (error)
+      {
+        *error = failure;
+      }
+      if (errorCode != ErrorCode::OK)
+      {
+        return errorCode;
+      }
+
+      Snapshot previous = Current();
+      std::vector<ValueChange> changes;
+      if (previous)
+      {
+        changes = Diff(*previous, *parsed);
+        if (changes.empty())
+        {
+          return ErrorCode::OK;
+        }
+      }
+      Snapshot snapshot = std::move(parsed);
+#if defined(__cpp_lib_atomic_shared_ptr)
+      mSnapshot.store(snapshot, std::memory_order_release);
+#else
+      {
+        std::lock_guard<std::mutex> lock(mSnapshotMutex);
+        mSnapshot = snapshot;
+      }
+#endif
+      if (previous && mCallback)
+      {
+        mCallback(snapshot, changes);
+      }
+      return ErrorCode::OK;
+    }
+
+    // Why the last parse failed (code OK if it succeeded)
+    Error LastError() const
+    {
+      std::lock_guard<std::mutex> lock(mErrorMutex);
+      return mLastError;
+    }
+
+  private:
+    std::string mPath;
+    WatchOptions mOptions;
+    ChangeCallback mCallback;
+    detail::FileChangeNotifier mNotifier;
+    bool mNotified = false;
+    std::thread mThread;
+    std::mutex mWaitMutex;
+    std::condition_variable mWakeCondition;
+    bool mStopping = false;
+    std::mutex mReloadMutex;
+    mutable std::mutex mErrorMutex;
+    Error mLastError;
+#if defined(__cpp_lib_atomic_shared_ptr)
+    std::atomic<Snapshot> mSnapshot;
+#else
+    mutable std::mutex mSnapshotMutex;
+    Snapshot mSnapshot;
+#endif
+
+    // Sleep for duration, or until Stop()
+    void Pause(std::chrono::milliseconds duration)
+    {
+      std::unique_lock<std::mutex> lock(mWaitMutex);
+      mWakeCondition.wait_for(lock, duration, [this] { return mStopping; });
+    }
+
+    bool Stopping()
+    {
+      std::lock_guard<std::mutex> lock(mWaitMutex);
+      return mStopping;
+    }
+
+    void Run()
+    {
+      detail::FileStamp stamp = detail::StampFile(mPath);
+      while (true)
+      {
+        bool changed = false;
+        if (mNotified)
+        {
+          changed = mNotifier.Wait(mOptions.pollInterval);
+        }
+        else
+        {
+          Pause(mOptions.pollInterval);
+        }
+        if (Stopping())
+        {
+          return;
+        }
+        if (!changed && detail::StampFile(mPath) == stamp)
+        {
+          continue;
+        }
+
+        // Let the writer finish: re-parse once the file was quiet for the debounce time
+        if (mNotified)
+        {
+          while (mNotifier.Wait(mOptions.debounce))
+          {}
+        }
+        else
+        {
+          Pause(mOptions.debounce);
+        }
+        if (Stopping())
+        {
+          return;
+        }
+        stamp = detail::StampFile(mPath);
+        Reload();
+      }
+    }
+  };
+
+  namespace detail
+  {
+    // One value of a LazyDocument, in document order. Containers are followed by their subtree; end skips over it.
+    struct LazyNode
+    {
+      enum class Kind : std::uint8_t
+      {
+        Null,
+        False,
+        True,
+        Literal, // String / number / bare word, decoded on access from offset
+        Array,
+        Object,
+      };
+
+      Kind kind = Kind::Null;
+      std::size_t end = 0; // Containers: index one past the subtree
+      std::string_view key; // Member key when the parent is an object
+      std::size_t offset = 0; // Literals: first character in the source
+      LocationEntry where{}; // Literals: location of offset
+    };
+
+    // Records the structure of a document as LazyNodes; literals are only located, not decoded
+    class LazyIndexBuilder : public EventHandler
+    {
+    public:
+      LazyIndexBuilder(std::vector<LazyNode>& nodes, std::deque<std::string>& ownedKeys, std::string_view source)
+        : mNodes(nodes), mOwnedKeys(ownedKeys), mSource(source)
+      {}
+
+      bool OnNull()
+      {
+        return Push(LazyNode::Kind::Null);
+      }
+
+      bool OnBool(bool value)
+      {
+        return Push(value ? LazyNode::Kind::True : LazyNode::Kind::False);
+      }
+
+      bool OnString(std::string_view value)
+      {
+        // Only bare words arrive here (quoted strings go through OnScalar); they view the source
+        return Push(LazyNode::Kind::Literal, static_cast<std::size_t>(value.data() - mSource.data()));
+      }
+
+      bool OnScalar(std::size_t offset, LocationEntry where)
+      {
+        return Push(LazyNode::Kind::Literal, offset, where);
+      }
+
+      bool OnArrayStart()
+      {
+        Push(LazyNode::Kind::Array);
+        mOpen.push_back(mNodes.size() - 1);
+        return true;
+      }
+
+      bool OnObjectStart()
+      {
+        Push(LazyNode::Kind::Object);
+        mOpen.push_back(mNodes.size() - 1);
+        return true;
+      }
+
+      bool OnKey(std::string_view key)
+      {
+        // Keys with escapes were decoded into parser scratch and need their own storage
+        std::less_equal<const char*> lessEqual;
+        if (lessEqual(mSource.data(), key.data()) && lessEqual(key.data() + key.size(), mSource.data() + mSource.size()))
+        {
+          mKey = key;
+        }
+        else
+        {
+          mKey = mOwnedKeys.emplace_back(key);
+        }
+        return true;
+      }
+
+      bool OnArrayEnd()
+      {
+        return Close();
+      }
+
+      bool OnObjectEnd()
+      {
+        return Close();
+      }
+
+    private:
+      std::vector<LazyNode>& mNodes;
+      std::deque<std::string>& mOwnedKeys;
+      std::string_view mSource;
+      std::vector<std::size_t> mOpen; // Open containers
+      std::string_view mKey;
+
+      bool Push(LazyNode::Kind kind, std::size_t offset = 0, LocationEntry where = {})
+      {
+        LazyNode& node = mNodes.emplace_back();
+        node.kind = kind;
+        node.end = mNodes.size();
+        node.offset = offset;
+        node.where = where;
+        if (!mOpen.empty() && mNodes[mOpen.back()].kind == LazyNode::Kind::Object)
+        {
+          node.key = mKey;
+        }
+        return true;
+      }
+
+      bool Close()
+      {
+        mNodes[mOpen.back()].end = mNodes.size();
+        mOpen.pop_back();
+        return true;
+      }
+    };
+
+    // Decodes the literals of a LazyDocument
+    class LazyLiteralReader : private Parser
+    {
+    public:
+      explicit LazyLiteralReader(std::string_view src) : Parser(src)
+      {}
+
+      ErrorCode Decode(const LazyNode& node, Value& out, Error* error)
+      {
+        SetPosition(node.offset, node.where.line, node.where.column);
+        const char c = Peek();
+        ErrorCode errorCode = ErrorCode::OK;
+        if (c == '"' || c == '\'')
+        {
+          std::string_view text;
+          errorCode = c == '"' ? ScanStringOrTriple(text) : ScanQuoted('\'', text);
+          if (errorCode == ErrorCode::OK)
+          {
+            out = std::string(text);
+          }
+        }
+        else if (IsNumberStart(c))
+        {
+          double number = 0.0;
+          errorCode = ScanNumber(number);
+          if (errorCode == ErrorCode::OK)
+          {
+            out = number;
+          }
+        }
+        else
+        {
+          out = std::string(ScanIdentifier());
+        }
+        if (errorCode != ErrorCode::OK && error)
+        {
+          *error = mError;
+        }
+        return errorCode;
+      }
+    };
+  } // namespace detail
+
+  // On-demand document for reading a few values out of a large file. Parse makes one structural pass that checks the
+  // whole document (same errors as Parse) and records an index of its values with skip offsets, without decoding
+  // strings or numbers. Get / at then decode only the value a path names, like "server.listeners[3].port" (object
+  // keys separated by '.', array elements as [index]; the empty path is the root). Keys that are empty or contain '.'
+  // or '[' are written as ["key"], with \" and \\ escaped inside (see AppendPathKey), e.g. hosts["example.com"].port.
+  // Duplicate keys resolve to the first member. The source must outlive the document.
+  class LazyDocument
+  {
+  public:
+    LazyDocument() = default;
+    LazyDocument(LazyDocument&&) = default;
+    LazyDocument& operator=(LazyDocument&&) = default;
+    LazyDocument(const LazyDocument&) = delete;
+    LazyDocument& operator=(const LazyDocument&) = delete;
+
+    // Replace the document with the index of src (null root on failure)
+    ErrorCode Parse(std::string_view src, Error* error = nullptr)
+    {
+      return Parse(src, ParseOptions{}, error);
+    }
+
+    // Same with ParseOptions: the limits, iterative and trustedInput apply to the structural pass
+    ErrorCode Parse(std::string_view src, const ParseOptions& options, Error* error = nullptr)
+    {
+      mNodes.clear();
+      mOwnedKeys.clear();
+      mSource = src;
+      detail::LazyIndexBuilder builder(mNodes, mOwnedKeys, src);
+      ErrorCode errorCode = ErrorCode::OK;
+      if (options.trustedInput)
+      {
+        BasicParser<false> p(src, {}, options);
+        errorCode = p.ParseEvents(builder, error);
+      }
+      else
+      {
+        Parser p(src, {}, options);
+        errorCode = p.ParseEvents(builder, error);
+      }
+      if (errorCode != ErrorCode::OK)
+      {
+        mNodes.clear();
+        mOwnedKeys.clear();
+        mNodes.emplace_back().end = 1;
+      }
+      return errorCode;
+    }
+
+    bool contains(std::string_view path) const
+    {
+      return Find(path, nullptr) != kNoNode;
+    }
+
+    // Decode the value at path into out (unchanged on failure)
+    ErrorCode Get(std::string_view path, Value& out, Error* error = nullptr) const
+    {
+      std::size_t index = Find(path, error);
+      if (index == kNoNode)
+      {
+        return ErrorCode::PathNotFound;
+      }
+      Value value;
+      detail::LazyLiteralReader reader(mSource);
+      ErrorCode errorCode = Materialize(reader, index, value, error);
+      if (errorCode != ErrorCode::OK)
+      {
+        return errorCode;
+      }
+      out = std::move(value);
+      if (error)
+      {
+        *error = {};
+      }
+      return ErrorCode::OK;
+    }
+
+    Value at(std::string_view path) const
+    {
+      Value value;
+      Error error;
+      if (Get(path, value, &error) != ErrorCode::OK)
+      {
+        throw ParseException(error);
+      }
+      return value;
+    }
+
+    std::string_view Source() const
+    {
+      return mSource;
+    }
+
+  private:
+    static constexpr std::size_t kNoNode = static_cast<std::size_t>(-1);
+
+    std::string_view mSource;
+    std::vector<detail::LazyNode> mNodes{detail::LazyNode{detail::LazyNode::Kind::Null, 1, {}, 0, {}}};
+    std::deque<std::string> mOwnedKeys; // Decoded keys; deque keeps their addresses stable
+
+    static std::size_t NotFound(std::string_view path, std::string_view message, Error* error)
+    {
+      if (error)
+      {
+        error->code = ErrorCode::PathNotFound;
+        error->where = {};
+        error->message.assign(message);
+        error->message.append(": ");
+        error->message.append(path);
+      }
+      return kNoNode;
+    }
+
+    // Walk path through the index: children are visited by jumping over their subtrees
+    std::size_t Find(std::string_view path, Error* error) const
+    {
+      std::size_t index = 0;
+      std::size_t position = 0;
+      std::string quotedKey;
+      while (position < path.size())
+      {
+        const detail::LazyNode& node = mNodes[index];
+        std::string_view key;
+        if (path[position] == '[' && position + 1 < path.size() && path[position + 1] == '"')
+        {
+          quotedKey.clear();
+          std::size_t cursor = position + 2;
+          for (; cursor < path.size() && path[cursor] != '"'; ++cursor)
+          {
+            if (path[cursor] == '\\' && cursor + 1 < path.size())
+            {
+              ++cursor;
+            }
+            quotedKey.push_back(path[cursor]);
+          }
+          if (cursor + 1 >= path.size() || path[cursor + 1] != ']')
+          {
+            return NotFound(path, "Unterminated quoted key in path", error);
+          }
+          key = quotedKey;
+          position = cursor + 2;
+        }
+        else if (path[position] == '[')
+        {
+          std::size_t close = path.find(']', position);
+          std::size_t element = 0;
+          const char* first = path.data() + position + 1;
+          const char* last = path.data() + (close == std::string_view::npos ? path.size() : close);
+          auto [ptr, errorCode] = std::from_chars(first, last, element);
+          if (close == std::string_view::npos || first == last || ptr != last || errorCode != std::errc())
+          {
+            return NotFound(path, "Invalid array index in path", error);
+          }
+          if (node.kind != detail::LazyNode::Kind::Array)
+          {
+            return NotFound(path, "Path indexes a value that is not an array", error);
+          }
+          std::size_t child = index + 1;
+          for (; child < node.end && element > 0; --element)
+          {
+            child = mNodes[child].end;
+          }
+          if (child == node.end)
+          {
+            return NotFound(path, "Array index out of range in path", error);
+          }
+          index = child;
+          position = close + 1;
+          continue;
+        }
+        else
+        {
+          if (position > 0)
+          {
+            if (path[position] != '.')
+            {
+              return NotFound(path, "Expected '.' or '[' in path", error);
+            }
+            ++position;
+          }
+          std::size_t stop = std::min(path.find_first_of(".[", position), path.size());
+          key = path.substr(position, stop - position);
+          if (key.empty())
+          {
+            return NotFound(path, "Empty key in path (write it as [\"\"])", error);
+          }
+          position = stop;
+        }
+
+        if (node.kind != detail::LazyNode::Kind::Object)
+        {
+          return NotFound(path, "Path names a member of a value that is not an object", error);
+        }
+        std::size_t child = index + 1;
+        while (child < node.end && mNodes[child].key != key)
+        {
+          child = mNodes[child].end;
+        }
+        if (child == node.end)
+        {
+          return NotFound(path, "No value at path", error);
+        }
+        index = child;
+      }
+      return index;
+    }
+
+    ErrorCode Materialize(detail::LazyLiteralReader& reader, std::size_t index, Value& out, Error* error) const
+    {
+      using Kind = detail::LazyNode::Kind;
+      const detail::LazyNode& node = mNodes[index];
+      switch (node.kind)
+      {
+        case Kind::Null: out = nullptr; return ErrorCode::OK;
+        case Kind::False: out = false; return ErrorCode::OK;
+        case Kind::True: out = true; return ErrorCode::OK;
+        case Kind::Literal: return reader.Decode(node, out, error);
+        case Kind::Array:
+        {
+          Array array;
+          for (std::size_t child = index + 1; child < node.end; child = mNodes[child].end)
+          {
+            ErrorCode errorCode = Materialize(reader, child, array.emplace_back(), error);
+            if (errorCode != ErrorCode::OK)
+            {
+              return errorCode;
+            }
+          }
+          out = std::move(array);
+          return ErrorCode::OK;
+        }
+        case Kind::Object:
+        {
+          Object object;
+          for (std::size_t child = index + 1; child < node.end; child = mNodes[child].end)
+          {
+            auto [it, inserted] = object.try_emplace(std::string(mNodes[child].key));
+            if (!inserted)
+            {
+              continue;
+            }
+            ErrorCode errorCode = Materialize(reader, child, it->second, error);
+            if (errorCode != ErrorCode::OK)
+            {
+              return errorCode;
+            }
+          }
+          out = std::move(object);
+          return ErrorCode::OK;
+        }
+      }
+      return ErrorCode::InternalError;
+    }
+  };
+
+  namespace detail
+  {
+    // Tape entries are a tag in the top byte and a 56 bit payload: the index into TapeBuffers::numbers, the offset of a
+    // length-prefixed string in TapeBuffers::strings, or for containers the tape index one past their last entry (low
+    // 32 bits) and their element / member count (upper 24 bits, saturated). An object entry is followed by one word
+    // locating its key index in TapeBuffers::index (0 for small objects, which are scanned), then its key / value pairs.
+    enum class TapeTag : std::uint8_t
+    {
+      Null,
+      False,
+      True,
+      Number,
+      String, // Also object keys
+      Array,
+      Object,
+    };
+
+    constexpr std::uint64_t kTapePayloadMask = (std::uint64_t{1} << 56) - 1;
+    constexpr std::uint64_t kTapeCountLimit = (std::uint64_t{1} << 24) - 1;
+    constexpr std::size_t kTapeLinearLimit = 8; // Objects with more members get a key index, like OrderedMap
+
+    struct TapeBuffers
+    {
+      std::vector<std::uint64_t> tape{std::uint64_t{0}}; // Null root
+      std::vector<double> numbers;
+      std::string strings; // uint32 length, bytes
+      std::vector<std::uint32_t> index; // Power-of-two slot tables holding key tape index + 1 (0 = empty)
+
+      void Clear()
+      {
+        tape.clear();
+        numbers.clear();
+        strings.clear();
+        index.clear();
+      }
+
+      std::string_view String(std::size_t entry) const
+      {
+        const char* data = strings.data() + (tape[entry] & kTapePayloadMask);
+        std::uint32_t length = 0;
+        std::memcpy(&length, data, sizeof(length));
+        return std::string_view(data + sizeof(length), length);
+      }
+
+      // Tape index one past the value at entry
+      std::size_t End(std::size_t entry) const
+      {
+        const auto tag = static_cast<TapeTag>(tape[entry] >> 56);
+        return tag == TapeTag::Array || tag == TapeTag::Object ? static_cast<std::size_t>(tape[entry] & 0xFFFFFFFF) : entry + 1;
+      }
+    };
+
+    // Appends parser events to a tape; containers are patched with their end / count (and objects get their key index)
+    // when they close
+    class TapeBuilder : public EventHandler
+    {
+    public:
+      explicit TapeBuilder(TapeBuffers& buffers) : mBuffers(buffers)
+      {}
+
+      bool OnNull()
+      {
+        return Push(TapeTag::Null, 0);
+      }
+
+      bool OnBool(bool value)
+      {
+        return Push(value ? TapeTag::True : TapeTag::False, 0);
+      }
+
+      bool OnNumber(double value)
+      {
+        mBuffers.numbers.push_back(value);
+        return Push(TapeTag::Number, mBuffers.numbers.size() - 1);
+      }
+
+      bool OnString(std::string_view value)
+      {
+        return Fits(value) && Push(TapeTag::String, AppendString(value));
+      }
+
+      bool OnArrayStart()
+      {
+        return Open(TapeTag::Array);
+      }
+
+      bool OnArrayEnd()
+      {
+        return Close();
+      }
+
+      bool OnObjectStart()
+      {
+        Open(TapeTag::Object);
+        mBuffers.tape.push_back(0);
+        return true;
+      }
+
+      bool OnKey(std::string_view key)
+      {
+        if (!Fits(key))
+        {
+          return false;
+        }
+        ++mOpen.back().count;
+        mBuffers.tape.push_back(static_cast<std::uint64_t>(TapeTag::String) << 56 | AppendString(key));
+        return true;
+      }
+
+      bool OnObjectEnd()
+      {
+        const OpenContainer object = mOpen.back();
+        if (!Close())
+        {
+          return false;
+        }
+        if (object.count > kTapeLinearLimit)
+        {
+          Index(object);
+        }
+        return true;
+      }
+
+      // Why the builder stopped the parse (OK if it didn't)
+      ErrorCode Overflow() const
+      {
+        return mOverflow;
+      }
+
+    private:
+      struct OpenContainer
+      {
+        std::size_t start;
+        std::uint64_t count;
+        bool isArray;
+      };
+
+      TapeBuffers& mBuffers;
+      std::vector<OpenContainer> mOpen;
+      ErrorCode mOverflow = ErrorCode::OK;
+
+      // Strings are stored with a uint32 length
+      bool Fits(std::string_view value)
+      {
+        if (value.size() > std::numeric_limits<std::uint32_t>::max())
+        {
+          mOverflow = ErrorCode::StringTooLong;
+          return false;
+        }
+        return true;
+      }
+
+      std::uint64_t AppendString(std::string_view value)
+      {
+        const std::size_t offset = mBuffers.strings.size();
+        const auto length = static_cast<std::uint32_t>(value.size());
+        mBuffers.strings.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        mBuffers.strings.append(value);
+        return offset;
+      }
+
+      // Start a value: counts as an element of an enclosing array (object members are counted by their key)
+      bool Push(TapeTag tag, std::uint64_t payload)
+      {
+        if (!mOpen.empty() && mOpen.back().isArray)
+        {
+          ++mOpen.back().count;
+        }
+        mBuffers.tape.push_back(static_cast<std::uint64_t>(tag) << 56 | payload);
+        return true;
+      }
+
+      bool Open(TapeTag tag)
+      {
+        Push(tag, 0);
+        mOpen.push_back({mBuffers.tape.size() - 1, 0, tag == TapeTag::Array});
+        return true;
+      }
+
+      bool Close()
+      {
+        const OpenContainer container = mOpen.back();
+        mOpen.pop_back();
+        if (mBuffers.tape.size() > std::numeric_limits<std::uint32_t>::max())
+        {
+          mOverflow = ErrorCode::TooManyElements; // End index doesn't fit the entry's low 32 bits
+          return false;
+        }
+        std::uint64_t& entry = mBuffers.tape[container.start];
+        entry |= static_cast<std::uint64_t>(mBuffers.tape.size()) | std::min(container.count, kTapeCountLimit) << 32;
+        return true;
+      }
+
+      // Hash the keys of a closed object into a table at a load factor of at most 1/2; a duplicate key keeps the slot
+      // of its first member. The word after the object entry becomes table offset << 8 | log2(slots).
+      void Index(const OpenContainer& object)
+      {
+        unsigned shift = 4;
+        while ((std::size_t{1} << shift) < object.count * 2)
+        {
+          ++shift;
+        }
+        const std::size_t offset = mBuffers.index.size();
+        const std::size_t mask = (std::size_t{1} << shift) - 1;
+        mBuffers.index.resize(offset + mask + 1, 0);
+        for (std::size_t key = object.start + 2, end = mBuffers.End(object.start); key < end; key = mBuffers.End(key + 1))
+        {
+          const std::string_view name = mBuffers.String(key);
+          for (std::size_t slot = std::hash<std::string_view>{}(name) & mask;; slot = (slot + 1) & mask)
+          {
+            std::uint32_t& entry = mBuffers.index[offset + slot];
+            if (entry == 0)
+            {
+              entry = static_cast<std::uint32_t>(key + 1);
+              break;
+            }
+            if (mBuffers.String(entry - 1) == name)
+            {
+              break;
+            }
+          }
+        }
+        mBuffers.tape[object.start + 1] = static_cast<std::uint64_t>(offset) << 8 | shift;
+      }
+    };
+  } // namespace detail
+
+  // One value of a TapeDocument; valid while the document is alive and not re-parsed or moved. Containers know where
+  // they end, so stepping to the next element / member is O(1). find uses the key index of objects with more than 8
+  // members and scans smaller ones; operator[] steps over the preceding elements.
+  class TapeNode
+  {
+  public:
+    // Walks the elements of an array / member values of an object; key() is the current member's key
+    class Iterator
+    {
+    public:
+      TapeNode operator*() const
+      {
+        return TapeNode(mBuffers, mKeyed ? mIndex + 1 : mIndex);
+      }
+
+      Iterator& operator++()
+      {
+        mIndex = mBuffers->End(mKeyed ? mIndex + 1 : mIndex);
+        return *this;
+      }
+
+      bool operator==(const Iterator& other) const
+      {
+        return mIndex == other.mIndex;
+      }
+
+      std::string_view key() const
+      {
+        return mBuffers->String(mIndex);
+      }
+
+    private:
+      friend class TapeNode;
+
+      const detail::TapeBuffers* mBuffers;
+      std::size_t mIndex; // Key entry for object members
+      bool mKeyed;
+
+      Iterator(const detail::TapeBuffers* buffers, std::size_t index, bool keyed) : mBuffers(buffers), mIndex(index), mKeyed(keyed)
+      {}
+    };
+
+    bool isNull() const
+    {
+      return Tag() == detail::TapeTag::Null;
+    }
+
+    bool isBool() const
+    {
+      return Tag() == detail::TapeTag::False || Tag() == detail::TapeTag::True;
+    }
+
+    bool isNumber() const
+    {
+      return Tag() == detail::TapeTag::Number;
+    }
+
+    bool isString() const
+    {
+      return Tag() == detail::TapeTag::String;
+    }
+
+    bool isArray() const
+    {
+      return Tag() == detail::TapeTag::Array;
+    }
+
+    bool isObject() const
+    {
+      return Tag() == detail::TapeTag::Object;
+    }
+
+    bool asBool() const
+    {
+      return Tag() == detail::TapeTag::True;
+    }
+
+    double asNumber() const
+    {
+      return mBuffers->numbers[Payload()];
+    }
+
+    // Views the document's string buffer
+    std::string_view asString() const
+    {
+      return mBuffers->String(mIndex);
+    }
+
+    // Elements / members of a container
+    std::size_t size() const
+    {
+      const std::uint64_t count = Payload() >> 32;
+      if (count < detail::kTapeCountLimit)
+      {
+        return static_cast<std::size_t>(count);
+      }
+      std::size_t counted = 0;
+      for (Iterator it = begin(), last = end(); it != last; ++it)
+      {
+        ++counted;
+      }
+      return counted;
+    }
+
+    Iterator begin() const
+    {
+      return Iterator(mBuffers, isObject() ? mIndex + 2 : mIndex + 1, isObject());
+    }
+
+    Iterator end() const
+    {
+      return Iterator(mBuffers, static_cast<std::size_t>(Payload() & 0xFFFFFFFF), isObject());
+    }
+
+    // Element of an array / value of the index-th member of an object
+    TapeNode operator[](std::size_t index) const
+    {
+      Iterator it = begin();
+      for (; index > 0; --index)
+      {
+        ++it;
+      }
+      return *it;
+    }
+
+    // Value of the first member named key
+    std::optional<TapeNode> find(std::string_view key) const
+    {
+      if (!isObject())
+      {
+        return std::nullopt;
+      }
+      const std::uint64_t table = mBuffers->tape[mIndex + 1];
+      if (table == 0)
+      {
+        for (Iterator it = begin(), last = end(); it != last; ++it)
+        {
+          if (it.key() == key)
+          {
+            return *it;
+          }
+        }
+        return std::nullopt;
+      }
+
+      const std::uint32_t* slots = mBuffers->index.data() + (table >> 8);
+      const std::size_t mask = (std::size_t{1} << (table & 0xFF)) - 1;
+      for (std::size_t slot = std::hash<std::string_view>{}(key) & mask;; slot = (slot + 1) & mask)
+      {
+        const std::uint32_t entry = slots[slot];
+        if (entry == 0)
+        {
+          return std::nullopt;
+        }
+        if (mBuffers->String(entry - 1) == key)
+        {
+          return TapeNode(mBuffers, entry);
+        }
+      }
+    }
+
+    Value ToValue() const
+    {
+      switch (Tag())
+      {
+        case detail::TapeTag::False: return false;
+        case detail::TapeTag::True: return true;
+        case detail::TapeTag::Number: return asNumber();
+        case detail::TapeTag::String: return std::string(asString());
+        case detail::TapeTag::Array:
+        {
+          Array array;
+          array.reserve(size());
+          for (TapeNode element : *this)
+          {
+            array.push_back(element.ToValue());
+          }
+          return array;
+        }
+        case detail::TapeTag::Object:
+        {
+          Object object;
+          object.reserve(size());
+          for (Iterator it = begin(), last = end(); it != last; ++it)
+          {
+            const std::string_view name = it.key();
+            if (!object.contains(name))
+            {
+              object.try_emplace(std::string(name), (*it).ToValue());
             }
-            if (Match(']'))
+          }
+          return object;
+        }
+        default: return nullptr;
+      }
+    }
+
+  private:
+    friend class TapeDocument;
+
+    // Two words, so nodes are passed in registers
+    const detail::TapeBuffers* mBuffers;
+    std::size_t mIndex;
+
+    TapeNode(const detail::TapeBuffers* buffers, std::size_t index) : mBuffers(buffers), mIndex(index)
+    {}
+
+    detail::TapeTag Tag() const
+    {
+      return static_cast<detail::TapeTag>(mBuffers->tape[mIndex] >> 56);
+    }
+
+    std::uint64_t Payload() const
+    {
+      return mBuffers->tape[mIndex] & detail::kTapePayloadMask;
+    }
+  };
+
+  // Read-only document stored as one flat tape of 64 bit entries (see detail::TapeTag) with numbers and strings in side
+  // buffers, for documents that are parsed once and then only read: building it fills a few growing buffers instead
+  // of allocating a node per value, and walking it is sequential. Strings are copied, so the source needn't outlive
+  // the document, and re-parsing reuses the buffers' capacity. Up to 2^32 tape entries and strings up to 4 GiB (larger
+  // documents fail with TooManyElements / StringTooLong); duplicate keys are kept in iteration while find / ToValue use
+  // the first one, like Parse.
+  class TapeDocument
+  {
+  public:
+    TapeDocument() = default;
+    TapeDocument(TapeDocument&&) = default;
+    TapeDocument& operator=(TapeDocument&&) = default;
+    TapeDocument(const TapeDocument&) = delete;
+    TapeDocument& operator=(const TapeDocument&) = delete;
+
+    // Replace the document with src (null root on failure)
+    ErrorCode Parse(std::string_view src, Error* error = nullptr)
+    {
+      return Parse(src, ParseOptions{}, error);
+    }
+
+    ErrorCode Parse(std::string_view src, const ParseOptions& options, Error* error = nullptr)
+    {
+      mBuffers.Clear();
+      detail::TapeBuilder builder(mBuffers);
+      ErrorCode errorCode = ErrorCode::OK;
+      if (options.trustedInput)
+      {
+        BasicParser<false> p(src, {}, options);
+        errorCode = p.ParseEvents(builder, error);
+      }
+      else
+      {
+        Parser p(src, {}, options);
+        errorCode = p.ParseEvents(builder, error);
+      }
+      if (errorCode == ErrorCode::Aborted && builder.Overflow() != ErrorCode::OK)
+      {
+        errorCode = builder.Overflow();
+        if (error)
+        {
+          error->code = errorCode;
+          error->message = errorCode == ErrorCode::StringTooLong ? "String too long for a TapeDocument" : "Document too large for a TapeDocument";
+        }
+      }
+      if (errorCode != ErrorCode::OK)
+      {
+        mBuffers.Clear();
+        mBuffers.tape.push_back(0);
+      }
+      return errorCode;
+    }
+
+    TapeNode Root() const
+    {
+      return TapeNode(&mBuffers, 0);
+    }
+
+    Value ToValue() const
+    {
+      return Root().ToValue();
+    }
+
+  private:
+    detail::TapeBuffers mBuffers;
+  };
+
+  struct WriteOptions
+  {
+    int indentWidth = 2; // Spaces per indent level
+    bool sortObjectKeys = false;
+    bool compactIntegers = false; // Write integral numbers without the ".0" suffix (42 instead of 42.0)
+    // Lossless writers, for trees from ParseLossless: copy everything that wasn't edited from the parsed source and
+    // rewrite only dirty values (see LosslessValue), so the rest of the document keeps its formatting byte for byte.
+    // Structural edits (added / removed / renamed members, changed comments) fall back to reformatting the document.
+    bool keepSourceText = false;
+  };
+
+  // Streaming output target for Write / WriteLossless. Text is collected in a bounded buffer that is handed to Write()
+  // whenever it fills up (and on Flush()), so output never needs the whole document in memory. Derive and implement
+  // Write() for custom targets (socket, compressor, ...); derived sinks should Flush() in their destructor.
+  class Sink
+  {
+  public:
+    explicit Sink(std::size_t bufferSize = 16 * 1024) : mBuffer(std::max<std::size_t>(bufferSize, 1))
+    {}
+
+    virtual ~Sink() = default;
+
+    Sink(const Sink&) = delete;
+    Sink& operator=(const Sink&) = delete;
+
+    void push_back(char c)
+    {
+      if (mSize == mBuffer.size())
+      {
+        FlushBuffer();
+      }
+      mBuffer[mSize++] = c;
+    }
+
+    void append(std::string_view text)
+    {
+      if (text.size() > mBuffer.size() - mSize)
+      {
+        FlushBuffer();
+        if (text.size() >= mBuffer.size())
+        {
+          // Larger than the buffer; pass straight through
+          Emit(text);
+          return;
+        }
+      }
+      std::memcpy(mBuffer.data() + mSize, text.data(), text.size());
+      mSize += text.size();
+    }
+
+    void append(const char* data, std::size_t size)
+    {
+      append(std::string_view(data, size));
+    }
+
+    void append(std::size_t count, char c)
+    {
+      while (count > 0)
+      {
+        if (mSize == mBuffer.size())
+        {
+          FlushBuffer();
+        }
+        std::size_t chunk = std::min(count, mBuffer.size() - mSize);
+        std::memset(mBuffer.data() + mSize, c, chunk);
+        mSize += chunk;
+        count -= chunk;
+      }
+    }
+
+    Sink& operator+=(std::string_view text)
+    {
+      append(text);
+      return *this;
+    }
+
+    Sink& operator+=(char c)
+    {
+      push_back(c);
+      return *this;
+    }
+
+    // Hand buffered output to the target; false once any write has failed
+    bool Flush()
+    {
+      FlushBuffer();
+      return !mFailed;
+    }
+
+    bool Failed() const
+    {
+      return mFailed;
+    }
+
+  protected:
+    // Deliver size bytes to the target; returning false discards all later output and marks the sink failed
+    virtual bool Write(const char* data, std::size_t size) = 0;
+
+  private:
+    std::vector<char> mBuffer;
+    std::size_t mSize = 0;
+    bool mFailed = false;
+
+    void FlushBuffer()
+    {
+      if (mSize > 0)
+      {
+        Emit(std::string_view(mBuffer.data(), mSize));
+        mSize = 0;
+      }
+    }
+
+    void Emit(std::string_view text)
+    {
+      if (!mFailed && !Write(text.data(), text.size()))
+      {
+        mFailed = true;
+      }
+    }
+  };
+
+  class FileSink : public Sink
+  {
+  public:
+    explicit FileSink(std::FILE* file, std::size_t bufferSize = 16 * 1024) : Sink(bufferSize), mFile(file)
+    {}
+
+    ~FileSink() override
+    {
+      Flush();
+    }
+
+  protected:
+    bool Write(const char* data, std::size_t size) override
+    {
+      return std::fwrite(data, 1, size, mFile) == size;
+    }
+
+  private:
+    std::FILE* mFile;
+  };
+
+  class OStreamSink : public Sink
+  {
+  public:
+    explicit OStreamSink(std::ostream& stream, std::size_t bufferSize = 16 * 1024) : Sink(bufferSize), mStream(stream)
+    {}
+
+    ~OStreamSink() override
+    {
+      Flush();
+    }
+
+  protected:
+    bool Write(const char* data, std::size_t size) override
+    {
+      mStream.write(data, static_cast<std::streamsize>(size));
+      return static_cast<bool>(mStream);
+    }
+
+  private:
+    std::ostream& mStream;
+  };
+
+  // Forwards each flushed block to a callback, e.g. a socket send or a compressor; return false to stop
+  class CallbackSink : public Sink
+  {
+  public:
+    explicit CallbackSink(std::function<bool(std::string_view)> callback, std::size_t bufferSize = 16 * 1024)
+      : Sink(bufferSize), mCallback(std::move(callback))
+    {}
+
+    ~CallbackSink() override
+    {
+      Flush();
+    }
+
+  protected:
+    bool Write(const char* data, std::size_t size) override
+    {
+      return mCallback(std::string_view(data, size));
+    }
+
+  private:
+    std::function<bool(std::string_view)> mCallback;
+  };
+
+  namespace detail
+  {
+    template <typename Out>
+    void WriteIndent(Out& out, int level, int width)
+    {
+      out.append(static_cast<std::size_t>(level * width), ' ');
+    }
+
+    enum class WriteContext : std::uint8_t
+    {
+      Root,
+      InObject,
+      InArray,
+    };
+
+    template <typename Out>
+    bool WriteValue(const Value& value, Out& out, int indentLevel, const WriteOptions& opt, WriteContext ctx);
+
+    using ObjectItemView = std::pair<std::string_view, const Value*>;
+
+    inline std::vector<ObjectItemView> OrderedObjectItems(const Object& object, bool sortKeys)
+    {
+      std::vector<ObjectItemView> items;
+      items.reserve(object.size());
+      for (const auto& keyValuePair : object)
+      {
+        items.emplace_back(keyValuePair.first, &keyValuePair.second);
+      }
+      if (sortKeys)
+      {
+        std::sort(items.begin(), items.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+      }
+      return items;
+    }
+
+    // Visit members in insertion order without copying; only sortKeys builds (and sorts) a view of the items
+    template <typename Fn>
+    void ForEachObjectItem(const Object& object, bool sortKeys, Fn&& fn)
+    {
+      if (!sortKeys)
+      {
+        for (const auto& [key, value] : object)
+        {
+          fn(std::string_view(key), value);
+        }
+        return;
+      }
+      for (const auto& [key, valuePtr] : OrderedObjectItems(object, true))
+      {
+        fn(key, *valuePtr);
+      }
+    }
+
+    using LosslessItemView = std::pair<std::string_view, const LosslessValue*>;
+
+    inline std::vector<LosslessItemView>
+    OrderedLosslessItems(const std::vector<std::pair<std::string, LosslessValue>>& items, bool sortKeys)
+    {
+      std::vector<LosslessItemView> views;
+      views.reserve(items.size());
+      for (const auto& keyValuePair : items)
+      {
+        views.emplace_back(keyValuePair.first, &keyValuePair.second);
+      }
+      if (sortKeys)
+      {
+        std::sort(views.begin(), views.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+      }
+      return views;
+    }
+
+    // ForEachObjectItem for lossless members: insertion order without copying, only sortKeys builds a sorted view
+    template <typename Fn>
+    void ForEachLosslessItem(const std::vector<std::pair<std::string, LosslessValue>>& items, bool sortKeys, Fn&& fn)
+    {
+      if (!sortKeys)
+      {
+        for (const auto& [key, child] : items)
+        {
+          fn(std::string_view(key), child);
+        }
+        return;
+      }
+      for (const auto& [key, childPtr] : OrderedLosslessItems(items, true))
+      {
+        fn(key, *childPtr);
+      }
+    }
+
+    // Double-quoted string shared by the CSON and JSON writers: runs without anything to escape (found with
+    // FindEscapeNeeded) are appended in one piece, the bytes between them are escaped through kEscapeTable
+    template <typename Out>
+    void WriteStringQuoted(std::string_view value, Out& out)
+    {
+      static constexpr char hexDigits[] = "0123456789abcdef";
+      out.push_back('"');
+      const char* data = value.data();
+      std::size_t start = 0;
+      while (true)
+      {
+        const std::size_t special = FindEscapeNeeded(data, start, value.size());
+        out.append(data + start, special - start);
+        if (special == value.size())
+        {
+          break;
+        }
+        const unsigned char c = static_cast<unsigned char>(data[special]);
+        const char escape = kEscapeTable[c];
+        if (escape == 'u')
+        {
+          const char sequence[] = {'\\', 'u', '0', '0', hexDigits[c >> 4], hexDigits[c & 0xF]};
+          out.append(sequence, sizeof(sequence));
+        }
+        else
+        {
+          const char sequence[] = {'\\', escape};
+          out.append(sequence, sizeof(sequence));
+        }
+        start = special + 1;
+      }
+      out.push_back('"');
+    }
+
+    // Shortest round-trip formatting, written straight into out. Integral values below 2^53 take the integer path and
+    // keep a ".0" suffix unless compactIntegers is set.
+    template <typename Out>
+    void AppendNumber(double value, Out& out, bool compactIntegers = false)
+    {
+      char buffer[32];
+      char* end = buffer;
+      if (std::fabs(value) < 9007199254740992.0 && value == std::trunc(value))
+      {
+        if (value == 0.0 && std::signbit(value))
+        {
+          *end++ = '-';
+        }
+        end = std::to_chars(end, buffer + sizeof(buffer), static_cast<std::int64_t>(value)).ptr;
+        if (!compactIntegers)
+        {
+          *end++ = '.';
+          *end++ = '0';
+        }
+      }
+      else
+      {
+        end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+        bool plainDigits = std::find_if(buffer, end, [](char c) { return c == '.' || c == 'e' || c == 'n' || c == 'i'; }) == end;
+        if (!compactIntegers && plainDigits)
+        {
+          *end++ = '.';
+          *end++ = '0';
+        }
+      }
+      out.append(buffer, static_cast<std::size_t>(end - buffer));
+    }
+
+    inline std::string FormatNumber(double value)
+    {
+      std::string result;
+      AppendNumber(value, result);
+      return result;
+    }
+
+    // NaN / infinity have no CSON or JSON spelling; writers report them through this and stop
+    inline bool FailNonFinite(Error* error)
+    {
+      if (error)
+      {
+        error->code = ErrorCode::InvalidNumber;
+        error->where = {};
+        error->message = "Non-finite number value";
+      }
+      return false;
+    }
+
+    // "Simple" scalars for inline arrays; the size test comes first so long strings are never scanned
+    inline bool IsSimpleScalar(const Value& value)
+    {
+      if (std::holds_alternative<std::nullptr_t>(value) || std::holds_alternative<bool>(value) || std::holds_alternative<double>(value))
+      {
+        return true;
+      }
+      if (std::holds_alternative<std::string>(value))
+      {
+        const auto& readonlyValue = std::get<std::string>(value);
+        // Single-line, reasonably short
+        return readonlyValue.size() <= 32 && readonlyValue.find('\n') == std::string::npos;
+      }
+      return false; // Arrays / objects aren't "simple"
+    }
+
+    // Array layout, worked out once per array and handed to WriteArray by the caller that needed it first
+    enum class ArrayLayout : std::uint8_t
+    {
+      Inline, // [1, 2, 3]: up to three simple scalars
+      Block, // One element per line
+    };
+
+    inline ArrayLayout LayoutOf(const Array& array)
+    {
+      if (array.size() > 3)
+      {
+        return ArrayLayout::Block;
+      }
+      for (const auto& value : array)
+      {
+        if (!IsSimpleScalar(value))
+        {
+          return ArrayLayout::Block;
+        }
+      }
+      return ArrayLayout::Inline;
+    }
+
+    inline bool CanInlineArray(const Array& array)
+    {
+      return LayoutOf(array) == ArrayLayout::Inline;
+    }
+
+    // Scalar known to be simple (IsSimpleScalar), so strings go out quoted without another look for line breaks.
+    // Returns false for a non-finite number, like every writer below: validation happens while writing and the first
+    // NaN / infinity stops the whole write.
+    template <typename Out>
+    bool WriteSimpleScalar(const Value& value, Out& out, const WriteOptions& options)
+    {
+      if (std::holds_alternative<std::nullptr_t>(value))
+      {
+        out += "null";
+      }
+      else if (std::holds_alternative<bool>(value))
+      {
+        out += (std::get<bool>(value) ? "true" : "false");
+      }
+      else if (std::holds_alternative<double>(value))
+      {
+        const double number = std::get<double>(value);
+        if (!std::isfinite(number))
+        {
+          return false;
+        }
+        AppendNumber(number, out, options.compactIntegers);
+      }
+      else
+      {
+        WriteStringQuoted(std::get<std::string>(value), out);
+      }
+      return true;
+    }
+
+    // Forward declaration so inline writer can recurse on objects
+    template <typename Out>
+    bool WriteObject(
+      const Object& object,
+      Out& out,
+      int indentLevel,
+      const WriteOptions& options,
+      WriteContext ctx,
+      bool indentFirstLine = true);
+
+    // Inline writer used for array-context objects to avoid newlines
+    template <typename Out>
+    bool WriteValueInline(const Value& value, Out& out, const WriteOptions& options)
+    {
+      if (std::holds_alternative<Array>(value))
+      {
+        out.push_back('[');
+        std::size_t index = 0;
+        for (const auto& e : std::get<Array>(value))
+        {
+          if (index++ > 0)
+          {
+            out += ", ";
+          }
+          if (!WriteValueInline(e, out, options))
+          {
+            return false;
+          }
+        }
+        out.push_back(']');
+        return true;
+      }
+      if (std::holds_alternative<Object>(value))
+      {
+        return WriteObject(std::get<Object>(value), out, 0, options, WriteContext::InArray, false);
+      }
+      // Strings stay quoted even with line breaks; WriteStringQuoted escapes them
+      return WriteSimpleScalar(value, out, options);
+    }
+
+    template <typename Out>
+    void WriteKey(std::string_view key, Out& out)
+    {
+      bool bareOK = true;
+      if (key.empty())
+      {
+        bareOK = false;
+      }
+      else
+      {
+        char c0 = key[0];
+        if (!((c0 >= 'A' && c0 <= 'Z') || (c0 >= 'a' && c0 <= 'z') || c0 == '_'))
+        {
+          bareOK = false;
+        }
+        for (char c : key)
+        {
+          if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c == '-'))
+          {
+            bareOK = false;
+            break;
+          }
+        }
+      }
+      if (bareOK)
+      {
+        out += key;
+      }
+      else
+      {
+        WriteStringQuoted(key, out);
+      }
+      out += ": ";
+    }
+
+    template <typename Out>
+    bool WriteArray(const Array& array, Out& out, int indentLevel, const WriteOptions& options, WriteContext ctx, ArrayLayout layout);
+
+    template <typename Out>
+    bool WriteObject(const Object& object, Out& out, int indentLevel, const WriteOptions& options, WriteContext ctx, bool indentFirstLine)
+    {
+      bool ok = true;
+
+      // If writing an object as an array element, emit fully inline braces to avoid indent ambiguity
+      if (ctx == WriteContext::InArray)
+      {
+        out.push_back('{');
+        std::size_t index = 0;
+        ForEachObjectItem(object, options.sortObjectKeys, [&](std::string_view key, const Value& value) {
+          if (!ok)
+          {
+            return;
+          }
+          if (index++ > 0)
+          {
+            out += ", ";
+          }
+          WriteKey(key, out);
+          ok = WriteValueInline(value, out, options);
+        });
+        out.push_back('}');
+        return ok;
+      }
+
+      // CoffeeScript-style brace-less objects elsewhere
+      const int contentIndent = indentLevel;
+
+      // Empty object
+      if (object.empty())
+      {
+        if (indentFirstLine)
+        {
+          WriteIndent(out, indentLevel, options.indentWidth);
+        }
+        out += "{}";
+        return true;
+      }
+
+      bool first = true;
+      ForEachObjectItem(object, options.sortObjectKeys, [&](std::string_view key, const Value& value) {
+        if (!ok)
+        {
+          return;
+        }
+        if (!first)
+        {
+          out.push_back('\n');
+        }
+
+        // If caller already emitted indent for the first line, skip it once
+        if (!(first && !indentFirstLine))
+        {
+          WriteIndent(out, contentIndent, options.indentWidth);
+        }
+        first = false;
+
+        WriteKey(key, out);
+
+        if (std::holds_alternative<Object>(value))
+        {
+          // Block value on next line with increased indent
+          out.push_back('\n');
+          ok = WriteObject(std::get<Object>(value), out, contentIndent + 1, options, WriteContext::InObject);
+        }
+        else if (std::holds_alternative<Array>(value))
+        {
+          // The layout decides the line as well as the format, so it is worked out here and passed on
+          const Array& array = std::get<Array>(value);
+          const ArrayLayout layout = LayoutOf(array);
+          if (layout == ArrayLayout::Block)
+          {
+            out.push_back('\n');
+            ok = WriteArray(array, out, contentIndent + 1, options, WriteContext::InObject, layout);
+          }
+          else
+          {
+            ok = WriteArray(array, out, contentIndent, options, WriteContext::InObject, layout);
+          }
+        }
+        else
+        {
+          // Scalars stay on the same line
+          ok = WriteValue(value, out, contentIndent, options, WriteContext::InObject);
+        }
+      });
+      return ok;
+    }
+
+    template <typename Out>
+    bool WriteArray(const Array& array, Out& out, int indentLevel, const WriteOptions& options, WriteContext ctx, ArrayLayout layout)
+    {
+      // LOGIC:
+      //  1. If array is small and all "simple" scalars -> inline: [1, 2, 3]
+      //  2. Otherwise -> multiline:
+      //       [
+      //         1
+      //         2
+      //         foo: 1
+      //         bar: 2
+      //       ]
+      //     where objects become brace-less indent blocks
+
+      if (array.empty())
+      {
+        out += "[]";
+        return true;
+      }
+
+      // Inline small scalar arrays
+      if (layout == ArrayLayout::Inline)
+      {
+        out.push_back('[');
+        bool first = true;
+        for (const auto& value : array)
+        {
+          if (!first)
+          {
+            out += ", ";
+          }
+          first = false;
+          if (!WriteSimpleScalar(value, out, options))
+          {
+            return false;
+          }
+        }
+        out.push_back(']');
+        return true;
+      }
+
+      // Multiline array, CoffeeScript-style
+      const bool callerIndented = ctx == WriteContext::InArray;
+      if (!callerIndented)
+      {
+        WriteIndent(out, indentLevel, options.indentWidth);
+      }
+      out.push_back('[');
+      out.push_back('\n');
+
+      bool first = true;
+      for (const auto& value : array)
+      {
+        if (!first)
+        {
+          out.push_back('\n');
+        }
+        first = false;
+
+        // Every element begins at the array's child indent
+        WriteIndent(out, indentLevel + 1, options.indentWidth);
+
+        // Objects use the array-context writer (braced, comma-separated); scalars / nested arrays keep the usual
+        // "one per line" indent
+        if (!WriteValue(value, out, indentLevel + 1, options, WriteContext::InArray))
+        {
+          return false;
+        }
+      }
+
+      out.push_back('\n');
+      WriteIndent(out, indentLevel, options.indentWidth);
+      out.push_back(']');
+      return true;
+    }
+
+    template <typename Out>
+    bool WriteValue(const Value& value, Out& out, int indentLevel, const WriteOptions& options, WriteContext ctx)
+    {
+      if (std::holds_alternative<std::string>(value))
+      {
+        const auto& stringValue = std::get<std::string>(value);
+        if (stringValue.find('\n') != std::string::npos)
+        {
+          // Multiline -> triple-quoted
+          out += "\"\"\"";
+          out += stringValue;
+          out += "\"\"\"";
+        }
+        else
+        {
+          WriteStringQuoted(stringValue, out);
+        }
+        return true;
+      }
+      if (std::holds_alternative<Array>(value))
+      {
+        const Array& array = std::get<Array>(value);
+        return WriteArray(array, out, indentLevel, options, ctx, LayoutOf(array));
+      }
+      if (std::holds_alternative<Object>(value))
+      {
+        return WriteObject(std::get<Object>(value), out, indentLevel, options, ctx);
+      }
+      return WriteSimpleScalar(value, out, options);
+    }
+
+  } // namespace detail
+
+  // Format value as CSON into out. Numbers are checked while writing: a NaN / infinity fails with
+  // ErrorCode::InvalidNumber and leaves out empty.
+  inline bool ToString(const Value& value, std::string& out, const WriteOptions& options = {}, Error* error = nullptr)
+  {
+    out.clear();
+    if (!detail::WriteValue(value, out, 0, options, detail::WriteContext::Root))
+    {
+      out.clear();
+      return detail::FailNonFinite(error);
+    }
+    if (error)
+    {
+      *error = {};
+    }
+    return true;
+  }
+
+  inline std::string ToString(const Value& value, const WriteOptions& options = {})
+  {
+    std::string result;
+    Error error;
+    if (!ToString(value, result, options, &error))
+    {
+      return {};
+    }
+    return result;
+  }
+
+  // Stream value to sink and flush it. The document is written in one pass, so when it holds a NaN / infinity the sink
+  // has already received (and flushed) the part before it.
+  inline bool Write(const Value& value, Sink& sink, const WriteOptions& options = {}, Error* error = nullptr)
+  {
+    if (!detail::WriteValue(value, sink, 0, options, detail::WriteContext::Root))
+    {
+      return detail::FailNonFinite(error);
+    }
+    if (!sink.Flush())
+    {
+      if (error)
+      {
+        error->code = ErrorCode::InternalError;
+        error->where = {};
+        error->message = "Failed to write output";
+      }
+      return false;
+    }
+    if (error)
+    {
+      *error = {};
+    }
+    return true;
+  }
+
+  namespace detail
+  {
+    template <typename Out>
+    void WriteCommentLines(const std::vector<LosslessComment>& lines, Out& out, const WriteOptions& options)
+    {
+      bool prevNonEmpty = false;
+      for (const auto& line : lines)
+      {
+        if (prevNonEmpty && !line.text.empty())
+        {
+          out.push_back('\n');
+        }
+        if (line.text.empty())
+        {
+          out.push_back('\n');
+          prevNonEmpty = false;
+        }
+        else
+        {
+          WriteIndent(out, line.indent, 1); // Indent is absolute columns
+          out.append(line.text.view());
+          out.push_back('\n');
+          prevNonEmpty = true;
+        }
+      }
+    }
+
+    // Lossless counterpart of WriteValueInline for the containers inside a braced object, written straight from the
+    // lossless children (their comments have no place on one line)
+    template <typename Out>
+    bool WriteLosslessInline(const LosslessValue& value, Out& out, const WriteOptions& options)
+    {
+      if (value.value.isArray())
+      {
+        out.push_back('[');
+        for (std::size_t index = 0; index < value.arrayItems.size(); ++index)
+        {
+          if (index > 0)
+          {
+            out += ", ";
+          }
+          if (!WriteLosslessInline(value.arrayItems[index], out, options))
+          {
+            return false;
+          }
+        }
+        out.push_back(']');
+        return true;
+      }
+      if (value.value.isObject())
+      {
+        out.push_back('{');
+        bool ok = true;
+        std::size_t index = 0;
+        ForEachLosslessItem(value.objectItems, options.sortObjectKeys, [&](std::string_view key, const LosslessValue& child) {
+          if (!ok)
+          {
+            return;
+          }
+          if (index++ > 0)
+          {
+            out += ", ";
+          }
+          WriteKey(key, out);
+          ok = WriteLosslessInline(child, out, options);
+        });
+        out.push_back('}');
+        return ok;
+      }
+      return WriteValueInline(value.value, out, options);
+    }
+
+    // writeLeadingComments is false when the caller already wrote them (before the key of a block value)
+    template <typename Out>
+    bool WriteLosslessValue(
+      const LosslessValue& value, Out& out, int indentLevel, const WriteOptions& options, WriteContext ctx, bool writeLeadingComments = true)
+    {
+      if (writeLeadingComments)
+      {
+        WriteCommentLines(value.leadingComments, out, options);
+      }
+
+      auto trimTrailingSpaces = [](std::string_view value) {
+        while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+        {
+          value.remove_suffix(1);
+        }
+        return value;
+      };
+
+      auto writeInlineComment = [&](std::string_view value) {
+        if (!value.empty())
+        {
+          out.append(" #");
+          out.append(value);
+        }
+      };
+
+      if (std::holds_alternative<Array>(value.value) && !value.arrayItems.empty())
+      {
+        WriteIndent(out, indentLevel, options.indentWidth);
+        out.append("[\n");
+        for (std::size_t index = 0; index < value.arrayItems.size(); ++index)
+        {
+          const LosslessValue& child = value.arrayItems[index];
+          if (!WriteLosslessValue(child, out, indentLevel + 1, options, WriteContext::InArray))
+          {
+            return false;
+          }
+          if (index + 1 < value.arrayItems.size())
+          {
+            out.push_back('\n');
+          }
+        }
+        out.push_back('\n');
+        WriteIndent(out, indentLevel, options.indentWidth);
+        out.push_back(']');
+        return true;
+      }
+
+      if (std::holds_alternative<Object>(value.value) && !value.objectItems.empty())
+      {
+        const std::size_t count = value.objectItems.size();
+        bool ok = true;
+        std::size_t index = 0;
+        // Use braces only in array context, otherwise use indent-style
+        if (ctx == WriteContext::InArray)
+        {
+          // Inline braced format for objects in arrays
+          out.append("{\n");
+          ForEachLosslessItem(value.objectItems, options.sortObjectKeys, [&](std::string_view key, const LosslessValue& child) {
+            if (!ok)
             {
-              break;
+              return;
             }
-            if (Match(','))
+            WriteCommentLines(child.leadingComments, out, options);
+            WriteIndent(out, indentLevel + 1, options.indentWidth);
+            out.append(key);
+            out.append(": ");
+            ok = child.value.isArray() || child.value.isObject()
+                   ? WriteLosslessInline(child, out, options)
+                   : WriteValue(child.value, out, indentLevel + 1, options, WriteContext::InObject);
+            if (!ok)
             {
-              SkipWhitespaceAndComments();
-              continue;
+              return;
             }
-            if (Peek() == '\r' || Peek() == '\n')
+            writeInlineComment(child.inlineComment);
+            if (++index < count)
             {
-              c = Get();
-              if (c == '\r' && Peek() == '\n')
-              {
-                Get();
-              }
-              bool hasLine2 = false;
-              errorCode = NextContentLineLossless(hasLine2, mPendingComments);
-              if (errorCode != ErrorCode::OK)
-              {
-                return errorCode;
-              }
-              if (!hasLine2 || mIndentStack.back() < arrayIndent)
-              {
-                break;
-              }
-              continue;
+              out.push_back('\n');
             }
-            return Finish(ErrorCode::UnexpectedChar, nullptr, "Expected ',' or ']' or newline in multiline array");
+          });
+          if (!ok)
+          {
+            return false;
+          }
+          out.push_back('\n');
+          WriteIndent(out, indentLevel, options.indentWidth);
+          out.push_back('}');
+          return true;
+        }
+
+        // Indent-style format for regular objects
+        ForEachLosslessItem(value.objectItems, options.sortObjectKeys, [&](std::string_view key, const LosslessValue& child) {
+          if (!ok)
+          {
+            return;
           }
 
-          // After loop, consume closing ] if present
-          if (Peek() == ']')
+          // Write leading comments for this key (includes blanks)
+          WriteCommentLines(child.leadingComments, out, options);
+
+          WriteIndent(out, indentLevel, options.indentWidth);
+          out.append(key);
+          out.append(":");
+
+          // Determine if value should be on next line
+          bool isObject = std::holds_alternative<Object>(child.value);
+          bool isArray = std::holds_alternative<Array>(child.value);
+
+          if (isObject || isArray)
           {
-            Get();
+            out.push_back('\n');
+            // Their leading comments were already written above as comments for this key
+            ok = WriteLosslessValue(child, out, indentLevel + 1, options, WriteContext::InObject, false);
           }
-        }
-        else
-        {
-          SkipWhitespaceAndComments();
-          if (Match(']'))
+          else
           {
-            out.value = std::move(array);
-            return ErrorCode::OK;
+            out.push_back(' ');
+            ok = WriteValue(child.value, out, indentLevel, options, WriteContext::InObject);
+          }
+          if (!ok)
+          {
+            return;
           }
 
-          while (true)
+          // Trim trailing spaces from inline comments
+          writeInlineComment(trimTrailingSpaces(child.inlineComment));
+
+          if (++index < count)
           {
-            if (Peek() == ']')
-            {
-              Get();
-              break;
-            }
+            out.push_back('\n');
+          }
+        });
+        return ok;
+      }
 
-            LosslessValue child;
-            ErrorCode errorCode = ParseValueLossless(child, parentIndent);
-            if (errorCode != ErrorCode::OK)
-            {
-              return errorCode;
-            }
-            array.push_back(child.value);
-            out.arrayItems.push_back(std::move(child));
+      WriteIndent(out, indentLevel, options.indentWidth);
+      if (!WriteValue(value.value, out, indentLevel, options, ctx))
+      {
+        return false;
+      }
+      writeInlineComment(value.inlineComment);
+      return true;
+    }
 
-            SkipWhitespaceAndComments();
-            if (Match(']'))
-            {
-              break;
-            }
-            if (!Match(','))
-            {
-              return Finish(ErrorCode::UnexpectedChar, nullptr, "Expected ',' or ']' in inline array");
-            }
-            SkipWhitespaceAndComments();
+    inline bool CommentsFromSource(const std::vector<LosslessComment>& lines)
+    {
+      return std::all_of(
+        lines.begin(), lines.end(), [](const LosslessComment& line) { return line.text.empty() || line.text.viewsSource(); });
+    }
+
+    // Whether the source at text starts with key as written by ParseKey (bare or quoted without escapes)
+    inline bool SourceKeyMatches(std::string_view text, std::string_view key)
+    {
+      if (!text.empty() && (text[0] == '"' || text[0] == '\''))
+      {
+        return text.size() >= key.size() + 2 && text.substr(1, key.size()) == key && text[key.size() + 1] == text[0];
+      }
+      if (!text.starts_with(key) || key.empty() || text.size() == key.size())
+      {
+        return false;
+      }
+      const char next = text[key.size()];
+      return next == ':' || next == ' ' || next == '\t' || next == '\r' || next == '\n';
+    }
+
+    // Whether WriteLosslessSpliced can write value: everything not dirty must still be its parsed text, and a dirty
+    // container must still have its parsed children in their places (same kind, count, order, keys and comments), since
+    // the text between them is copied. Anything else (inserted / removed / renamed members, a scalar that became a
+    // container, a tree not from ParseLossless) needs the regular writer.
+    inline bool CanSpliceLossless(const LosslessValue& value, bool root)
+    {
+      if (value.sourceText.empty() || LosslessShape(value) != value.sourceShape || !CommentsFromSource(value.leadingComments) ||
+          !CommentsFromSource(value.trailingComments) || !(value.inlineComment.empty() || value.inlineComment.viewsSource()))
+      {
+        return false;
+      }
+      if (!value.dirty)
+      {
+        return true;
+      }
+      if (!value.isArray() && !value.isObject())
+      {
+        return !root; // The root's text also holds the document's comments
+      }
+
+      const std::string_view text = value.sourceText.view();
+      const auto address = [](const char* pointer) { return reinterpret_cast<std::uintptr_t>(pointer); };
+      std::uintptr_t cursor = address(text.data());
+      const std::uintptr_t end = cursor + text.size();
+      auto fits = [&](const LosslessValue& child, std::string_view key, bool member) {
+        if (!CanSpliceLossless(child, false))
+        {
+          return false;
+        }
+        const std::string_view childText = child.sourceText.view();
+        const std::uintptr_t childStart = address(childText.data());
+        if (childStart < cursor + child.sourceKeyDistance || childStart + childText.size() > end)
+        {
+          return false;
+        }
+        if (member)
+        {
+          const char* keyStart = text.data() + (childStart - child.sourceKeyDistance - address(text.data()));
+          if (!SourceKeyMatches(std::string_view(keyStart, childText.data() - keyStart), key))
+          {
+            return false;
           }
         }
+        cursor = childStart + childText.size();
+        return true;
+      };
+      for (const LosslessValue& item : value.arrayItems)
+      {
+        if (!fits(item, {}, false))
+        {
+          return false;
+        }
+      }
+      for (const auto& item : value.objectItems)
+      {
+        if (!fits(item.second, item.first, true))
+        {
+          return false;
+        }
+      }
+      return true;
+    }
 
-        out.value = std::move(array);
-        return ErrorCode::OK;
+    inline bool SameScalar(const Value& a, const Value& b)
+    {
+      if (a.index() != b.index())
+      {
+        return false;
+      }
+      if (a.isNumber())
+      {
+        const double x = std::get<double>(a);
+        const double y = std::get<double>(b);
+        return x == y && std::signbit(x) == std::signbit(y);
       }
+      if (a.isBool())
+      {
+        return std::get<bool>(a) == std::get<bool>(b);
+      }
+      return !a.isString() || std::get<std::string>(a) == std::get<std::string>(b);
+    }
 
-      ErrorCode ParseIdentifierOrIndentedObjectLossless(LosslessValue& out, int currentIndent)
+    // Source text of value with only the dirty parts rewritten (CanSpliceLossless must have approved value)
+    template <typename Out>
+    bool WriteLosslessSpliced(const LosslessValue& value, Out& out, const WriteOptions& options)
+    {
+      const std::string_view text = value.sourceText.view();
+      if (!value.dirty)
+      {
+        out.append(text.data(), text.size());
+        return true;
+      }
+      if (!value.isArray() && !value.isObject())
       {
-        std::string identifier;
-        while (IsIdentifierChar(Peek()))
+        // Marked by an accessor but possibly unchanged: keep the original spelling then
+        Value parsed;
+        if (Parse(text, parsed) == ErrorCode::OK && SameScalar(parsed, value.value))
         {
-          identifier.push_back(Get());
+          out.append(text.data(), text.size());
+          return true;
         }
-        SkipInlineSpaces();
-        if (Peek() == ':')
+        return WriteValue(value.value, out, 0, options, WriteContext::InObject);
+      }
+
+      const char* cursor = text.data();
+      auto writeChild = [&](const LosslessValue& child) {
+        const std::string_view childText = child.sourceText.view();
+        out.append(cursor, static_cast<std::size_t>(childText.data() - cursor));
+        cursor = childText.data() + childText.size();
+        return WriteLosslessSpliced(child, out, options);
+      };
+      for (const LosslessValue& item : value.arrayItems)
+      {
+        if (!writeChild(item))
         {
-          mPos -= identifier.size();
-          mCol -= identifier.size();
-          Object object;
-          ErrorCode errorCode = ParseIndentedObjectBodyLossless(object, out, currentIndent);
-          if (errorCode != ErrorCode::OK)
+          return false;
+        }
+      }
+      for (const auto& item : value.objectItems)
+      {
+        if (!writeChild(item.second))
+        {
+          return false;
+        }
+      }
+      out.append(cursor, static_cast<std::size_t>(text.data() + text.size() - cursor));
+      return true;
+    }
+
+    // Whole-document lossless write, from source where WriteOptions::keepSourceText allows it (which also keeps a
+    // leading BOM of the source)
+    template <typename Out>
+    bool WriteLosslessDocument(const LosslessValue& value, Out& out, const WriteOptions& options)
+    {
+      if (options.keepSourceText)
+      {
+        if (CanSpliceLossless(value, true))
+        {
+          return WriteLosslessSpliced(value, out, options);
+        }
+        if (value.sourceText.view().starts_with("\xEF\xBB\xBF"))
+        {
+          out.append("\xEF\xBB\xBF");
+        }
+      }
+      return WriteLosslessValue(value, out, 0, options, WriteContext::Root);
+    }
+  } // namespace detail
+
+  // Lossless counterpart of ToString (numbers are checked while writing, out is empty on failure)
+  inline bool ToStringLossless(const LosslessValue& value, std::string& out, const WriteOptions& options = {}, Error* error = nullptr)
+  {
+    out.clear();
+    if (!detail::WriteLosslessDocument(value, out, options))
+    {
+      out.clear();
+      return detail::FailNonFinite(error);
+    }
+    if (error)
+    {
+      *error = {};
+    }
+    return true;
+  }
+
+  inline std::string ToStringLossless(const LosslessValue& value, const WriteOptions& options = {})
+  {
+    std::string result;
+    Error error;
+    if (!ToStringLossless(value, result, options, &error))
+    {
+      return {};
+    }
+    return result;
+  }
+
+  // Lossless counterpart of Write; like it, a NaN / infinity is only found once the part before it reached the sink
+  inline bool WriteLossless(const LosslessValue& value, Sink& sink, const WriteOptions& options = {}, Error* error = nullptr)
+  {
+    if (!detail::WriteLosslessDocument(value, sink, options))
+    {
+      return detail::FailNonFinite(error);
+    }
+    if (!sink.Flush())
+    {
+      if (error)
+      {
+        error->code = ErrorCode::InternalError;
+        error->where = {};
+        error->message = "Failed to write output";
+      }
+      return false;
+    }
+    if (error)
+    {
+      *error = {};
+    }
+    return true;
+  }
+
+  // Write value to path through a FileSink. The file is opened (and truncated) first, so it may be left incomplete
+  // when writing fails, e.g. on a NaN / infinity.
+  inline bool WriteFile(const std::string& path, const Value& value, const WriteOptions& options = {}, Error* error = nullptr)
+  {
+    auto fileStream = OpenFileUTF8(path, "wb");
+    if (!fileStream)
+    {
+      if (error)
+      {
+        error->code = ErrorCode::InternalError;
+        error->where = {};
+        error->message = "Failed to open file for writing";
+      }
+      return false;
+    }
+    // Stream through a bounded buffer instead of formatting the whole document first
+    FileSink sink(fileStream.get());
+    if (!Write(value, sink, options, error))
+    {
+      if (error && error->code == ErrorCode::InternalError)
+      {
+        error->message = "Failed to write file";
+      }
+      return false;
+    }
+    return true;
+  }
+
+  inline bool
+  WriteFileLossless(const std::string& path, const LosslessValue& value, const WriteOptions& options = {}, Error* error = nullptr)
+  {
+    auto fileStream = OpenFileUTF8(path, "wb");
+    if (!fileStream)
+    {
+      if (error)
+      {
+        error->code = ErrorCode::InternalError;
+        error->where = {};
+        error->message = "Failed to open file for writing";
+      }
+      return false;
+    }
+    // Stream through a bounded buffer instead of formatting the whole document first
+    FileSink sink(fileStream.get());
+    if (!WriteLossless(value, sink, options, error))
+    {
+      if (error && error->code == ErrorCode::InternalError)
+      {
+        error->message = "Failed to write file";
+      }
+      return false;
+    }
+    return true;
+  }
+
+  namespace detail
+  {
+    // Line break before a member / element / closing bracket of pretty-printed JSON; nothing when compact
+    template <typename Out>
+    void WriteJsonBreak(Out& out, int indentLevel, const WriteOptions& options)
+    {
+      if (options.indentWidth > 0)
+      {
+        out.push_back('\n');
+        WriteIndent(out, indentLevel, options.indentWidth);
+      }
+    }
+
+    // JSON writer. Numbers are checked while they are written, so a non-finite one stops the write with whatever was
+    // already appended to out. indentWidth 0 writes everything on one line.
+    template <typename Out>
+    bool WriteJsonValue(const Value& value, Out& out, int indentLevel, const WriteOptions& options, Error* error)
+    {
+      if (std::holds_alternative<std::nullptr_t>(value))
+      {
+        out += "null";
+      }
+      else if (std::holds_alternative<bool>(value))
+      {
+        out += (std::get<bool>(value) ? "true" : "false");
+      }
+      else if (std::holds_alternative<double>(value))
+      {
+        const double number = std::get<double>(value);
+        if (!std::isfinite(number))
+        {
+          return FailNonFinite(error);
+        }
+        AppendNumber(number, out, options.compactIntegers);
+      }
+      else if (std::holds_alternative<std::string>(value))
+      {
+        WriteStringQuoted(std::get<std::string>(value), out);
+      }
+      else if (std::holds_alternative<Array>(value))
+      {
+        const Array& array = std::get<Array>(value);
+        out.push_back('[');
+        for (std::size_t index = 0; index < array.size(); ++index)
+        {
+          if (index > 0)
           {
-            return errorCode;
+            out.push_back(',');
+          }
+          WriteJsonBreak(out, indentLevel + 1, options);
+          if (!WriteJsonValue(array[index], out, indentLevel + 1, options, error))
+          {
+            return false;
           }
-          out.value = std::move(object);
-          return ErrorCode::OK;
         }
-
-        if (identifier == "true")
+        if (!array.empty())
         {
-          out.value = true;
-          return ErrorCode::OK;
+          WriteJsonBreak(out, indentLevel, options);
         }
-        if (identifier == "false")
+        out.push_back(']');
+      }
+      else
+      {
+        const Object& object = std::get<Object>(value);
+        out.push_back('{');
+        bool first = true;
+        bool ok = true;
+        ForEachObjectItem(object, options.sortObjectKeys, [&](std::string_view key, const Value& member) {
+          if (!ok)
+          {
+            return;
+          }
+          if (!first)
+          {
+            out.push_back(',');
+          }
+          first = false;
+          WriteJsonBreak(out, indentLevel + 1, options);
+          WriteStringQuoted(key, out);
+          out += options.indentWidth > 0 ? ": " : ":";
+          ok = WriteJsonValue(member, out, indentLevel + 1, options, error);
+        });
+        if (!ok)
         {
-          out.value = false;
-          return ErrorCode::OK;
+          return false;
         }
-        if (identifier == "null")
+        if (!object.empty())
         {
-          out.value = nullptr;
-          return ErrorCode::OK;
+          WriteJsonBreak(out, indentLevel, options);
         }
-        out.value = identifier;
-        return ErrorCode::OK;
+        out.push_back('}');
       }
+      return true;
+    }
+  } // namespace detail
+
+  // JSON text of value, pretty-printed with options.indentWidth spaces per level (0 for a single line, which is what
+  // the overloads without options write). out is cleared on failure (non-finite number).
+  inline bool ToJsonString(const Value& value, std::string& out, const WriteOptions& options, Error* error = nullptr)
+  {
+    out.clear();
+    if (!detail::WriteJsonValue(value, out, 0, options, error))
+    {
+      out.clear();
+      return false;
+    }
+    if (error)
+    {
+      *error = {};
+    }
+    return true;
+  }
+
+  inline std::string ToJsonString(const Value& value, const WriteOptions& options)
+  {
+    std::string result;
+    Error error;
+    ToJsonString(value, result, options, &error);
+    return result;
+  }
+
+  namespace detail
+  {
+    // Layout of JSON written without options: compact on one line, integral numbers keep their ".0"
+    inline WriteOptions CompactJsonOptions()
+    {
+      WriteOptions compact;
+      compact.indentWidth = 0;
+      return compact;
+    }
+  } // namespace detail
+
+  inline bool ToJsonString(const Value& value, std::string& out, Error* error = nullptr)
+  {
+    return ToJsonString(value, out, detail::CompactJsonOptions(), error);
+  }
+
+  inline std::string ToJsonString(const Value& value)
+  {
+    std::string result;
+    Error error;
+    ToJsonString(value, result, &error);
+    return result;
+  }
 
-      ErrorCode ParseIndentedObjectBodyLossless(Object& obj, LosslessValue& outWrapper, int parentIndent)
+  // Stream value to sink as JSON (see ToJsonString) and flush it. A non-finite number is only found when the writer
+  // reaches it, so the sink may already have received the part of the document before it.
+  inline bool WriteJson(const Value& value, Sink& sink, const WriteOptions& options, Error* error = nullptr)
+  {
+    if (!detail::WriteJsonValue(value, sink, 0, options, error))
+    {
+      return false;
+    }
+    if (!sink.Flush())
+    {
+      if (error)
       {
-        int bodyIndent = -1;
+        error->code = ErrorCode::InternalError;
+        error->where = {};
+        error->message = "Failed to write output";
+      }
+      return false;
+    }
+    if (error)
+    {
+      *error = {};
+    }
+    return true;
+  }
+  inline bool WriteJson(const Value& value, Sink& sink, Error* error = nullptr)
+  {
+    return WriteJson(value, sink, detail::CompactJsonOptions(), error);
+  }
 
-        while (true)
-        {
-          if (bodyIndent == -1)
-          {
-            bodyIndent = mIndentStack.back();
-          }
 
-          SkipInlineSpaces();
-          if (EndOfFile())
-          {
-            break;
-          }
+  // Reusable formatter: the output buffer keeps its capacity between calls, so formatting many small documents in a
+  // loop doesn't allocate once the buffer has grown to the largest one. Output() is replaced by every call. JSON uses
+  // Options() like every other format, so construct it with indentWidth 0 for compact JSON.
+  class Writer
+  {
+  public:
+    explicit Writer(const WriteOptions& options = {}) : mOptions(options)
+    {}
 
-          if (Peek() == '#' || Peek() == '\r' || Peek() == '\n')
-          {
-            bool hasLine = false;
-            ErrorCode errorCode = NextContentLineLossless(hasLine, mPendingComments);
-            if (errorCode != ErrorCode::OK)
-            {
-              return errorCode;
-            }
-            if (!hasLine)
-            {
-              break;
-            }
-            if (mIndentStack.back() < bodyIndent)
-            {
-              break;
-            }
-            continue;
-          }
+    bool ToString(const Value& value, Error* error = nullptr)
+    {
+      return havCSON::ToString(value, mOutput, mOptions, error);
+    }
 
-          char c = Peek();
-          if (!IsIdentifierStart(c) && c != '"' && c != '\'')
-          {
-            break;
-          }
+    bool ToStringLossless(const LosslessValue& value, Error* error = nullptr)
+    {
+      return havCSON::ToStringLossless(value, mOutput, mOptions, error);
+    }
 
-          // Comments collected before this key belong to this entry
-          std::vector<LosslessComment> preKeyComments;
-          if (!mPendingComments.empty())
-          {
-            preKeyComments.swap(mPendingComments);
-          }
+    bool ToJsonString(const Value& value, Error* error = nullptr)
+    {
+      return havCSON::ToJsonString(value, mOutput, mOptions, error);
+    }
 
-          std::string key;
-          ErrorCode errorCode = ParseKey(key);
-          if (errorCode != ErrorCode::OK)
-          {
-            return errorCode;
-          }
+    const std::string& Output() const
+    {
+      return mOutput;
+    }
 
-          SkipInlineSpaces();
-          if (!Match(':'))
-          {
-            return Finish(ErrorCode::UnexpectedChar, nullptr, "Expected ':' in object pair");
-          }
-          SkipInlineSpaces();
+    WriteOptions& Options()
+    {
+      return mOptions;
+    }
 
-          bool blockValue = false;
-          if (Peek() == '#')
-          {
-            blockValue = true;
-          }
-          else if (Peek() == '\r' || Peek() == '\n')
-          {
-            blockValue = true;
-          }
+  private:
+    WriteOptions mOptions;
+    std::string mOutput;
+  };
 
-          if (blockValue)
-          {
-            if (Peek() == '#')
-            {
-              SkipToEOL();
-            }
-            else
-            {
-              char c2 = Get();
-              if (c2 == '\r' && Peek() == '\n')
-              {
-                Get();
-              }
-            }
+  // Binary snapshots
+  //
+  // Compact little-endian encoding of a Value for caching parsed documents. A snapshot is a 32 byte header (magic "HCSB",
+  // uint32 version, then the SnapshotStamp of the source) followed by the root value. Each value is a tag byte and:
+  //   number: float64        string: uint32 length, bytes
+  //   array:  uint32 count, uint64 content bytes, elements
+  //   object: uint32 count, uint64 content bytes, count x (uint32 key length, key bytes, value)
+  // Containers carry their size so a reader can skip over them, which lets SnapshotView read a snapshot in place
+  // (e.g. from a MappedFileUTF8) without building a tree. Multi-byte fields are unaligned and read with memcpy.
+
+  // Identifies the source a snapshot was made from (all zero when there is none)
+  struct SnapshotStamp
+  {
+    std::uint64_t sourceSize = 0;
+    std::int64_t sourceTime = 0; // Last modification time as reported by StatFileUTF8
+    std::uint64_t sourceHash = 0; // HashSnapshotSource of the source text
+  };
 
-            bool hasLine = false;
-            ErrorCode errorCode2 = NextContentLineLossless(hasLine, mPendingComments);
-            if (errorCode2 != ErrorCode::OK)
-            {
-              return errorCode2;
-            }
-            if (!hasLine)
-            {
-              return Finish(ErrorCode::InconsistentIndent, nullptr, "Expected indented block after ':'");
-            }
+  // 64-bit FNV-1a of a snapshot's source text
+  inline std::uint64_t HashSnapshotSource(std::string_view text)
+  {
+    std::uint64_t hash = 0xCBF29CE484222325ull;
+    for (char c : text)
+    {
+      hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001B3ull;
+    }
+    return hash;
+  }
 
-            if (mIndentStack.back() <= bodyIndent)
-            {
-              return Finish(ErrorCode::InconsistentIndent, nullptr, "Expected deeper indentation for block value");
-            }
+  namespace detail
+  {
+    enum class SnapshotTag : std::uint8_t
+    {
+      Null,
+      False,
+      True,
+      Number,
+      String,
+      Array,
+      Object,
+    };
 
-            LosslessValue child;
-            if (!preKeyComments.empty())
-            {
-              child.leadingComments.insert(child.leadingComments.end(), preKeyComments.begin(), preKeyComments.end());
-              preKeyComments.clear();
-            }
-            errorCode2 = ParseValueLossless(child, mIndentStack.back(), false);
-            if (errorCode2 != ErrorCode::OK)
-            {
-              return errorCode2;
-            }
+    inline constexpr char kSnapshotMagic[4] = {'H', 'C', 'S', 'B'};
+    inline constexpr std::uint32_t kSnapshotVersion = 1;
+    inline constexpr std::size_t kSnapshotHeaderSize = 32;
+    inline constexpr std::size_t kSnapshotStampOffset = 8;
 
-            outWrapper.objectItems.emplace_back(key, child);
-            obj.emplace(std::move(key), child.value);
+    template <typename T>
+    void PutLittleEndian(std::string& out, T value)
+    {
+      if constexpr (std::endian::native == std::endian::big)
+      {
+        value = std::byteswap(value);
+      }
+      char bytes[sizeof(T)];
+      std::memcpy(bytes, &value, sizeof(T));
+      out.append(bytes, sizeof(T));
+    }
 
-            // After parsing block value, check if we need to advance to next line
-            SkipInlineSpaces();
-            if (Peek() == '#')
-            {
-              SkipToEOL();
-            }
-            if (Peek() == '\r' || Peek() == '\n')
-            {
-              char c2 = Get();
-              if (c2 == '\r' && Peek() == '\n')
-              {
-                Get();
-              }
+    template <typename T>
+    T GetLittleEndian(const char* data)
+    {
+      T value;
+      std::memcpy(&value, data, sizeof(T));
+      if constexpr (std::endian::native == std::endian::big)
+      {
+        value = std::byteswap(value);
+      }
+      return value;
+    }
 
-              bool hasLine = false;
-              ErrorCode ec3 = NextContentLineLossless(hasLine, mPendingComments);
-              if (ec3 != ErrorCode::OK)
-              {
-                return ec3;
-              }
-              if (!hasLine)
-              {
-                break;
-              }
-            }
+    inline void PutSnapshotStamp(std::string& out, const SnapshotStamp& stamp)
+    {
+      PutLittleEndian(out, stamp.sourceSize);
+      PutLittleEndian(out, static_cast<std::uint64_t>(stamp.sourceTime));
+      PutLittleEndian(out, stamp.sourceHash);
+    }
 
-            if (mIndentStack.back() < bodyIndent)
-            {
-              break;
-            }
-            continue;
-          }
+    inline bool PutSnapshotString(std::string& out, std::string_view text)
+    {
+      if (text.size() > UINT32_MAX)
+      {
+        return false;
+      }
+      PutLittleEndian(out, static_cast<std::uint32_t>(text.size()));
+      out.append(text);
+      return true;
+    }
 
-          LosslessValue child;
-          if (!preKeyComments.empty())
+    inline bool PutSnapshotValue(std::string& out, const Value& value)
+    {
+      if (value.isNull())
+      {
+        out.push_back(static_cast<char>(SnapshotTag::Null));
+      }
+      else if (value.isBool())
+      {
+        out.push_back(static_cast<char>(std::get<bool>(value) ? SnapshotTag::True : SnapshotTag::False));
+      }
+      else if (value.isNumber())
+      {
+        out.push_back(static_cast<char>(SnapshotTag::Number));
+        PutLittleEndian(out, std::bit_cast<std::uint64_t>(std::get<double>(value)));
+      }
+      else if (value.isString())
+      {
+        out.push_back(static_cast<char>(SnapshotTag::String));
+        return PutSnapshotString(out, std::get<std::string>(value));
+      }
+      else
+      {
+        const bool isArray = value.isArray();
+        const std::size_t count = isArray ? value.asArray().size() : value.asObject().size();
+        if (count > UINT32_MAX)
+        {
+          return false;
+        }
+        out.push_back(static_cast<char>(isArray ? SnapshotTag::Array : SnapshotTag::Object));
+        PutLittleEndian(out, static_cast<std::uint32_t>(count));
+        const std::size_t sizeAt = out.size();
+        PutLittleEndian(out, std::uint64_t{0});
+        if (isArray)
+        {
+          for (const Value& element : value.asArray())
           {
-            child.leadingComments.insert(child.leadingComments.end(), preKeyComments.begin(), preKeyComments.end());
-            preKeyComments.clear();
+            if (!PutSnapshotValue(out, element))
+            {
+              return false;
+            }
           }
-          errorCode = ParseValueLossless(child, parentIndent);
-          if (errorCode != ErrorCode::OK)
+        }
+        else
+        {
+          for (const auto& [key, member] : value.asObject())
           {
-            return errorCode;
+            if (!PutSnapshotString(out, key) || !PutSnapshotValue(out, member))
+            {
+              return false;
+            }
           }
-          outWrapper.objectItems.emplace_back(key, child);
-          obj.emplace(std::move(key), child.value);
+        }
+        // Patch in the content size now that it is known
+        std::string size;
+        PutLittleEndian(size, static_cast<std::uint64_t>(out.size() - sizeAt - sizeof(std::uint64_t)));
+        out.replace(sizeAt, size.size(), size);
+      }
+      return true;
+    }
 
-          SkipInlineSpaces();
-          if (Peek() == '#')
+    // Check that data[position, end) holds exactly one well-formed value. Iterative, so corrupt input can't exhaust
+    // the stack: each open container remembers where its content must end and how many entries are still due.
+    inline bool ValidateSnapshotValue(std::string_view data, std::size_t position)
+    {
+      struct Open
+      {
+        std::size_t end;
+        std::uint32_t remaining;
+        bool isObject;
+      };
+      std::vector<Open> open;
+      std::size_t end = data.size();
+
+      auto has = [&](std::size_t bytes) { return bytes <= end - position; };
+      auto string = [&]() {
+        if (!has(sizeof(std::uint32_t)))
+        {
+          return false;
+        }
+        std::size_t length = GetLittleEndian<std::uint32_t>(data.data() + position);
+        position += sizeof(std::uint32_t);
+        if (!has(length))
+        {
+          return false;
+        }
+        position += length;
+        return true;
+      };
+
+      while (true)
+      {
+        if (!open.empty())
+        {
+          if (open.back().remaining == 0)
           {
-            // If comment starts at current indent, treat as leading comment for next key
-            if (mCol <= bodyIndent + 1)
+            if (position != open.back().end)
             {
-              std::string line;
-              Get();
-              line.push_back('#');
-              while (!EndOfFile())
-              {
-                char ch = Peek();
-                if (ch == '\r' || ch == '\n')
-                {
-                  break;
-                }
-                line.push_back(Get());
-              }
-              LosslessComment losslessComment;
-              losslessComment.indent = static_cast<int>(mCol) - 1;
-              if (losslessComment.indent < 0)
-              {
-                losslessComment.indent = 0;
-              }
-              losslessComment.text = std::move(line);
-              mPendingComments.push_back(std::move(losslessComment));
-              SkipToEOL();
-              bool hasLine = false;
-              ErrorCode errorCode2 = NextContentLineLossless(hasLine, mPendingComments);
-              if (errorCode2 != ErrorCode::OK)
-              {
-                return errorCode2;
-              }
-              if (!hasLine)
-              {
-                break;
-              }
-              if (mIndentStack.back() < bodyIndent)
-              {
-                break;
-              }
-              continue;
+              return false;
             }
-            else
+            open.pop_back();
+            if (open.empty())
             {
-              std::string comment;
-              Get();
-              while (!EndOfFile())
-              {
-                char ch = Peek();
-                if (ch == '\r' || ch == '\n')
-                {
-                  break;
-                }
-                comment.push_back(Get());
-              }
-              if (!outWrapper.objectItems.empty())
-              {
-                outWrapper.objectItems.back().second.inlineComment = comment;
-              }
-              SkipToEOL();
-              bool hasLine = false;
-              ErrorCode errorCode2 = NextContentLineLossless(hasLine, mPendingComments);
-              if (errorCode2 != ErrorCode::OK)
-              {
-                return errorCode2;
-              }
-              if (!hasLine)
-              {
-                break;
-              }
-              if (mIndentStack.back() < bodyIndent)
-              {
-                break;
-              }
-              continue;
+              return position == data.size();
             }
-          }
-          if (Match(','))
-          {
-            SkipInlineSpaces();
+            end = open.back().end;
             continue;
           }
-          if (Peek() == '\r' || Peek() == '\n')
+          --open.back().remaining;
+          if (open.back().isObject && !string())
           {
-            char c2 = Get();
-            if (c2 == '\r' && Peek() == '\n')
+            return false;
+          }
+        }
+
+        if (!has(1))
+        {
+          return false;
+        }
+        const auto tag = static_cast<SnapshotTag>(data[position++]);
+        switch (tag)
+        {
+          case SnapshotTag::Null:
+          case SnapshotTag::False:
+          case SnapshotTag::True: break;
+          case SnapshotTag::Number:
+            if (!has(sizeof(double)))
             {
-              Get();
+              return false;
             }
-
-            bool hasLine = false;
-            ErrorCode errorCode2 = NextContentLineLossless(hasLine, mPendingComments);
-            if (errorCode2 != ErrorCode::OK)
+            position += sizeof(double);
+            break;
+          case SnapshotTag::String:
+            if (!string())
             {
-              return errorCode2;
+              return false;
             }
-            if (!hasLine)
+            break;
+          case SnapshotTag::Array:
+          case SnapshotTag::Object:
+          {
+            if (!has(sizeof(std::uint32_t) + sizeof(std::uint64_t)))
             {
-              break;
+              return false;
             }
-            if (mIndentStack.back() < bodyIndent)
+            const std::uint32_t count = GetLittleEndian<std::uint32_t>(data.data() + position);
+            const std::uint64_t size = GetLittleEndian<std::uint64_t>(data.data() + position + sizeof(std::uint32_t));
+            position += sizeof(std::uint32_t) + sizeof(std::uint64_t);
+            if (size > end - position)
             {
-              break;
+              return false;
             }
+            end = position + static_cast<std::size_t>(size);
+            open.push_back(Open{end, count, tag == SnapshotTag::Object});
             continue;
           }
-          break;
+          default: return false;
+        }
+        if (open.empty())
+        {
+          return position == data.size();
         }
-
-        return ErrorCode::OK;
       }
-    };
+    }
   } // namespace detail
 
-  inline ErrorCode ParseLossless(std::string_view src, LosslessValue& out, Error* error = nullptr)
-  {
-    detail::LosslessParser losslessParser(src);
-    return losslessParser.Parse(out, error);
-  }
-
-  inline ErrorCode ParseFile(const std::string& path, Value& out, Error* error = nullptr)
+  // Serialize value into a binary snapshot (see above); false if a string or container exceeds 2^32 - 1 bytes / items
+  inline bool ToSnapshot(const Value& value, std::string& out, const SnapshotStamp& stamp = {}, Error* error = nullptr)
   {
-    auto fileStream = OpenFileUTF8(path, "rb");
-    if (!fileStream)
+    out.clear();
+    out.append(detail::kSnapshotMagic, sizeof(detail::kSnapshotMagic));
+    detail::PutLittleEndian(out, detail::kSnapshotVersion);
+    detail::PutSnapshotStamp(out, stamp);
+    if (!detail::PutSnapshotValue(out, value))
     {
+      out.clear();
       if (error)
       {
         error->code = ErrorCode::InternalError;
         error->where = {};
-        error->message = "Failed to open file";
+        error->message = "Value too large for a snapshot";
       }
-      return ErrorCode::InternalError;
+      return false;
     }
-    if (std::fseek(fileStream.get(), 0, SEEK_END) != 0)
+    if (error)
     {
-      if (error)
+      *error = {};
+    }
+    return true;
+  }
+
+  // One value inside a snapshot buffer. Only valid while the buffer is (a SnapshotView checked it on Open, so access is
+  // unchecked). Indexed access and find step over the preceding entries.
+  class SnapshotNode
+  {
+  public:
+    bool isNull() const
+    {
+      return Tag() == detail::SnapshotTag::Null;
+    }
+
+    bool isBool() const
+    {
+      return Tag() == detail::SnapshotTag::False || Tag() == detail::SnapshotTag::True;
+    }
+
+    bool isNumber() const
+    {
+      return Tag() == detail::SnapshotTag::Number;
+    }
+
+    bool isString() const
+    {
+      return Tag() == detail::SnapshotTag::String;
+    }
+
+    bool isArray() const
+    {
+      return Tag() == detail::SnapshotTag::Array;
+    }
+
+    bool isObject() const
+    {
+      return Tag() == detail::SnapshotTag::Object;
+    }
+
+    bool asBool() const
+    {
+      return Tag() == detail::SnapshotTag::True;
+    }
+
+    double asNumber() const
+    {
+      return std::bit_cast<double>(detail::GetLittleEndian<std::uint64_t>(mData + 1));
+    }
+
+    // Views the snapshot buffer
+    std::string_view asString() const
+    {
+      return String(mData + 1);
+    }
+
+    // Elements / members of a container
+    std::size_t size() const
+    {
+      return detail::GetLittleEndian<std::uint32_t>(mData + 1);
+    }
+
+    // Element of an array / value of the index-th member of an object
+    SnapshotNode operator[](std::size_t index) const
+    {
+      const char* entry = Entry(index);
+      return SnapshotNode(isObject() ? entry + kLengthSize + String(entry).size() : entry);
+    }
+
+    // Key of the index-th member of an object
+    std::string_view key(std::size_t index) const
+    {
+      return String(Entry(index));
+    }
+
+    // Value of the first member named key
+    std::optional<SnapshotNode> find(std::string_view key) const
+    {
+      const char* entry = mData + kContainerHeaderSize;
+      for (std::size_t index = 0, count = size(); index < count; ++index)
       {
-        error->code = ErrorCode::InternalError;
-        error->where = {};
-        error->message = "Failed to read file";
+        const std::string_view name = String(entry);
+        const SnapshotNode value(entry + kLengthSize + name.size());
+        if (name == key)
+        {
+          return value;
+        }
+        entry = value.End();
       }
-      return ErrorCode::InternalError;
+      return std::nullopt;
     }
-    long size = std::ftell(fileStream.get());
-    if (size < 0 || std::fseek(fileStream.get(), 0, SEEK_SET) != 0)
+
+    Value ToValue() const
     {
-      if (error)
+      switch (Tag())
       {
-        error->code = ErrorCode::InternalError;
-        error->where = {};
-        error->message = "Failed to read file";
+        case detail::SnapshotTag::False: return false;
+        case detail::SnapshotTag::True: return true;
+        case detail::SnapshotTag::Number: return asNumber();
+        case detail::SnapshotTag::String: return std::string(asString());
+        case detail::SnapshotTag::Array:
+        {
+          Array array;
+          array.reserve(size());
+          for (const char* entry = mData + kContainerHeaderSize, *end = End(); entry != end;)
+          {
+            const SnapshotNode element(entry);
+            array.push_back(element.ToValue());
+            entry = element.End();
+          }
+          return array;
+        }
+        case detail::SnapshotTag::Object:
+        {
+          Object object;
+          object.reserve(size());
+          for (const char* entry = mData + kContainerHeaderSize, *end = End(); entry != end;)
+          {
+            const std::string_view name = String(entry);
+            const SnapshotNode member(entry + kLengthSize + name.size());
+            if (!object.contains(name))
+            {
+              object.try_emplace(std::string(name), member.ToValue());
+            }
+            entry = member.End();
+          }
+          return object;
+        }
+        default: return nullptr;
       }
-      return ErrorCode::InternalError;
     }
-    std::string data(static_cast<std::size_t>(size), '\0');
-    if (!data.empty())
+
+  private:
+    friend class SnapshotView;
+
+    static constexpr std::size_t kLengthSize = sizeof(std::uint32_t);
+    static constexpr std::size_t kContainerHeaderSize = 1 + sizeof(std::uint32_t) + sizeof(std::uint64_t);
+
+    const char* mData; // Tag byte
+
+    explicit SnapshotNode(const char* data) : mData(data)
+    {}
+
+    detail::SnapshotTag Tag() const
+    {
+      return static_cast<detail::SnapshotTag>(*mData);
+    }
+
+    static std::string_view String(const char* data)
+    {
+      return std::string_view(data + kLengthSize, detail::GetLittleEndian<std::uint32_t>(data));
+    }
+
+    // One past the encoded value
+    const char* End() const
+    {
+      switch (Tag())
+      {
+        case detail::SnapshotTag::Number: return mData + 1 + sizeof(double);
+        case detail::SnapshotTag::String: return mData + 1 + kLengthSize + asString().size();
+        case detail::SnapshotTag::Array:
+        case detail::SnapshotTag::Object:
+          return mData + kContainerHeaderSize + detail::GetLittleEndian<std::uint64_t>(mData + 1 + kLengthSize);
+        default: return mData + 1;
+      }
+    }
+
+    const char* Entry(std::size_t index) const
+    {
+      const char* entry = mData + kContainerHeaderSize;
+      for (; index > 0; --index)
+      {
+        entry = isObject() ? SnapshotNode(entry + kLengthSize + String(entry).size()).End() : SnapshotNode(entry).End();
+      }
+      return entry;
+    }
+  };
+
+  // Read-only access to a snapshot in place. Open checks the header and the structure of the whole buffer once; the
+  // buffer (e.g. MappedFileUTF8::View()) must outlive the view and its nodes.
+  class SnapshotView
+  {
+  public:
+    ErrorCode Open(std::string_view data, Error* error = nullptr)
     {
-      if (std::fread(&data[0], 1, static_cast<std::size_t>(size), fileStream.get()) != static_cast<std::size_t>(size))
+      mData = {};
+      mStamp = {};
+      const std::string_view magic(detail::kSnapshotMagic, sizeof(detail::kSnapshotMagic));
+      if (data.size() <= detail::kSnapshotHeaderSize || data.substr(0, magic.size()) != magic ||
+        detail::GetLittleEndian<std::uint32_t>(data.data() + sizeof(detail::kSnapshotMagic)) != detail::kSnapshotVersion ||
+        !detail::ValidateSnapshotValue(data, detail::kSnapshotHeaderSize))
       {
         if (error)
         {
-          error->code = ErrorCode::InternalError;
+          error->code = ErrorCode::InvalidSnapshot;
           error->where = {};
-          error->message = "Failed to read file";
+          error->message = "Invalid snapshot";
         }
-        return ErrorCode::InternalError;
+        return ErrorCode::InvalidSnapshot;
+      }
+      const char* stamp = data.data() + detail::kSnapshotStampOffset;
+      mStamp.sourceSize = detail::GetLittleEndian<std::uint64_t>(stamp);
+      mStamp.sourceTime = static_cast<std::int64_t>(detail::GetLittleEndian<std::uint64_t>(stamp + 8));
+      mStamp.sourceHash = detail::GetLittleEndian<std::uint64_t>(stamp + 16);
+      mData = data;
+      if (error)
+      {
+        *error = {};
       }
+      return ErrorCode::OK;
+    }
+
+    bool IsOpen() const
+    {
+      return !mData.empty();
+    }
+
+    // Root value; only call while IsOpen()
+    SnapshotNode Root() const
+    {
+      return SnapshotNode(mData.data() + detail::kSnapshotHeaderSize);
     }
-    return Parse(std::string_view(data), out, error);
-  }
 
-  // Exception type and throwing wrappers
-  struct ParseException : std::exception
-  {
-    Error error;
-    explicit ParseException(Error e) : error(std::move(e))
-    {}
-    const char* what() const noexcept override
+    const SnapshotStamp& Stamp() const
     {
-      return error.message.c_str();
+      return mStamp;
     }
+
+  private:
+    std::string_view mData;
+    SnapshotStamp mStamp;
   };
 
-  inline Value ParseOrThrow(std::string_view src)
+  // Decode a snapshot made by ToSnapshot into out (unchanged on failure); stamp, if given, receives its source stamp
+  inline ErrorCode ParseSnapshot(std::string_view data, Value& out, Error* error = nullptr, SnapshotStamp* stamp = nullptr)
   {
-    Value value;
-    Error error;
-    ErrorCode errorCode = Parse(src, value, &error);
+    SnapshotView view;
+    ErrorCode errorCode = view.Open(data, error);
     if (errorCode != ErrorCode::OK)
     {
-      throw ParseException(error);
+      return errorCode;
     }
-    return value;
-  }
-
-  inline Value ParseFileOrThrow(const std::string& path)
-  {
-    Value value;
-    Error error;
-    ErrorCode errorCode = ParseFile(path, value, &error);
-    if (errorCode != ErrorCode::OK)
+    out = view.Root().ToValue();
+    if (stamp)
     {
-      throw ParseException(error);
+      *stamp = view.Stamp();
     }
-    return value;
+    return ErrorCode::OK;
   }
 
-  struct WriteOptions
-  {
-    int indentWidth = 2; // Spaces per indent level
-    bool sortObjectKeys = false;
-  };
-
-  namespace detail
+  // Parse a CSON file, using the snapshot at cachePath when it was made from the same source: it is loaded without
+  // reading the source if size and modification time match, or after hashing the source otherwise (the snapshot's
+  // stamp is then refreshed). Otherwise the text is parsed and the snapshot rewritten (via a temporary
+  // file and rename). Problems with the cache only ever fall back to parsing; errors are those of ParseFile.
+  inline ErrorCode ParseFileCached(const std::string& path, const std::string& cachePath, Value& out, Error* error = nullptr)
   {
-    inline void WriteIndent(std::string& out, int level, int width)
+    SnapshotStamp current;
+    if (!StatFileUTF8(path, current.sourceSize, current.sourceTime))
     {
-      out.append(static_cast<std::size_t>(level * width), ' ');
+      return ParseFile(path, out, error);
     }
 
-    enum class WriteContext : std::uint8_t
+    std::optional<MappedFileUTF8> cacheMapping;
+    std::string cacheBuffer;
+    std::string_view cache;
+    SnapshotView snapshot;
+    std::uint64_t cacheSize = 0;
+    std::int64_t cacheTime = 0;
+    if (
+      StatFileUTF8(cachePath, cacheSize, cacheTime) &&
+      detail::LoadFileUTF8(cachePath, cacheMapping, cacheBuffer, cache, nullptr) == ErrorCode::OK)
     {
-      Root,
-      InObject,
-      InArray,
-    };
-
-    inline void WriteValue(const Value& value, std::string& out, int indentLevel, const WriteOptions& opt, WriteContext ctx);
-
-    using ObjectItemView = std::pair<std::string_view, const Value*>;
-
-    inline std::vector<ObjectItemView> OrderedObjectItems(const Object& object, bool sortKeys)
+      snapshot.Open(cache);
+    }
+    // Like git's racily clean entries: a source written in the same timestamp tick as the snapshot may have changed
+    // again without changing its time, so the time only counts if the snapshot was written later
+    if (
+      snapshot.IsOpen() && snapshot.Stamp().sourceSize == current.sourceSize && snapshot.Stamp().sourceTime == current.sourceTime &&
+      cacheTime > current.sourceTime)
     {
-      std::vector<ObjectItemView> items;
-      items.reserve(object.size());
-      for (const auto& keyValuePair : object)
-      {
-        items.emplace_back(keyValuePair.first, &keyValuePair.second);
-      }
-      if (sortKeys)
+      out = snapshot.Root().ToValue();
+      if (error)
       {
-        std::sort(items.begin(), items.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        *error = {};
       }
-      return items;
+      return ErrorCode::OK;
     }
 
-    using LosslessItemView = std::pair<std::string_view, const LosslessValue*>;
+    std::optional<MappedFileUTF8> mapping;
+    std::string buffer;
+    std::string_view contents;
+    ErrorCode errorCode = detail::LoadFileUTF8(path, mapping, buffer, contents, error);
+    if (errorCode != ErrorCode::OK)
+    {
+      return errorCode;
+    }
+    current.sourceSize = contents.size();
+    current.sourceHash = HashSnapshotSource(contents);
 
-    inline std::vector<LosslessItemView>
-    OrderedLosslessItems(const std::vector<std::pair<std::string, LosslessValue>>& items, bool sortKeys)
+    if (snapshot.IsOpen() && snapshot.Stamp().sourceSize == current.sourceSize && snapshot.Stamp().sourceHash == current.sourceHash)
     {
-      std::vector<LosslessItemView> views;
-      views.reserve(items.size());
-      for (const auto& keyValuePair : items)
+      out = snapshot.Root().ToValue();
+      cacheMapping.reset();
+      if (auto cacheFile = OpenFileUTF8(cachePath, "r+b"))
       {
-        views.emplace_back(keyValuePair.first, &keyValuePair.second);
+        std::string stamp;
+        detail::PutSnapshotStamp(stamp, current);
+        if (std::fseek(cacheFile.get(), static_cast<long>(detail::kSnapshotStampOffset), SEEK_SET) == 0)
+        {
+          std::fwrite(stamp.data(), 1, stamp.size(), cacheFile.get());
+        }
       }
-      if (sortKeys)
+      if (error)
       {
-        std::sort(views.begin(), views.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        *error = {};
       }
-      return views;
+      return ErrorCode::OK;
     }
 
-    inline void WriteStringQuoted(std::string_view value, std::string& out)
+    Value value;
+    errorCode = Parse(contents, value, error);
+    if (errorCode != ErrorCode::OK)
     {
-      out.push_back('"');
-      for (char c : value)
-      {
-        switch (c)
-        {
-          case '"': out += "\\\""; break;
-          case '\\': out += "\\\\"; break;
-          case '\n': out += "\\n"; break;
-          case '\r': out += "\\r"; break;
-          case '\t': out += "\\t"; break;
-          default: out.push_back(c); break;
-        }
-      }
-      out.push_back('"');
+      return errorCode;
     }
 
-    inline std::string FormatNumber(double value)
+    std::string bytes;
+    if (ToSnapshot(value, bytes, current))
     {
-      std::string result = std::to_string(value);
-      const std::size_t dot = result.find('.');
-      if (dot == std::string::npos)
-      {
-        return result;
-      }
-      std::size_t trimEnd = result.size(); // Erase from here after trimming trailing zeros
-      while (trimEnd > dot + 1 && result[trimEnd - 1] == '0')
+      const std::string temporaryPath = cachePath + ".tmp";
+      bool written = false;
+      if (auto cacheFile = OpenFileUTF8(temporaryPath, "wb"))
       {
-        --trimEnd;
+        written = std::fwrite(bytes.data(), 1, bytes.size(), cacheFile.get()) == bytes.size();
+        written = std::fclose(cacheFile.release()) == 0 && written;
       }
-      if (trimEnd == dot + 1)
+      cacheMapping.reset();
+      if (!written || !ReplaceFileUTF8(temporaryPath, cachePath))
       {
-        result.erase(dot + 1);
-        result.push_back('0');
-        return result;
+        RemoveFileUTF8(temporaryPath);
       }
-      result.erase(trimEnd);
-      return result;
+    }
+    out = std::move(value);
+    return ErrorCode::OK;
+  }
+
+  // Struct binding: types described with HAVCSON_DESCRIBE (see the end of this header) are parsed straight into their
+  // members and written without building a Value. Members may be bool, arithmetic types, std::string, std::optional,
+  // std::vector and other described structs.
+  template <typename T>
+  concept Described = requires(const T* type) { HavCSONFields(type); }; // Found by ADL in the namespace of T
+
+  namespace detail
+  {
+    template <typename Class, typename MemberT>
+    struct Field
+    {
+      using Member = MemberT;
+
+      std::string_view name;
+      MemberT Class::*member;
+    };
+
+    template <typename Class, typename MemberT>
+    constexpr Field<Class, MemberT> MakeField(std::string_view name, MemberT Class::*member)
+    {
+      return {name, member};
     }
 
-    inline bool ValidateFiniteNumbers(const Value& value, Error* error)
+    template <typename T>
+    inline constexpr auto kFieldsOf = HavCSONFields(static_cast<const T*>(nullptr));
+
+    template <typename T>
+    inline constexpr std::size_t kFieldCount = std::tuple_size_v<std::remove_const_t<decltype(kFieldsOf<T>)>>;
+
+    // Field indices ordered by name, for WriteOptions::sortObjectKeys
+    template <typename T>
+    inline constexpr auto kSortedFieldOrder = [] {
+      std::array<std::size_t, kFieldCount<T>> order{};
+      std::array<std::string_view, kFieldCount<T>> names{};
+      std::apply(
+        [&](const auto&... field) {
+          std::size_t index = 0;
+          ((names[index] = field.name, order[index] = index, ++index), ...);
+        },
+        kFieldsOf<T>);
+      std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return names[a] < names[b]; });
+      return order;
+    }();
+
+    template <typename T>
+    struct IsOptional : std::false_type
+    {};
+
+    template <typename T>
+    struct IsOptional<std::optional<T>> : std::true_type
+    {};
+
+    template <typename T>
+    struct IsVector : std::false_type
+    {};
+
+    template <typename T, typename Allocator>
+    struct IsVector<std::vector<T, Allocator>> : std::true_type
+    {};
+
+    template <typename T>
+    constexpr bool IsBindable()
     {
-      if (std::holds_alternative<double>(value))
+      if constexpr (IsOptional<T>::value)
       {
-        if (!std::isfinite(std::get<double>(value)))
-        {
-          if (error)
-          {
-            error->code = ErrorCode::InvalidNumber;
-            error->where = {};
-            error->message = "Non-finite number value";
-          }
-          return false;
-        }
-        return true;
+        return IsBindable<typename T::value_type>();
       }
-      if (std::holds_alternative<Array>(value))
+      else if constexpr (IsVector<T>::value)
       {
-        for (const auto& child : std::get<Array>(value))
-        {
-          if (!ValidateFiniteNumbers(child, error))
-          {
-            return false;
-          }
-        }
-        return true;
+        return !std::is_same_v<typename T::value_type, bool> && IsBindable<typename T::value_type>();
       }
-      if (std::holds_alternative<Object>(value))
+      else
       {
-        for (const auto& entry : std::get<Object>(value))
-        {
-          if (!ValidateFiniteNumbers(entry.second, error))
-          {
-            return false;
-          }
-        }
-        return true;
+        return std::is_arithmetic_v<T> || std::is_same_v<T, std::string> || Described<T>;
       }
-      return true;
     }
 
-    inline bool ValidateFiniteNumbers(const LosslessValue& value, Error* error)
+    // Call fn(name, member) for field index of object (a runtime index into the compile-time field list)
+    template <typename T, typename Fn, std::size_t... I>
+    void VisitField(T& object, std::size_t index, Fn&& fn, std::index_sequence<I...>)
     {
-      if (std::holds_alternative<Array>(value.value) && !value.arrayItems.empty())
-      {
-        for (const auto& child : value.arrayItems)
-        {
-          if (!ValidateFiniteNumbers(child, error))
-          {
-            return false;
-          }
-        }
-        return true;
-      }
-      if (std::holds_alternative<Object>(value.value) && !value.objectItems.empty())
-      {
-        for (const auto& entry : value.objectItems)
-        {
-          if (!ValidateFiniteNumbers(entry.second, error))
-          {
-            return false;
-          }
-        }
-        return true;
-      }
-      return ValidateFiniteNumbers(value.value, error);
+      constexpr const auto& fields = kFieldsOf<std::remove_const_t<T>>;
+      ((index == I && (fn(std::get<I>(fields).name, object.*(std::get<I>(fields).member)), true)) || ...);
     }
 
-    // "Simple" scalars for inline arrays
-    inline bool IsSimpleScalar(const Value& value)
+    template <typename T, typename Fn>
+    void ForEachField(T& object, bool sortKeys, Fn&& fn)
     {
-      if (std::holds_alternative<std::nullptr_t>(value) || std::holds_alternative<bool>(value) || std::holds_alternative<double>(value))
+      using Type = std::remove_const_t<T>;
+      for (std::size_t index = 0; index < kFieldCount<Type>; ++index)
       {
-        return true;
-      }
-      if (std::holds_alternative<std::string>(value))
-      {
-        const auto& readonlyValue = std::get<std::string>(value);
-        // Single-line, reasonably short
-        return readonlyValue.find('\n') == std::string::npos && readonlyValue.size() <= 32;
+        VisitField(object, sortKeys ? kSortedFieldOrder<Type>[index] : index, fn, std::make_index_sequence<kFieldCount<Type>>{});
       }
-      return false; // Arrays / objects aren't "simple"
     }
 
-    inline bool CanInlineArray(const Array& array)
+    struct BindOps;
+
+    // A bound C++ object the next parse event fills in; a null target skips the value
+    struct BindSlot
     {
-      if (array.size() > 3)
-      {
-        return false;
-      }
-      for (const auto& value : array)
-      {
-        if (!IsSimpleScalar(value))
-        {
-          return false;
-        }
-      }
-      return true;
-    }
+      void* target = nullptr;
+      const BindOps* ops = nullptr;
+    };
 
-    // Forward declaration so inline writer can recurse on objects
-    inline void WriteObject(
-      const Object& object,
-      std::string& out,
-      int indentLevel,
-      const WriteOptions& options,
-      WriteContext ctx,
-      bool indentFirstLine);
+    // Type-erased event sink of one bound type. Scalar callbacks return false on a type mismatch; open* return the
+    // container slot to fill (null target on mismatch).
+    struct BindOps
+    {
+      bool (*onNull)(void* target);
+      bool (*onBool)(void* target, bool value);
+      bool (*onNumber)(void* target, double value, std::string_view literal);
+      bool (*onString)(void* target, std::string_view value);
+      BindSlot (*openArray)(void* target);
+      BindSlot (*element)(void* array);
+      BindSlot (*openObject)(void* target);
+      BindSlot (*member)(void* object, std::string_view key, std::uint64_t& seen);
+    };
 
-    // Inline writer used for array-context objects to avoid newlines
-    inline void WriteValueInline(const Value& value, std::string& out, const WriteOptions& options)
+    template <typename T>
+    struct Binder;
+
+    template <typename T>
+    inline constexpr BindOps kBindOps{
+      &Binder<T>::OnNull,
+      &Binder<T>::OnBool,
+      &Binder<T>::OnNumber,
+      &Binder<T>::OnString,
+      &Binder<T>::OpenArray,
+      &Binder<T>::Element,
+      &Binder<T>::OpenObject,
+      &Binder<T>::Member,
+    };
+
+    template <typename T>
+    struct Binder
     {
-      if (std::holds_alternative<std::nullptr_t>(value))
-      {
-        out += "null";
-      }
-      else if (std::holds_alternative<bool>(value))
-      {
-        out += (std::get<bool>(value) ? "true" : "false");
-      }
-      else if (std::holds_alternative<double>(value))
-      {
-        out += FormatNumber(std::get<double>(value));
-      }
-      else if (std::holds_alternative<std::string>(value))
+      static_assert(
+        IsBindable<T>(), "Bound members must be bool, arithmetic, std::string, std::optional, std::vector (not of bool) or described");
+
+      static T& Get(void* target)
       {
-        WriteStringQuoted(std::get<std::string>(value), out);
+        return *static_cast<T*>(target);
       }
-      else if (std::holds_alternative<Array>(value))
+
+      static bool OnNull(void* target)
       {
-        out.push_back('[');
-        std::size_t index = 0;
-        for (const auto& e : std::get<Array>(value))
+        if constexpr (IsOptional<T>::value)
         {
-          if (index++ > 0)
-          {
-            out += ", ";
-          }
-          WriteValueInline(e, out, options);
+          Get(target).reset();
+          return true;
         }
-        out.push_back(']');
+        return false;
       }
-      else
+
+      static bool OnBool(void* target, bool value)
       {
-        // Object
-        WriteObject(std::get<Object>(value), out, 0, options, WriteContext::InArray, false);
+        if constexpr (IsOptional<T>::value)
+        {
+          return Binder<typename T::value_type>::OnBool(&Get(target).emplace(), value);
+        }
+        else if constexpr (std::is_same_v<T, bool>)
+        {
+          Get(target) = value;
+          return true;
+        }
+        return false;
       }
-    }
-
-    inline void WriteObject(
-      const Object& object,
-      std::string& out,
-      int indentLevel,
-      const WriteOptions& options,
-      WriteContext ctx,
-      bool indentFirstLine = true)
-    {
-      auto items = OrderedObjectItems(object, options.sortObjectKeys);
 
-      // If writing an object as an array element, emit fully inline braces to avoid indent ambiguity
-      if (ctx == WriteContext::InArray)
+      static bool OnNumber(void* target, double value, std::string_view literal)
       {
-        out.push_back('{');
-        std::size_t index = 0;
-        for (const auto& [key, valuePtr] : items)
+        if constexpr (IsOptional<T>::value)
         {
-          const Value& value = *valuePtr;
-          if (index++ > 0)
-          {
-            out += ", ";
-          }
-          bool bareOK = true;
-          if (key.empty())
-          {
-            bareOK = false;
-          }
-          else
+          return Binder<typename T::value_type>::OnNumber(&Get(target).emplace(), value, literal);
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+          Get(target) = static_cast<T>(value);
+          return true;
+        }
+        else if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>)
+        {
+          // Integer literals, also with the all-zero fraction the writer adds (42.0), are read exactly (the double
+          // loses precision beyond 2^53)
+          literal.remove_prefix(!literal.empty() && literal[0] == '+');
+          const std::string_view digits = literal.substr(0, literal.find('.'));
+          const std::string_view fraction = literal.substr(digits.size());
+          const bool zeroFraction = fraction.empty() || (fraction.size() > 1 && fraction.find_first_not_of('0', 1) == std::string_view::npos);
+          T integer{};
+          auto [ptr, errorCode] = std::from_chars(digits.data(), digits.data() + digits.size(), integer);
+          if (zeroFraction && ptr == digits.data() + digits.size() && !digits.empty())
           {
-            char c0 = key[0];
-            if (!((c0 >= 'A' && c0 <= 'Z') || (c0 >= 'a' && c0 <= 'z') || c0 == '_'))
-            {
-              bareOK = false;
-            }
-            for (char c : key)
+            if (errorCode != std::errc())
             {
-              if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c == '-'))
-              {
-                bareOK = false;
-                break;
-              }
+              return false; // Out of range
             }
+            Get(target) = integer;
+            return true;
           }
-          if (bareOK)
-          {
-            out += key;
-          }
-          else
+
+          // Otherwise (1e3, 2.0) integral and in range; max / 2 + 1 doubled is the exact power of two above max
+          constexpr double lowest = static_cast<double>(std::numeric_limits<T>::lowest());
+          constexpr double limit = static_cast<double>(std::numeric_limits<T>::max() / 2 + 1) * 2.0;
+          if (value != std::trunc(value) || value < lowest || value >= limit)
           {
-            WriteStringQuoted(key, out);
+            return false;
           }
-          out += ": ";
-          WriteValueInline(value, out, options);
+          Get(target) = static_cast<T>(value);
+          return true;
         }
-        out.push_back('}');
-        return;
+        return false;
       }
 
-      // CoffeeScript-style brace-less objects elsewhere
-      const int contentIndent = indentLevel;
-
-      // Empty object
-      if (object.empty())
+      static bool OnString(void* target, std::string_view value)
       {
-        if (indentFirstLine)
+        if constexpr (IsOptional<T>::value)
         {
-          WriteIndent(out, indentLevel, options.indentWidth);
+          return Binder<typename T::value_type>::OnString(&Get(target).emplace(), value);
         }
-        out += "{}";
-        return;
+        else if constexpr (std::is_same_v<T, std::string>)
+        {
+          Get(target).assign(value);
+          return true;
+        }
+        return false;
       }
 
-      bool first = true;
-      for (const auto& [key, valuePtr] : items)
+      static BindSlot OpenArray(void* target)
       {
-        const Value& value = *valuePtr;
-        if (!first)
+        if constexpr (IsOptional<T>::value)
         {
-          out.push_back('\n');
+          return Binder<typename T::value_type>::OpenArray(&Get(target).emplace());
         }
-
-        // If caller already emitted indent for the first line, skip it once
-        if (!(first && !indentFirstLine))
+        else if constexpr (IsVector<T>::value)
         {
-          WriteIndent(out, contentIndent, options.indentWidth);
+          Get(target).clear(); // Replace default member contents
+          return {target, &kBindOps<T>};
         }
-        first = false;
+        return {};
+      }
 
-        // Key
-        bool bareOK = true;
-        if (key.empty())
-        {
-          bareOK = false;
-        }
-        else
+      static BindSlot Element(void* array)
+      {
+        if constexpr (IsVector<T>::value)
         {
-          char c0 = key[0];
-          if (!((c0 >= 'A' && c0 <= 'Z') || (c0 >= 'a' && c0 <= 'z') || c0 == '_'))
-          {
-            bareOK = false;
-          }
-          for (char c : key)
-          {
-            if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c == '-'))
-            {
-              bareOK = false;
-              break;
-            }
-          }
+          using ElementT = typename T::value_type;
+          return {&Get(array).emplace_back(), &kBindOps<ElementT>};
         }
+        return {};
+      }
 
-        if (bareOK)
+      static BindSlot OpenObject(void* target)
+      {
+        if constexpr (IsOptional<T>::value)
         {
-          out += key;
+          return Binder<typename T::value_type>::OpenObject(&Get(target).emplace());
         }
-        else
+        else if constexpr (Described<T>)
         {
-          WriteStringQuoted(key, out);
+          return {target, &kBindOps<T>};
         }
+        return {};
+      }
 
-        out += ": ";
-
-        const bool isObject = std::holds_alternative<Object>(value);
-        const bool isArray = std::holds_alternative<Array>(value);
-        const bool inlineArray = isArray && CanInlineArray(std::get<Array>(value));
-
-        if (isObject || (isArray && !inlineArray))
+      // Slot of the field named key; unknown keys and repeats of a bound field (first one wins) get a null target
+      static BindSlot Member(void* object, std::string_view key, std::uint64_t& seen)
+      {
+        if constexpr (Described<T>)
         {
-          // Block value on next line with increased indent
-          out.push_back('\n');
-          WriteValue(value, out, contentIndent + 1, options, WriteContext::InObject);
+          static_assert(kFieldCount<T> <= 32, "Described structs are limited to 32 fields (see HAVCSON_DESCRIBE)");
+          BindSlot slot;
+          FindMember(Get(object), key, seen, slot, std::make_index_sequence<kFieldCount<T>>{});
+          return slot;
         }
-        else
+        return {};
+      }
+
+      template <std::size_t... I>
+      static void FindMember(T& object, std::string_view key, std::uint64_t& seen, BindSlot& slot, std::index_sequence<I...>)
+      {
+        ((std::get<I>(kFieldsOf<T>).name == key && BindMember<I>(object, seen, slot)) || ...);
+      }
+
+      template <std::size_t I>
+      static bool BindMember(T& object, std::uint64_t& seen, BindSlot& slot)
+      {
+        using Member = typename std::remove_const_t<std::tuple_element_t<I, std::remove_const_t<decltype(kFieldsOf<T>)>>>::Member;
+        const std::uint64_t bit = std::uint64_t(1) << I;
+        if (!(seen & bit))
         {
-          // Scalars and small inline arrays stay on the same line
-          WriteValue(value, out, contentIndent, options, WriteContext::InObject);
+          seen |= bit;
+          slot = {&(object.*std::get<I>(kFieldsOf<T>).member), &kBindOps<Member>};
         }
+        return true;
       }
-    }
+    };
 
-    inline void WriteArray(const Array& array, std::string& out, int indentLevel, const WriteOptions& options, WriteContext ctx)
+    // Event handler filling a described root object through the BindOps of each nested member
+    class BindingHandler : public EventHandler
     {
-      // LOGIC:
-      //  1. If array is small and all "simple" scalars -> inline: [1, 2, 3]
-      //  2. Otherwise -> multiline:
-      //       [
-      //         1
-      //         2
-      //         foo: 1
-      //         bar: 2
-      //       ]
-      //     where objects become brace-less indent blocks
+    public:
+      explicit BindingHandler(BindSlot root) : mNext(root) {}
 
-      if (array.empty())
+      // A callback stopped the parse because a value didn't fit its member
+      bool Mismatch() const
       {
-        out += "[]";
-        return;
+        return mMismatch;
       }
 
-      bool allSimple = true;
-      for (const auto& value : array)
+      bool OnNull()
       {
-        if (!IsSimpleScalar(value))
+        return Scalar([](const BindSlot& slot) { return slot.ops->onNull(slot.target); });
+      }
+
+      bool OnBool(bool value)
+      {
+        return Scalar([value](const BindSlot& slot) { return slot.ops->onBool(slot.target, value); });
+      }
+
+      bool OnNumber(double value, std::string_view literal)
+      {
+        return Scalar([value, literal](const BindSlot& slot) { return slot.ops->onNumber(slot.target, value, literal); });
+      }
+
+      // Described roots are objects, but an empty document just leaves every member at its default
+      bool OnEmptyDocument()
+      {
+        return true;
+      }
+
+      bool OnString(std::string_view value)
+      {
+        return Scalar([value](const BindSlot& slot) { return slot.ops->onString(slot.target, value); });
+      }
+
+      bool OnArrayStart()
+      {
+        return Open(true);
+      }
+
+      bool OnObjectStart()
+      {
+        return Open(false);
+      }
+
+      bool OnKey(std::string_view key)
+      {
+        if (mSkipDepth == 0)
         {
-          allSimple = false;
-          break;
+          Frame& frame = mFrames.back();
+          mNext = frame.container.ops->member(frame.container.target, key, frame.seen);
         }
+        return true;
       }
 
-      // Inline small scalar arrays
-      if (allSimple && array.size() <= 3)
+      bool OnArrayEnd()
       {
-        out.push_back('[');
-        bool first = true;
-        for (const auto& value : array)
+        return Close();
+      }
+
+      bool OnObjectEnd()
+      {
+        return Close();
+      }
+
+    private:
+      struct Frame
+      {
+        BindSlot container;
+        std::uint64_t seen = 0; // Fields already bound (objects)
+        bool isArray = false;
+      };
+
+      std::vector<Frame> mFrames;
+      BindSlot mNext; // Slot of the next value inside objects / at the root
+      std::size_t mSkipDepth = 0; // Containers entered below a skipped member
+      bool mMismatch = false;
+
+      BindSlot TakeSlot()
+      {
+        if (!mFrames.empty() && mFrames.back().isArray)
         {
-          if (!first)
-          {
-            out += ", ";
-          }
-          first = false;
-          WriteValue(value, out, indentLevel, options, WriteContext::InArray);
+          const BindSlot& array = mFrames.back().container;
+          return array.ops->element(array.target);
         }
-        out.push_back(']');
-        return;
+        return std::exchange(mNext, BindSlot{});
       }
 
-      // Multiline array, CoffeeScript-style
-      const bool callerIndented = ctx == WriteContext::InArray;
-      if (!callerIndented)
+      template <typename Fn>
+      bool Scalar(Fn&& fill)
       {
-        WriteIndent(out, indentLevel, options.indentWidth);
+        if (mSkipDepth > 0)
+        {
+          return true;
+        }
+        const BindSlot slot = TakeSlot();
+        if (slot.target && !fill(slot))
+        {
+          mMismatch = true;
+          return false;
+        }
+        return true;
       }
-      out.push_back('[');
-      out.push_back('\n');
 
-      bool first = true;
-      for (const auto& value : array)
+      bool Open(bool isArray)
       {
-        if (!first)
+        if (mSkipDepth > 0)
         {
-          out.push_back('\n');
+          ++mSkipDepth;
+          return true;
         }
-        first = false;
-
-        // Every element begins at the array's child indent
-        WriteIndent(out, indentLevel + 1, options.indentWidth);
+        const BindSlot slot = TakeSlot();
+        if (!slot.target)
+        {
+          mSkipDepth = 1;
+          return true;
+        }
+        const BindSlot container = isArray ? slot.ops->openArray(slot.target) : slot.ops->openObject(slot.target);
+        if (!container.target)
+        {
+          mMismatch = true;
+          return false;
+        }
+        mFrames.push_back({container, 0, isArray});
+        return true;
+      }
 
-        if (std::holds_alternative<Object>(value))
+      bool Close()
+      {
+        if (mSkipDepth > 0)
         {
-          const Object& object = std::get<Object>(value);
-          // Use array-context writer (braced, comma-separated) and skip the first indent we already wrote
-          WriteObject(object, out, indentLevel + 1, options, WriteContext::InArray, false);
+          --mSkipDepth;
+          return true;
         }
-        else
+        mFrames.pop_back();
+        return true;
+      }
+    };
+
+    template <typename T, typename P>
+    ErrorCode ParseBound(P& parser, T& out, Error* error)
+    {
+      T value{};
+      BindingHandler handler({&value, &kBindOps<T>});
+      ErrorCode errorCode = parser.ParseEvents(handler, error);
+      if (errorCode == ErrorCode::Aborted && handler.Mismatch())
+      {
+        errorCode = ErrorCode::TypeMismatch;
+        if (error)
         {
-          // Scalars / nested arrays keep the usual "one per line" indent
-          WriteValue(value, out, indentLevel + 1, options, WriteContext::InArray);
+          error->code = errorCode;
+          error->message = "Value does not match the type of its bound member";
         }
       }
+      if (errorCode == ErrorCode::OK)
+      {
+        out = std::move(value);
+      }
+      return errorCode;
+    }
 
-      out.push_back('\n');
-      WriteIndent(out, indentLevel, options.indentWidth);
-      out.push_back(']');
+    // Bound counterparts of IsSimpleScalar / LayoutOf; an empty optional is written as null
+    template <typename T>
+    bool IsSimpleBound(const T& value)
+    {
+      if constexpr (IsOptional<T>::value)
+      {
+        return !value || IsSimpleBound(*value);
+      }
+      else if constexpr (std::is_same_v<T, std::string>)
+      {
+        return value.size() <= 32 && value.find('\n') == std::string::npos;
+      }
+      return !IsVector<T>::value && !Described<T>;
     }
 
-    inline void WriteValue(const Value& value, std::string& out, int indentLevel, const WriteOptions& options, WriteContext ctx)
+    template <typename T>
+    ArrayLayout BoundLayoutOf(const std::vector<T>& array)
     {
-      if (std::holds_alternative<std::nullptr_t>(value))
+      if (array.size() > 3 || !std::all_of(array.begin(), array.end(), [](const T& element) { return IsSimpleBound(element); }))
       {
-        out += "null";
+        return ArrayLayout::Block;
       }
-      else if (std::holds_alternative<bool>(value))
+      return ArrayLayout::Inline;
+    }
+
+    template <typename T>
+    bool IsPresent(const T& value)
+    {
+      if constexpr (IsOptional<T>::value)
       {
-        out += (std::get<bool>(value) ? "true" : "false");
+        return value.has_value();
       }
-      else if (std::holds_alternative<double>(value))
+      return true;
+    }
+
+    // Writers below return false at the first non-finite number, like WriteValue
+    template <typename T, typename Out>
+    bool WriteBound(const T& value, Out& out, int indentLevel, const WriteOptions& options, WriteContext ctx);
+
+    template <typename T, typename Out>
+    bool WriteBoundArray(const T& array, Out& out, int indentLevel, const WriteOptions& options, WriteContext ctx, ArrayLayout layout);
+
+    // Counterpart of WriteValueInline for members of array-context objects
+    template <typename T, typename Out>
+    bool WriteBoundInline(const T& value, Out& out, const WriteOptions& options)
+    {
+      if constexpr (IsOptional<T>::value)
       {
-        out += FormatNumber(std::get<double>(value));
+        if (!value)
+        {
+          out += "null";
+          return true;
+        }
+        return WriteBoundInline(*value, out, options);
       }
-      else if (std::holds_alternative<std::string>(value))
+      else if constexpr (std::is_same_v<T, std::string>)
       {
-        const auto& stringValue = std::get<std::string>(value);
-        if (stringValue.find('\n') != std::string::npos)
+        WriteStringQuoted(value, out);
+        return true;
+      }
+      else if constexpr (IsVector<T>::value)
+      {
+        out.push_back('[');
+        for (std::size_t index = 0; index < value.size(); ++index)
         {
-          // Multiline -> triple-quoted
-          out += "\"\"\"";
-          out += stringValue;
-          out += "\"\"\"";
+          if (index > 0)
+          {
+            out += ", ";
+          }
+          if (!WriteBoundInline(value[index], out, options))
+          {
+            return false;
+          }
         }
-        else
+        out.push_back(']');
+        return true;
+      }
+      else
+      {
+        return WriteBound(value, out, 0, options, WriteContext::InArray); // Scalars and braced objects
+      }
+    }
+
+    // Object member: objects and block arrays go on the next line. The array layout is worked out once here.
+    template <typename T, typename Out>
+    bool WriteBoundMember(const T& member, Out& out, int indentLevel, const WriteOptions& options)
+    {
+      if constexpr (IsOptional<T>::value)
+      {
+        return WriteBoundMember(*member, out, indentLevel, options); // Callers skip empty optionals
+      }
+      else if constexpr (IsVector<T>::value)
+      {
+        const ArrayLayout layout = BoundLayoutOf(member);
+        if (layout == ArrayLayout::Block)
         {
-          WriteStringQuoted(stringValue, out);
+          out.push_back('\n');
+          return WriteBoundArray(member, out, indentLevel + 1, options, WriteContext::InObject, layout);
         }
+        return WriteBoundArray(member, out, indentLevel, options, WriteContext::InObject, layout);
       }
-      else if (std::holds_alternative<Array>(value))
+      else if constexpr (Described<T>)
       {
-        // Array
-        WriteArray(std::get<Array>(value), out, indentLevel, options, ctx);
+        out.push_back('\n');
+        return WriteBound(member, out, indentLevel + 1, options, WriteContext::InObject);
       }
       else
       {
-        // Object
-        WriteObject(std::get<Object>(value), out, indentLevel, options, ctx);
+        return WriteBound(member, out, indentLevel, options, WriteContext::InObject);
       }
     }
 
-  } // namespace detail
-
-  inline bool ToString(const Value& value, std::string& out, const WriteOptions& options = {}, Error* error = nullptr)
-  {
-    if (!detail::ValidateFiniteNumbers(value, error))
-    {
-      return false;
-    }
-    out.clear();
-    detail::WriteValue(value, out, 0, options, detail::WriteContext::Root);
-    if (error)
+    template <typename T, typename Out>
+    bool WriteBoundObject(const T& object, Out& out, int indentLevel, const WriteOptions& options, WriteContext ctx, bool indentFirstLine = true)
     {
-      *error = {};
-    }
-    return true;
-  }
+      // Same layout as WriteObject; empty optionals are left out
+      bool ok = true;
+      if (ctx == WriteContext::InArray)
+      {
+        out.push_back('{');
+        std::size_t index = 0;
+        ForEachField(object, options.sortObjectKeys, [&](std::string_view key, const auto& member) {
+          if (ok && IsPresent(member))
+          {
+            if (index++ > 0)
+            {
+              out += ", ";
+            }
+            WriteKey(key, out);
+            ok = WriteBoundInline(member, out, options);
+          }
+        });
+        out.push_back('}');
+        return ok;
+      }
 
-  inline std::string ToString(const Value& value, const WriteOptions& options = {})
-  {
-    std::string result;
-    Error error;
-    if (!ToString(value, result, options, &error))
-    {
-      return {};
+      bool empty = true;
+      ForEachField(object, false, [&](std::string_view, const auto& member) { empty = empty && !IsPresent(member); });
+      if (empty)
+      {
+        if (indentFirstLine)
+        {
+          WriteIndent(out, indentLevel, options.indentWidth);
+        }
+        out += "{}";
+        return true;
+      }
+
+      bool first = true;
+      ForEachField(object, options.sortObjectKeys, [&](std::string_view key, const auto& member) {
+        if (!ok || !IsPresent(member))
+        {
+          return;
+        }
+        if (!first)
+        {
+          out.push_back('\n');
+        }
+        if (!(first && !indentFirstLine))
+        {
+          WriteIndent(out, indentLevel, options.indentWidth);
+        }
+        first = false;
+
+        WriteKey(key, out);
+        ok = WriteBoundMember(member, out, indentLevel, options);
+      });
+      return ok;
     }
-    return result;
-  }
 
-  namespace detail
-  {
-    inline void WriteCommentLines(const std::vector<LosslessComment>& lines, std::string& out, const WriteOptions& options)
+    template <typename T, typename Out>
+    bool WriteBoundArray(const T& array, Out& out, int indentLevel, const WriteOptions& options, WriteContext ctx, ArrayLayout layout)
     {
-      bool prevNonEmpty = false;
-      for (const auto& line : lines)
+      // Same layout as WriteArray
+      if (array.empty())
       {
-        if (prevNonEmpty && !line.text.empty())
+        out += "[]";
+        return true;
+      }
+
+      if (layout == ArrayLayout::Inline)
+      {
+        out.push_back('[');
+        for (std::size_t index = 0; index < array.size(); ++index)
         {
-          out.push_back('\n');
+          if (index > 0)
+          {
+            out += ", ";
+          }
+          if (!WriteBound(array[index], out, indentLevel, options, WriteContext::InArray))
+          {
+            return false;
+          }
         }
-        if (line.text.empty())
+        out.push_back(']');
+        return true;
+      }
+
+      if (ctx != WriteContext::InArray)
+      {
+        WriteIndent(out, indentLevel, options.indentWidth);
+      }
+      out += "[\n";
+      for (std::size_t index = 0; index < array.size(); ++index)
+      {
+        if (index > 0)
         {
           out.push_back('\n');
-          prevNonEmpty = false;
         }
-        else
+        WriteIndent(out, indentLevel + 1, options.indentWidth);
+        if (!WriteBound(array[index], out, indentLevel + 1, options, WriteContext::InArray))
         {
-          WriteIndent(out, line.indent, 1); // Indent is absolute columns
-          out.append(line.text);
-          out.push_back('\n');
-          prevNonEmpty = true;
+          return false;
         }
       }
+      out.push_back('\n');
+      WriteIndent(out, indentLevel, options.indentWidth);
+      out.push_back(']');
+      return true;
     }
 
-    inline void
-    WriteLosslessValue(const LosslessValue& value, std::string& out, int indentLevel, const WriteOptions& options, WriteContext ctx)
+    template <typename T, typename Out>
+    bool WriteBound(const T& value, Out& out, int indentLevel, const WriteOptions& options, WriteContext ctx)
     {
-      WriteCommentLines(value.leadingComments, out, options);
-
-      auto trimTrailingSpaces = [](std::string& value) {
-        while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+      if constexpr (IsOptional<T>::value)
+      {
+        if (!value)
         {
-          value.pop_back();
+          out += "null";
+          return true;
         }
-      };
-
-      auto writeInlineComment = [&](const std::string& value) {
-        if (!value.empty())
+        return WriteBound(*value, out, indentLevel, options, ctx);
+      }
+      else if constexpr (std::is_same_v<T, bool>)
+      {
+        out += value ? "true" : "false";
+        return true;
+      }
+      else if constexpr (std::is_integral_v<T>)
+      {
+        // Digits of T itself (a double rounds beyond 2^53), with the ".0" suffix AppendNumber gives integral values
+        char buffer[24];
+        const char* end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+        out.append(buffer, static_cast<std::size_t>(end - buffer));
+        if (!options.compactIntegers)
         {
-          out.append(" #");
-          out.append(value);
+          out += ".0";
         }
-      };
-
-      if (std::holds_alternative<Array>(value.value) && !value.arrayItems.empty())
+        return true;
+      }
+      else if constexpr (std::is_floating_point_v<T>)
       {
-        WriteIndent(out, indentLevel, options.indentWidth);
-        out.append("[\n");
-        for (std::size_t index = 0; index < value.arrayItems.size(); ++index)
+        if (!std::isfinite(value))
         {
-          const LosslessValue& child = value.arrayItems[index];
-          WriteLosslessValue(child, out, indentLevel + 1, options, WriteContext::InArray);
-          if (index + 1 < value.arrayItems.size())
-          {
-            out.push_back('\n');
-          }
+          return false;
         }
-        out.push_back('\n');
-        WriteIndent(out, indentLevel, options.indentWidth);
-        out.push_back(']');
-        return;
+        AppendNumber(static_cast<double>(value), out, options.compactIntegers);
+        return true;
       }
-
-      if (std::holds_alternative<Object>(value.value) && !value.objectItems.empty())
+      else if constexpr (std::is_same_v<T, std::string>)
       {
-        auto items = OrderedLosslessItems(value.objectItems, options.sortObjectKeys);
-        // Use braces only in array context, otherwise use indent-style
-        if (ctx == WriteContext::InArray)
+        if (value.find('\n') != std::string::npos)
         {
-          // Inline braced format for objects in arrays
-          out.append("{\n");
-          for (std::size_t index = 0; index < items.size(); ++index)
-          {
-            const auto& [key, childPtr] = items[index];
-            const LosslessValue& child = *childPtr;
-            WriteCommentLines(child.leadingComments, out, options);
-            WriteIndent(out, indentLevel + 1, options.indentWidth);
-            out.append(key);
-            out.append(": ");
-            WriteValue(child.value, out, indentLevel + 1, options, WriteContext::InObject);
-            writeInlineComment(child.inlineComment);
-            if (index + 1 < items.size())
-            {
-              out.push_back('\n');
-            }
-          }
-          out.push_back('\n');
-          WriteIndent(out, indentLevel, options.indentWidth);
-          out.push_back('}');
+          out += "\"\"\"";
+          out += value;
+          out += "\"\"\"";
         }
         else
         {
-          // Indent-style format for regular objects
-          for (std::size_t index = 0; index < items.size(); ++index)
-          {
-            const auto& [key, childPtr] = items[index];
-            const LosslessValue& child = *childPtr;
-
-            // Write leading comments for this key (includes blanks)
-            WriteCommentLines(child.leadingComments, out, options);
-
-            WriteIndent(out, indentLevel, options.indentWidth);
-            out.append(key);
-            out.append(":");
-
-            // Determine if value should be on next line
-            bool isObject = std::holds_alternative<Object>(child.value);
-            bool isArray = std::holds_alternative<Array>(child.value);
-
-            if (isObject || isArray)
-            {
-              out.push_back('\n');
-              // For nested objects / arrays, don't write their leading comments again (they were already written above
-              // as comments for this key)
-              std::vector<LosslessComment> savedComments = child.leadingComments;
-              const_cast<LosslessValue&>(child).leadingComments.clear();
-              WriteLosslessValue(child, out, indentLevel + 1, options, WriteContext::InObject);
-              const_cast<LosslessValue&>(child).leadingComments = std::move(savedComments);
-            }
-            else
-            {
-              out.push_back(' ');
-              WriteValue(child.value, out, indentLevel, options, WriteContext::InObject);
-            }
-
-            // Trim trailing spaces from inline comments
-            std::string comment = child.inlineComment;
-            trimTrailingSpaces(comment);
-            writeInlineComment(comment);
-
-            if (index + 1 < items.size())
-            {
-              out.push_back('\n');
-            }
-          }
+          WriteStringQuoted(value, out);
         }
-        return;
+        return true;
+      }
+      else if constexpr (IsVector<T>::value)
+      {
+        return WriteBoundArray(value, out, indentLevel, options, ctx, BoundLayoutOf(value));
+      }
+      else
+      {
+        return WriteBoundObject(value, out, indentLevel, options, ctx);
       }
+    }
 
-      WriteIndent(out, indentLevel, options.indentWidth);
-      WriteValue(value.value, out, indentLevel, options, ctx);
-      writeInlineComment(value.inlineComment);
+    template <typename T>
+    ErrorCode ParseBound(std::string_view src, std::string_view filename, T& out, const ParseOptions& options, Error* error)
+    {
+      if (options.trustedInput)
+      {
+        BasicParser<false> p(src, filename, options);
+        return ParseBound(p, out, error);
+      }
+      Parser p(src, filename, options);
+      return ParseBound(p, out, error);
     }
   } // namespace detail
 
-  inline bool ToStringLossless(const LosslessValue& value, std::string& out, const WriteOptions& options = {}, Error* error = nullptr)
+  // Parse src straight into a described struct: unknown keys are skipped, missing ones keep their default (all of them
+  // for an empty document), and a value of the wrong type (or a number that doesn't fit an integral member) fails with
+  // ErrorCode::TypeMismatch. out is only assigned on success.
+  template <Described T>
+  ErrorCode Parse(std::string_view src, T& out, const ParseOptions& options, Error* error = nullptr)
+  {
+    return detail::ParseBound(src, {}, out, options, error);
+  }
+
+  template <Described T>
+  ErrorCode Parse(std::string_view src, T& out, Error* error = nullptr)
   {
-    if (!detail::ValidateFiniteNumbers(value, error))
+    return Parse(src, out, ParseOptions{}, error);
+  }
+
+  template <Described T>
+  ErrorCode ParseFile(const std::string& path, T& out, const ParseOptions& options, Error* error = nullptr)
+  {
+    std::optional<MappedFileUTF8> mapping;
+    std::string buffer;
+    std::string_view contents;
+    ErrorCode errorCode = detail::LoadFileUTF8(path, mapping, buffer, contents, error);
+    if (errorCode != ErrorCode::OK)
     {
-      return false;
+      return errorCode;
     }
+    return detail::ParseBound(contents, path, out, options, error);
+  }
+
+  template <Described T>
+  ErrorCode ParseFile(const std::string& path, T& out, Error* error = nullptr)
+  {
+    return ParseFile(path, out, ParseOptions{}, error);
+  }
+
+  // Write a described struct with the same layout ToString(Value) gives the equivalent object
+  template <Described T>
+  bool ToString(const T& value, std::string& out, const WriteOptions& options = {}, Error* error = nullptr)
+  {
     out.clear();
-    detail::WriteLosslessValue(value, out, 0, options, detail::WriteContext::Root);
+    if (!detail::WriteBound(value, out, 0, options, detail::WriteContext::Root))
+    {
+      out.clear();
+      return detail::FailNonFinite(error);
+    }
     if (error)
     {
       *error = {};
@@ -3281,196 +10507,97 @@ namespace havCSON
     return true;
   }
 
-  inline std::string ToStringLossless(const LosslessValue& value, const WriteOptions& options = {})
+  template <Described T>
+  std::string ToString(const T& value, const WriteOptions& options = {})
   {
     std::string result;
     Error error;
-    if (!ToStringLossless(value, result, options, &error))
+    if (!ToString(value, result, options, &error))
     {
       return {};
     }
     return result;
   }
 
-  inline bool WriteFile(const std::string& path, const Value& value, const WriteOptions& options = {}, Error* error = nullptr)
+  template <Described T>
+  bool Write(const T& value, Sink& sink, const WriteOptions& options = {}, Error* error = nullptr)
   {
-    auto fileStream = OpenFileUTF8(path, "wb");
-    if (!fileStream)
-    {
-      if (error)
-      {
-        error->code = ErrorCode::InternalError;
-        error->where = {};
-        error->message = "Failed to open file for writing";
-      }
-      return false;
-    }
-    std::string stringValue;
-    if (!ToString(value, stringValue, options, error))
+    if (!detail::WriteBound(value, sink, 0, options, detail::WriteContext::Root))
     {
-      return false;
-    }
-    if (!stringValue.empty())
-    {
-      if (std::fwrite(stringValue.data(), 1, stringValue.size(), fileStream.get()) != stringValue.size())
-      {
-        if (error)
-        {
-          error->code = ErrorCode::InternalError;
-          error->where = {};
-          error->message = "Failed to write file";
-        }
-        return false;
-      }
-    }
-    if (error)
-    {
-      *error = {};
+      return detail::FailNonFinite(error);
     }
-    return true;
-  }
-
-  inline bool
-  WriteFileLossless(const std::string& path, const LosslessValue& value, const WriteOptions& options = {}, Error* error = nullptr)
-  {
-    auto fileStream = OpenFileUTF8(path, "wb");
-    if (!fileStream)
+    if (!sink.Flush())
     {
       if (error)
       {
         error->code = ErrorCode::InternalError;
         error->where = {};
-        error->message = "Failed to open file for writing";
+        error->message = "Failed to write output";
       }
       return false;
     }
-    std::string stringValue;
-    if (!ToStringLossless(value, stringValue, options, error))
-    {
-      return false;
-    }
-    if (!stringValue.empty())
-    {
-      if (std::fwrite(stringValue.data(), 1, stringValue.size(), fileStream.get()) != stringValue.size())
-      {
-        if (error)
-        {
-          error->code = ErrorCode::InternalError;
-          error->where = {};
-          error->message = "Failed to write file";
-        }
-        return false;
-      }
-    }
     if (error)
     {
       *error = {};
     }
     return true;
   }
+}
 
-  // Simple JSON writer without pretty-printing
-  inline bool ToJsonString(const Value& value, std::string& out, Error* error = nullptr)
-  {
-    if (!detail::ValidateFiniteNumbers(value, error))
-    {
-      return false;
-    }
-    out.clear();
-
-    // JSON writer
-    struct Writer
-    {
-      static void JsonString(const std::string& value, std::string& out)
-      {
-        out.push_back('"');
-        for (char c : value)
-        {
-          switch (c)
-          {
-            case '"': out += "\\\""; break;
-            case '\\': out += "\\\\"; break;
-            case '\n': out += "\\n"; break;
-            case '\r': out += "\\r"; break;
-            case '\t': out += "\\t"; break;
-            default: out.push_back(c); break;
-          }
-        }
-        out.push_back('"');
-      }
-
-      static void Write(const Value& value, std::string& out)
-      {
-        if (std::holds_alternative<std::nullptr_t>(value))
-        {
-          out += "null";
-        }
-        else if (std::holds_alternative<bool>(value))
-        {
-          out += (std::get<bool>(value) ? "true" : "false");
-        }
-        else if (std::holds_alternative<double>(value))
-        {
-          out += detail::FormatNumber(std::get<double>(value));
-        }
-        else if (std::holds_alternative<std::string>(value))
-        {
-          JsonString(std::get<std::string>(value), out);
-        }
-        else if (std::holds_alternative<Array>(value))
-        {
-          out.push_back('[');
-          bool first = true;
-          for (auto& e : std::get<Array>(value))
-          {
-            if (!first)
-            {
-              out.push_back(',');
-            }
-            first = false;
-            Write(e, out);
-          }
-          out.push_back(']');
-        }
-        else
-        {
-          const Object& object = std::get<Object>(value);
-          out.push_back('{');
-          bool first = true;
-          for (auto& [key, value] : object)
-          {
-            if (!first)
-            {
-              out.push_back(',');
-            }
-            first = false;
-            JsonString(key, out);
-            out.push_back(':');
-            Write(value, out);
-          }
-          out.push_back('}');
-        }
-      }
-    };
-
-    Writer::Write(value, out);
-    if (error)
-    {
-      *error = {};
-    }
-    return true;
+// Describe the members of a struct for struct binding (Parse / ParseFile / ToString / Write), at namespace scope in the
+// namespace of the struct. Keys are the member names; up to 32 members.
+//
+//   struct Server { std::string host; int port = 80; std::optional<std::vector<std::string>> tags; };
+//   HAVCSON_DESCRIBE(Server, host, port, tags)
+#define HAVCSON_DESCRIBE(Type, ...) \
+  inline constexpr auto HavCSONFields(const Type*) \
+  { \
+    return std::make_tuple( \
+      HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_CAT(HAVCSON_DETAIL_LIST_, HAVCSON_DETAIL_COUNT(__VA_ARGS__))(Type, __VA_ARGS__))); \
   }
 
-  inline std::string ToJsonString(const Value& value)
-  {
-    std::string result;
-    Error error;
-    if (!ToJsonString(value, result, &error))
-    {
-      return {};
-    }
-    return result;
-  }
-}
+#define HAVCSON_DETAIL_EXPAND(...) __VA_ARGS__
+#define HAVCSON_DETAIL_CAT_(a, b) a##b
+#define HAVCSON_DETAIL_CAT(a, b) HAVCSON_DETAIL_CAT_(a, b)
+#define HAVCSON_DETAIL_COUNT(...) \
+  HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_COUNT_( \
+    __VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1))
+#define HAVCSON_DETAIL_COUNT_( \
+  _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, \
+  _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...) \
+  N
+#define HAVCSON_DETAIL_ONE(Type, name) ::havCSON::detail::MakeField(#name, &Type::name)
+#define HAVCSON_DETAIL_LIST_1(Type, name) HAVCSON_DETAIL_ONE(Type, name)
+#define HAVCSON_DETAIL_LIST_2(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_1(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_3(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_2(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_4(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_3(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_5(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_4(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_6(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_5(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_7(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_6(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_8(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_7(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_9(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_8(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_10(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_9(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_11(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_10(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_12(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_11(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_13(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_12(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_14(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_13(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_15(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_14(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_16(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_15(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_17(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_16(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_18(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_17(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_19(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_18(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_20(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_19(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_21(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_20(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_22(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_21(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_23(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_22(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_24(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_23(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_25(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_24(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_26(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_25(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_27(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_26(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_28(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_27(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_29(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_28(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_30(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_29(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_31(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_30(Type, __VA_ARGS__))
+#define HAVCSON_DETAIL_LIST_32(Type, name, ...) HAVCSON_DETAIL_ONE(Type, name), HAVCSON_DETAIL_EXPAND(HAVCSON_DETAIL_LIST_31(Type, __VA_ARGS__))
 
 #endif
@@ -0,0 +1,174 @@
+// Standalone regression tests for havCSON. No dependencies besides the header:
+//
+//   g++ -std=c++23 -O2 -I .. havCSON_tests.cpp -o havCSON_tests
+//   ./havCSON_tests [filter]
+//
+// Every test runs unless a filter is given (then only those whose name contains it). A failed check prints its line
+// and expression; the exit code is 1 if any check failed.
+
+#include "havCSON.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <string>
+
+namespace bound
+{
+  struct Integers
+  {
+    std::int64_t lowest = 0;
+    std::int64_t highest = 0;
+    std::uint64_t unsignedHighest = 0;
+    std::int64_t aboveDouble = 0;
+  };
+  HAVCSON_DESCRIBE(Integers, lowest, highest, unsignedHighest, aboveDouble)
+} // namespace bound
+
+namespace
+{
+  int gFailures = 0;
+
+  void Check(bool condition, const char* expression, int line)
+  {
+    if (!condition)
+    {
+      std::fprintf(stderr, "havCSON_tests.cpp:%d: check failed: %s\n", line, expression);
+      ++gFailures;
+    }
+  }
+
+#define CHECK(expression) Check(static_cast<bool>(expression), #expression, __LINE__)
+
+  // Wall-clock milliseconds the body takes
+  template <typename Body>
+  double Milliseconds(Body&& body)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    body();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  // Trusted input must not cost more than validated input: the skip pass reports every literal's position, which
+  // has to stay linear in the document size
+  void LazyTrustedInputScales()
+  {
+    using namespace havCSON;
+
+    std::string source;
+    for (int index = 0; index < 100000; ++index)
+    {
+      source += "member_" + std::to_string(index) + ": \"value\"\n";
+    }
+    ParseOptions trusted;
+    trusted.trustedInput = true;
+
+    LazyDocument checked;
+    LazyDocument skipped;
+    ErrorCode checkedCode = ErrorCode::InternalError;
+    ErrorCode skippedCode = ErrorCode::InternalError;
+    const double checkedMs = Milliseconds([&] { checkedCode = checked.Parse(source); });
+    const double skippedMs = Milliseconds([&] { skippedCode = skipped.Parse(source, trusted); });
+    CHECK(checkedCode == ErrorCode::OK);
+    CHECK(skippedCode == ErrorCode::OK);
+    CHECK(skippedMs < checkedMs * 10.0 + 100.0);
+
+    Value last;
+    CHECK(skipped.Get("member_99999", last) == ErrorCode::OK && last.isString());
+
+    // Positions of a late error agree between both modes
+    const std::string broken = source + "tail: [1,\n  2,\n  @]\n";
+    Error checkedError;
+    Error skippedError;
+    CHECK(checked.Parse(broken, &checkedError) == ErrorCode::UnexpectedChar);
+    CHECK(skipped.Parse(broken, trusted, &skippedError) == ErrorCode::UnexpectedChar);
+    CHECK(checkedError.where.line == 100003 && checkedError.where.column == 3);
+    CHECK(skippedError.where.line == checkedError.where.line && skippedError.where.column == checkedError.where.column);
+  }
+
+  // 64-bit members write their exact digits and read back unchanged, with and without the ".0" suffix
+  void BoundIntegersRoundTrip()
+  {
+    using namespace havCSON;
+
+    bound::Integers written;
+    written.lowest = std::numeric_limits<std::int64_t>::min();
+    written.highest = std::numeric_limits<std::int64_t>::max();
+    written.unsignedHighest = std::numeric_limits<std::uint64_t>::max();
+    written.aboveDouble = (std::int64_t{1} << 53) + 1;
+
+    for (bool compactIntegers : {false, true})
+    {
+      WriteOptions options;
+      options.compactIntegers = compactIntegers;
+      std::string text;
+      CHECK(ToString(written, text, options));
+      CHECK(text.find("aboveDouble: 9007199254740993") != std::string::npos);
+      CHECK(text.find("unsignedHighest: 18446744073709551615") != std::string::npos);
+      CHECK((text.find(".0") == std::string::npos) == compactIntegers);
+
+      bound::Integers read;
+      CHECK(Parse(text, read) == ErrorCode::OK);
+      CHECK(read.lowest == written.lowest);
+      CHECK(read.highest == written.highest);
+      CHECK(read.unsignedHighest == written.unsignedHighest);
+      CHECK(read.aboveDouble == written.aboveDouble);
+    }
+  }
+
+  // keepSourceText writes a leading BOM back, whether the document is copied whole, spliced or rebuilt
+  void LosslessKeepsBOM()
+  {
+    using namespace havCSON;
+
+    const std::string source = "\xEF\xBB\xBF# settings\nname: \"demo\"\nlimits: [1, 2]\n";
+    LosslessValue document;
+    CHECK(ParseLossless(source, document) == ErrorCode::OK);
+
+    WriteOptions keep;
+    keep.keepSourceText = true;
+    CHECK(ToStringLossless(document, keep) == source);
+    CHECK(!ToStringLossless(document).starts_with("\xEF\xBB\xBF"));
+
+    document.at("name").value = Value("edited");
+    const std::string spliced = ToStringLossless(document, keep);
+    CHECK(spliced.starts_with("\xEF\xBB\xBF# settings\n"));
+    CHECK(spliced.find("\"edited\"") != std::string::npos);
+
+    LosslessValue added;
+    added.value = Value(true);
+    document.objectItems.emplace_back("added", added);
+    document.MarkDirty();
+    const std::string rebuilt = ToStringLossless(document, keep);
+    CHECK(rebuilt.starts_with("\xEF\xBB\xBF"));
+    CHECK(rebuilt.find("added: true") != std::string::npos);
+  }
+} // namespace
+
+int main(int argc, char** argv)
+{
+  const std::string filter = argc > 1 ? argv[1] : "";
+
+  struct Test
+  {
+    const char* name;
+    void (*run)();
+  };
+  const Test tests[] = {
+    {"lazy-trusted-input-scales", LazyTrustedInputScales},
+    {"bound-integers-round-trip", BoundIntegersRoundTrip},
+    {"lossless-keeps-bom", LosslessKeepsBOM},
+  };
+
+  for (const Test& test : tests)
+  {
+    if (filter.empty() || std::string(test.name).find(filter) != std::string::npos)
+    {
+      const int failures = gFailures;
+      test.run();
+      std::printf("%-32s %s\n", test.name, gFailures == failures ? "ok" : "FAILED");
+    }
+  }
+  return gFailures == 0 ? 0 : 1;
+}